@@ -20,7 +20,9 @@
 #include "esp_timer.h"
 #include "esp_tls_crypto.h"
 #include "esp_system.h"
+#include "esp_random.h"
 #include <errno.h>
+#include <limits.h>
 #include <arpa/inet.h>
 
 static const char *TAG = "websocket_client";
@@ -75,6 +77,7 @@ typedef struct {
     const char                 *task_name;
     int                         task_stack;
     int                         task_prio;
+    BaseType_t                  task_core;
     char                        *uri;
     char                        *host;
     char                        *path;
@@ -123,6 +126,7 @@ struct esp_websocket_client {
     esp_websocket_error_codes_t error_handle;
     esp_transport_list_handle_t transport_list;
     esp_transport_handle_t      transport;
+    esp_transport_handle_t      raw_transport;  /*!< TCP/SSL transport below `transport`, NULL for ext_transport */
     websocket_config_storage_t *config;
     websocket_client_state_t    state;
     uint64_t                    keepalive_tick_ms;
@@ -319,6 +323,7 @@ static esp_err_t esp_websocket_client_set_config(esp_websocket_client_handle_t c
     }
 
     cfg->task_name = config->task_name;
+    cfg->task_core = config->task_pinned ? config->task_core : tskNO_AFFINITY;
 
     cfg->task_stack = config->task_stack;
     if (cfg->task_stack == 0) {
@@ -503,6 +508,7 @@ static esp_err_t esp_websocket_client_create_transport(esp_websocket_client_hand
     if (client->transport_list) {
         esp_transport_list_destroy(client->transport_list);
         client->transport_list = NULL;
+        client->raw_transport = NULL;
     }
 
     client->transport_list = esp_transport_list_init();
@@ -678,6 +684,144 @@ unlock_and_return:
     return ret;
 }
 
+static int esp_websocket_write_all(esp_transport_handle_t t, const char *data, int len, int timeout_ms)
+{
+    int widx = 0;
+    while (widx < len) {
+        int wlen = esp_transport_write(t, data + widx, len - widx, timeout_ms);
+        if (wlen <= 0) {
+            return wlen < 0 ? wlen : -1;
+        }
+        widx += wlen;
+    }
+    return widx;
+}
+
+/* Without access to the TCP/SSL transport, send the blocks as a fragmented message */
+static int esp_websocket_client_send_iov_fragmented(esp_websocket_client_handle_t client, const esp_websocket_iov_t *iov, int iovcnt, int timeout_ms)
+{
+    int total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        ws_transport_opcodes_t opcode = (i == 0) ? WS_TRANSPORT_OPCODES_BINARY : WS_TRANSPORT_OPCODES_CONT;
+        if (i == iovcnt - 1) {
+            opcode |= WS_TRANSPORT_OPCODES_FIN;
+        }
+        int wlen = esp_transport_ws_send_raw(client->transport, opcode, (char *)iov[i].data, iov[i].len, timeout_ms);
+        if (wlen < 0 || (wlen == 0 && iov[i].len != 0)) {
+            return wlen < 0 ? wlen : -1;
+        }
+        total += wlen;
+    }
+    return total;
+}
+
+int esp_websocket_client_send_bin_iov(esp_websocket_client_handle_t client, const esp_websocket_iov_t *iov, int iovcnt, TickType_t timeout)
+{
+    int ret = -1;
+    size_t len = 0;
+
+    if (client == NULL || iov == NULL || iovcnt <= 0) {
+        ESP_LOGE(TAG, "Invalid arguments");
+        return -1;
+    }
+    for (int i = 0; i < iovcnt; i++) {
+        if (iov[i].data == NULL && iov[i].len > 0) {
+            ESP_LOGE(TAG, "Invalid arguments");
+            return -1;
+        }
+        len += iov[i].len;
+    }
+    if (len > INT_MAX) {
+        ESP_LOGE(TAG, "Invalid arguments");
+        return -1;
+    }
+
+    if (!esp_websocket_client_is_connected(client)) {
+        ESP_LOGE(TAG, "Websocket client is not connected");
+        return -1;
+    }
+
+    if (client->transport == NULL) {
+        ESP_LOGE(TAG, "Invalid transport");
+        return -1;
+    }
+
+#ifdef CONFIG_ESP_WS_CLIENT_SEPARATE_TX_LOCK
+    if (xSemaphoreTakeRecursive(client->tx_lock, timeout) != pdPASS) {
+        ESP_LOGE(TAG, "Could not lock ws-client within %" PRIu32 " timeout", timeout);
+        return -1;
+    }
+#else
+    if (xSemaphoreTakeRecursive(client->lock, timeout) != pdPASS) {
+        ESP_LOGE(TAG, "Could not lock ws-client within %" PRIu32 " timeout", timeout);
+        return -1;
+    }
+#endif
+
+    int timeout_ms = (timeout == portMAX_DELAY) ? -1 : timeout * portTICK_PERIOD_MS;
+    int wlen;
+
+    if (client->raw_transport == NULL) {
+        wlen = esp_websocket_client_send_iov_fragmented(client, iov, iovcnt, timeout_ms);
+    } else {
+        // RFC 6455 5.2: FIN + opcode, MASK + payload length (7, 7+16 or 7+64 bits), masking key
+        uint8_t header[14];
+        int header_len = 0;
+        uint32_t key = esp_random();
+        uint8_t *mask;
+
+        header[header_len++] = WS_TRANSPORT_OPCODES_FIN | WS_TRANSPORT_OPCODES_BINARY;
+        if (len <= 125) {
+            header[header_len++] = 0x80 | (uint8_t)len;
+        } else if (len <= 0xFFFF) {
+            header[header_len++] = 0x80 | 126;
+            header[header_len++] = (uint8_t)(len >> 8);
+            header[header_len++] = (uint8_t)len;
+        } else {
+            header[header_len++] = 0x80 | 127;
+            for (int i = 7; i >= 0; i--) {
+                header[header_len++] = (uint8_t)((uint64_t)len >> (8 * i));
+            }
+        }
+        mask = &header[header_len];
+        memcpy(mask, &key, sizeof(key));
+        header_len += sizeof(key);
+
+        wlen = esp_websocket_write_all(client->raw_transport, (const char *)header, header_len, timeout_ms);
+        size_t offset = 0;
+        for (int i = 0; i < iovcnt && wlen >= 0; i++) {
+            esp_websocket_mask(iov[i].data, iov[i].len, mask, offset);
+            offset += iov[i].len;
+            wlen = esp_websocket_write_all(client->raw_transport, iov[i].data, iov[i].len, timeout_ms);
+        }
+        if (wlen >= 0) {
+            wlen = (int)len;
+        }
+    }
+
+    if (wlen < 0) {
+        ret = wlen;
+        esp_tls_error_handle_t error_handle = esp_transport_get_error_handle(client->transport);
+        if (error_handle) {
+            esp_websocket_client_error(client, "esp_transport_write() returned %d, transport_error=%s, tls_error_code=%i, tls_flags=%i, errno=%d",
+                                       ret, esp_err_to_name(error_handle->last_error), error_handle->esp_tls_error_code,
+                                       error_handle->esp_tls_flags, errno);
+        } else {
+            esp_websocket_client_error(client, "esp_transport_write() returned %d, errno=%d", ret, errno);
+        }
+        esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT);
+    } else {
+        ret = wlen;
+    }
+
+#ifdef CONFIG_ESP_WS_CLIENT_SEPARATE_TX_LOCK
+    xSemaphoreGiveRecursive(client->tx_lock);
+#else
+    xSemaphoreGiveRecursive(client->lock);
+#endif
+    return ret;
+}
+
 esp_websocket_client_handle_t esp_websocket_client_init(const esp_websocket_client_config_t *config)
 {
     esp_websocket_client_handle_t client = calloc(1, sizeof(struct esp_websocket_client));
@@ -1025,6 +1169,8 @@ static void esp_websocket_client_task(void *pv)
     //get transport by scheme
     if (client->transport == NULL && client->config->ext_transport == NULL) {
         client->transport = esp_transport_list_get_transport(client->transport_list, client->config->scheme);
+        client->raw_transport = esp_transport_list_get_transport(client->transport_list,
+                                strcasecmp(client->config->scheme, WS_OVER_TLS_SCHEME) == 0 ? "_ssl" : "_tcp");
     }
 
     if (client->transport == NULL) {
@@ -1228,8 +1374,9 @@ esp_err_t esp_websocket_client_start(esp_websocket_client_handle_t client)
         }
     }
 
-    if (xTaskCreate(esp_websocket_client_task, client->config->task_name ? client->config->task_name : "websocket_task",
-                    client->config->task_stack, client, client->config->task_prio, &client->task_handle) != pdTRUE) {
+    if (xTaskCreatePinnedToCore(esp_websocket_client_task, client->config->task_name ? client->config->task_name : "websocket_task",
+                                client->config->task_stack, client, client->config->task_prio, &client->task_handle,
+                                client->config->task_core) != pdTRUE) {
         ESP_LOGE(TAG, "Error create websocket task");
         return ESP_FAIL;
     }
@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: 2015-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Kept apart from esp_websocket_client.c so it builds without the transport stack (host tests)
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_websocket_client.h"
+
+void esp_websocket_mask(uint8_t *data, size_t len, const uint8_t mask[4], size_t offset)
+{
+    size_t i = 0;
+
+    // Bytes up to the first word boundary
+    while (i < len && ((uintptr_t)(data + i) & 3)) {
+        data[i] ^= mask[(offset + i) & 3];
+        i++;
+    }
+
+    // Key rotated to the phase of the first aligned byte; memory order, so endianness does not matter
+    uint8_t rotated[4];
+    for (int j = 0; j < 4; j++) {
+        rotated[j] = mask[(offset + i + j) & 3];
+    }
+    uint32_t key;
+    memcpy(&key, rotated, sizeof(key));
+
+    uint32_t *word = (uint32_t *)(data + i);
+    size_t words = (len - i) / 4;
+    size_t w = 0;
+    for (; w + 4 <= words; w += 4) {
+        word[w] ^= key;
+        word[w + 1] ^= key;
+        word[w + 2] ^= key;
+        word[w + 3] ^= key;
+    }
+    for (; w < words; w++) {
+        word[w] ^= key;
+    }
+    i += words * 4;
+
+    // Tail
+    for (; i < len; i++) {
+        data[i] ^= mask[(offset + i) & 3];
+    }
+}
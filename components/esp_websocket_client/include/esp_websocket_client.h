@@ -107,6 +107,8 @@ typedef struct {
     int                         task_prio;                  /*!< Websocket task priority */
     const char                 *task_name;                  /*!< Websocket task name */
     int                         task_stack;                 /*!< Websocket task stack */
+    bool                        task_pinned;                /*!< Pin the websocket task to `task_core`, otherwise it has no core affinity */
+    int                         task_core;                  /*!< Websocket task core, used only when `task_pinned` is set */
     int                         buffer_size;                /*!< Websocket buffer size */
     const char                  *cert_pem;                  /*!< Pointer to certificate data in PEM or DER format for server verify (with SSL), default is NULL, not required to verify the server. PEM-format must have a terminating NULL-character. DER-format requires the length to be passed in cert_len. */
     size_t                      cert_len;                   /*!< Length of the buffer pointed to by cert_pem. May be 0 for null-terminated pem */
@@ -258,6 +260,46 @@ esp_err_t esp_websocket_client_destroy_on_exit(esp_websocket_client_handle_t cli
  */
 int esp_websocket_client_send_bin(esp_websocket_client_handle_t client, const char *data, int len, TickType_t timeout);
 
+/**
+ * @brief      One block of a scatter/gather binary send
+ */
+typedef struct {
+    void *data;                             /*!< Caller owned block, masked in place */
+    size_t len;                             /*!< Length of the block in bytes */
+} esp_websocket_iov_t;
+
+/**
+ * @brief      Apply (or remove) the client to server masking key in place, a word at a time
+ *
+ * @param[in]  data    The payload bytes
+ * @param[in]  len     The length
+ * @param[in]  mask    The 4 byte masking key, as sent in the frame header
+ * @param[in]  offset  Offset of `data` within the frame payload, selects the key byte for data[0]
+ */
+void esp_websocket_mask(uint8_t *data, size_t len, const uint8_t mask[4], size_t offset);
+
+/**
+ * @brief      Write a list of blocks to the WebSocket connection as one binary frame (OPCODE=02, FIN set)
+ *
+ *  Notes:
+ *   - The blocks are framed and written straight to the underlying TCP/SSL transport, without
+ *     copying them into the client's tx buffer and without splitting them into buffer_size frames.
+ *   - The client to server mask is applied in place, so the blocks must be writable and are left
+ *     masked when the call returns. Send a copy if the data is still needed afterwards.
+ *   - With an external transport the blocks are sent as a fragmented message through the
+ *     WebSocket transport instead.
+ *
+ * @param[in]  client  The client
+ * @param[in]  iov     The blocks, sent in order
+ * @param[in]  iovcnt  Number of blocks
+ * @param[in]  timeout Write data timeout in RTOS ticks
+ *
+ * @return
+ *     - Number of payload bytes sent
+ *     - (-1) if any errors
+ */
+int esp_websocket_client_send_bin_iov(esp_websocket_client_handle_t client, const esp_websocket_iov_t *iov, int iovcnt, TickType_t timeout);
+
 /**
  * @brief      Write binary data to the WebSocket connection and sends it without setting the FIN flag(data send with WS OPCODE=02, i.e. binary)
  *
@@ -12,8 +12,10 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <esp_websocket_client.h>
 #include "esp_event.h"
+#include "esp_random.h"
 #include "unity.h"
 #include "test_utils.h"
 
@@ -70,11 +72,47 @@ TEST(websocket, websocket_set_invalid_url)
     esp_websocket_client_destroy(client);
 }
 
+static void mask_bytewise(uint8_t *data, size_t len, const uint8_t mask[4], size_t offset)
+{
+    for (size_t i = 0; i < len; i++) {
+        data[i] ^= mask[(offset + i) & 3];
+    }
+}
+
+TEST(websocket, websocket_mask_matches_bytewise)
+{
+    uint8_t buf[260];
+    uint8_t expected[260];
+
+    // Random keys, lengths, buffer alignments and payload offsets against the byte loop
+    for (int round = 0; round < 2000; round++) {
+        uint8_t mask[4];
+        uint32_t key = esp_random();
+        memcpy(mask, &key, sizeof(mask));
+        size_t align = esp_random() % 4;
+        size_t len = esp_random() % (sizeof(buf) - align + 1);
+        size_t offset = esp_random();
+
+        esp_fill_random(buf, sizeof(buf));
+        memcpy(expected, buf, sizeof(buf));
+
+        esp_websocket_mask(buf + align, len, mask, offset);
+        mask_bytewise(expected + align, len, mask, offset);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buf, sizeof(buf));
+
+        // Masking twice restores the payload
+        esp_websocket_mask(buf + align, len, mask, offset);
+        mask_bytewise(expected + align, len, mask, offset);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buf, sizeof(buf));
+    }
+}
+
 TEST_GROUP_RUNNER(websocket)
 {
     RUN_TEST_CASE(websocket, websocket_init_deinit)
     RUN_TEST_CASE(websocket, websocket_init_invalid_url)
     RUN_TEST_CASE(websocket, websocket_set_invalid_url)
+    RUN_TEST_CASE(websocket, websocket_mask_matches_bytewise)
 }
 
 void app_main(void)
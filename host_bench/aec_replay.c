@@ -0,0 +1,168 @@
+#include "audio_aec.h"
+#include "host_wav.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//回声消除回放：麦克风和参考信号按录音时的样本对齐送进AEC，和板子上一样按时间戳取参考
+//audio_aec_replay mic.wav ref.wav 回放录音，只报告ERLE；不带参数时回放合成的夹具并检查ERLE
+#define SAMPLE_RATE   16000
+#define TAIL_MS       64    //和CONFIG_AUDIO_AEC_TAIL_MS的默认值一致
+#define FRAME         256   //每次送给audio_aec_process的样本数，不是块长的整数倍也要能处理
+#define REF_AHEAD     2     //参考信号比麦克风提前写入的帧数，板子上是TX DMA队列的深度
+#define START_US      1000000
+
+//夹具：类似语音的远端信号经过合成的房间冲激响应回到麦克风，叠加近端底噪
+#define FIXTURE_SECONDS 10
+#define FIXTURE_DELAY   32      //扬声器到麦克风的延迟（样本），2ms
+#define FIXTURE_TAIL    480     //冲激响应长度（样本），30ms
+#define FIXTURE_GAIN    0.5f    //回声路径增益，-6dB
+#define FIXTURE_NOISE   20.0f   //近端底噪的幅度，约-64dBFS
+#define MEASURE_SECONDS 3       //ERLE按最后几秒的能量计算，这时滤波器已经收敛
+#define ERLE_MIN_DB     20.0f
+
+static uint32_t rng_state = 1;
+
+static float rng_uniform(void)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (rng_state >> 8) / 16777216.0f * 2.0f - 1.0f;
+}
+
+//合成夹具：ref是远端信号，mic是回声加近端底噪
+static int fixture_make(host_pcm_t *mic, host_pcm_t *ref)
+{
+    size_t count = (size_t)FIXTURE_SECONDS * SAMPLE_RATE;
+    mic->pcm = calloc(count, sizeof(int16_t));
+    ref->pcm = calloc(count, sizeof(int16_t));
+    float *h = calloc(FIXTURE_DELAY + FIXTURE_TAIL, sizeof(float));
+    if (mic->pcm == NULL || ref->pcm == NULL || h == NULL) {
+        free(h);
+        return -1;
+    }
+    mic->count = ref->count = count;
+    mic->sample_rate = ref->sample_rate = SAMPLE_RATE;
+
+    //远端：白噪声经过二阶共振（约500Hz）和一阶低通，按4Hz的音节包络调幅，每2秒停顿0.4秒
+    float y1 = 0.0f, y2 = 0.0f, lp = 0.0f;
+    const float r = 0.97f;
+    const float c = 2.0f * r * cosf(2.0f * (float)M_PI * 500.0f / SAMPLE_RATE);
+    for (size_t i = 0; i < count; i++) {
+        float t = (float)i / SAMPLE_RATE;
+        float y = rng_uniform() + c * y1 - r * r * y2;
+        y2 = y1;
+        y1 = y;
+        lp = 0.7f * lp + 0.3f * y;
+        float env = 0.5f + 0.5f * sinf(2.0f * (float)M_PI * 4.0f * t);
+        if (fmodf(t, 2.0f) > 1.6f) {
+            env = 0.0f;
+        }
+        float x = 400.0f * env * lp;
+        x = x > 32767.0f ? 32767.0f : (x < -32768.0f ? -32768.0f : x);
+        ref->pcm[i] = (int16_t)lrintf(x);
+    }
+
+    //房间冲激响应：直达声之后是按指数衰减的随机反射，能量归一到FIXTURE_GAIN
+    float energy = 0.0f;
+    for (int k = 0; k < FIXTURE_TAIL; k++) {
+        float v = (k == 0 ? 1.0f : 0.5f * rng_uniform()) * expf(-(float)k / (FIXTURE_TAIL / 5.0f));
+        h[FIXTURE_DELAY + k] = v;
+        energy += v * v;
+    }
+    for (int k = 0; k < FIXTURE_DELAY + FIXTURE_TAIL; k++) {
+        h[k] *= FIXTURE_GAIN / sqrtf(energy);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        float acc = FIXTURE_NOISE * rng_uniform();
+        for (int k = 0; k < FIXTURE_DELAY + FIXTURE_TAIL && (size_t)k <= i; k++) {
+            acc += h[k] * ref->pcm[i - k];
+        }
+        acc = acc > 32767.0f ? 32767.0f : (acc < -32768.0f ? -32768.0f : acc);
+        mic->pcm[i] = (int16_t)lrintf(acc);
+    }
+
+    free(h);
+    return 0;
+}
+
+//第i个样本的时刻（esp_timer），参考的播放时刻和麦克风的采集时刻在同一条时间线上
+static int64_t sample_us(size_t i)
+{
+    return START_US + (int64_t)i * 1000000 / SAMPLE_RATE;
+}
+
+int main(int argc, char **argv)
+{
+    host_pcm_t mic = { 0 };
+    host_pcm_t ref = { 0 };
+    bool fixture = argc < 3;
+    if (fixture) {
+        if (fixture_make(&mic, &ref) != 0) {
+            fprintf(stderr, "fixture setup failed\n");
+            return 1;
+        }
+    } else if (host_wav_read(argv[1], &mic) != 0 || host_wav_read(argv[2], &ref) != 0) {
+        return 1;
+    }
+    if (mic.sample_rate != SAMPLE_RATE || ref.sample_rate != SAMPLE_RATE) {
+        fprintf(stderr, "need %d Hz input\n", SAMPLE_RATE);
+        return 1;
+    }
+    size_t count = mic.count < ref.count ? mic.count : ref.count;
+
+    static audio_aec_t aec;
+    if (audio_aec_init(&aec, SAMPLE_RATE, TAIL_MS, FRAME) != ESP_OK) {
+        fprintf(stderr, "aec init failed\n");
+        return 1;
+    }
+
+    //输出比输入晚AUDIO_AEC_BLOCK个样本，ERLE按对齐后的麦克风和输出能量计算
+    int16_t *out = malloc(count * sizeof(int16_t));
+    if (out == NULL) {
+        return 1;
+    }
+    memcpy(out, mic.pcm, count * sizeof(int16_t));
+
+    size_t ref_pushed = 0;
+    for (size_t pos = 0; pos + FRAME <= count; pos += FRAME) {
+        size_t ref_target = pos + (REF_AHEAD + 1) * FRAME;
+        ref_target = ref_target < count ? ref_target : count;
+        if (ref_target > ref_pushed) {
+            audio_aec_push_reference(&aec, ref.pcm + ref_pushed, ref_target - ref_pushed, sample_us(ref_pushed));
+            ref_pushed = ref_target;
+        }
+        audio_aec_process(&aec, out + pos, FRAME, sample_us(pos + FRAME - 1));
+    }
+
+    double mic_energy = 0.0;
+    double out_energy = 0.0;
+    size_t measure_from = count > (size_t)MEASURE_SECONDS * SAMPLE_RATE ? count - (size_t)MEASURE_SECONDS * SAMPLE_RATE : 0;
+    size_t measure_to = count / FRAME * FRAME;
+    for (size_t i = measure_from; i + AUDIO_AEC_BLOCK < measure_to; i++) {
+        double d = mic.pcm[i];
+        double e = out[i + AUDIO_AEC_BLOCK];
+        mic_energy += d * d;
+        out_energy += e * e;
+    }
+    float erle_db = (float)(10.0 * log10((mic_energy + 1.0) / (out_energy + 1.0)));
+
+    audio_aec_stats_t stats;
+    audio_aec_get_stats(&aec, &stats);
+    printf("%zu samples, %lu blocks (%lu adapted), ref resync %lu, ref missing %lu\n", count,
+           (unsigned long)stats.blocks, (unsigned long)stats.adapted, (unsigned long)stats.ref_resync,
+           (unsigned long)stats.ref_missing);
+    printf("ERLE last %d s: %.1f dB (smoothed %.1f dB), max %.1f us/block\n", MEASURE_SECONDS, erle_db, stats.erle_db,
+           stats.cycles_max / 1000.0);
+
+    free(out);
+    free(mic.pcm);
+    free(ref.pcm);
+
+    if (fixture && erle_db < ERLE_MIN_DB) {
+        fprintf(stderr, "FAIL: ERLE %.1f dB below %.1f dB\n", erle_db, ERLE_MIN_DB);
+        return 1;
+    }
+    return 0;
+}
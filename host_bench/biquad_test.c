@@ -0,0 +1,234 @@
+#include "audio_biquad.h"
+#include "host_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+//滤波器组的频响测试：audio_biquad_response_db对照设计公式，定点实现的冲激响应对照response_db
+//滤波器组和app_driver.c的配置一样：5Hz隔直、80Hz巴特沃斯高通、3kHz峰值均衡
+#define SAMPLE_RATE 16000
+#define DC_HZ       5.0f
+#define HPF_HZ      80.0f
+#define EQ_HZ       3000.0f
+#define EQ_GAIN_DB  6.0f
+
+#define TEST_POINTS 40
+#define F_MIN       20.0f
+#define F_MAX       7900.0f
+#define PASS_HZ     (4 * HPF_HZ) //高通的通带，定点冲激响应在这以上要和设计曲线紧密一致
+#define IR_LEN      16384 //隔直的时间常数约500个样本，截断处已经衰减到可以忽略
+
+//冲激幅度：经过峰值均衡以后也不饱和
+#define IMPULSE_S16 16384
+#define IMPULSE_S24 (1 << 21)
+
+
+//测试频点，F_MIN到F_MAX按对数均分
+static float test_freq(int i)
+{
+    return F_MIN * powf(F_MAX / F_MIN, (float)i / (TEST_POINTS - 1));
+}
+
+//二阶巴特沃斯高通经双线性变换后的幅度响应
+static double butterworth_hp_db(double f, double fc)
+{
+    double t = tan(M_PI * f / SAMPLE_RATE) / tan(M_PI * fc / SAMPLE_RATE);
+    double t4 = t * t * t * t;
+    return 10.0 * log10(t4 / (1.0 + t4));
+}
+
+//一节的幅度响应，双精度，用来交叉检查response_db
+static double stage_db(const audio_biquad_coeffs_t *c, double f)
+{
+    double w = 2.0 * M_PI * f / SAMPLE_RATE;
+    double nr = c->b0 + c->b1 * cos(w) + c->b2 * cos(2.0 * w);
+    double ni = -c->b1 * sin(w) - c->b2 * sin(2.0 * w);
+    double dr = 1.0 + c->a1 * cos(w) + c->a2 * cos(2.0 * w);
+    double di = -c->a1 * sin(w) - c->a2 * sin(2.0 * w);
+    return 10.0 * log10((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+static void bank_setup(audio_biquad_t *bq, int channels)
+{
+    audio_biquad_coeffs_t dc = audio_biquad_dc_blocker(SAMPLE_RATE, DC_HZ);
+    audio_biquad_coeffs_t hp = audio_biquad_highpass(SAMPLE_RATE, HPF_HZ, 0.7071f);
+    audio_biquad_coeffs_t eq = audio_biquad_peaking(SAMPLE_RATE, EQ_HZ, 1.0f, EQ_GAIN_DB);
+
+    audio_biquad_init(bq, channels);
+    CHECK(audio_biquad_add(bq, &dc) == ESP_OK, "dc blocker rejected");
+    CHECK(audio_biquad_add(bq, &hp) == ESP_OK, "high-pass rejected");
+    CHECK(audio_biquad_add(bq, &eq) == ESP_OK, "peaking EQ rejected");
+}
+
+//每节的response_db对照设计目标
+static void test_design(void)
+{
+    audio_biquad_t bq;
+    double worst = 0.0;
+
+    //高通：整条曲线和巴特沃斯公式一致，截止频率处-3dB
+    audio_biquad_coeffs_t hp = audio_biquad_highpass(SAMPLE_RATE, HPF_HZ, 0.7071f);
+    audio_biquad_init(&bq, 1);
+    audio_biquad_add(&bq, &hp);
+    for (int i = 0; i < TEST_POINTS; i++) {
+        float f = test_freq(i);
+        double err = fabs(audio_biquad_response_db(&bq, SAMPLE_RATE, f) - butterworth_hp_db(f, HPF_HZ));
+        worst = err > worst ? err : worst;
+        CHECK(err < 0.02, "high-pass at %.0f Hz off the Butterworth curve by %.3f dB", f, err);
+    }
+    CHECK(fabsf(audio_biquad_response_db(&bq, SAMPLE_RATE, HPF_HZ) + 3.01f) < 0.02f, "high-pass not -3 dB at fc");
+
+    //隔直：fc处-3dB，语音频段内平坦
+    audio_biquad_coeffs_t dc = audio_biquad_dc_blocker(SAMPLE_RATE, DC_HZ);
+    audio_biquad_init(&bq, 1);
+    audio_biquad_add(&bq, &dc);
+    float dc_db = audio_biquad_response_db(&bq, SAMPLE_RATE, DC_HZ);
+    CHECK(fabsf(dc_db + 3.01f) < 0.05f, "dc blocker %.3f dB at fc", dc_db);
+    CHECK(audio_biquad_response_db(&bq, SAMPLE_RATE, 0.0f) < -100.0f, "dc blocker passes DC");
+    CHECK(fabsf(audio_biquad_response_db(&bq, SAMPLE_RATE, 300.0f)) < 0.01f, "dc blocker not flat at 300 Hz");
+
+    //峰值均衡：中心频率处为设计增益，直流和奈奎斯特频率处为0dB
+    audio_biquad_coeffs_t eq = audio_biquad_peaking(SAMPLE_RATE, EQ_HZ, 1.0f, EQ_GAIN_DB);
+    audio_biquad_init(&bq, 1);
+    audio_biquad_add(&bq, &eq);
+    float peak = audio_biquad_response_db(&bq, SAMPLE_RATE, EQ_HZ);
+    CHECK(fabsf(peak - EQ_GAIN_DB) < 0.02f, "peaking EQ %.3f dB at center", peak);
+    CHECK(fabsf(audio_biquad_response_db(&bq, SAMPLE_RATE, 0.0f)) < 0.01f, "peaking EQ not 0 dB at DC");
+    CHECK(fabsf(audio_biquad_response_db(&bq, SAMPLE_RATE, SAMPLE_RATE / 2)) < 0.01f, "peaking EQ not 0 dB at Nyquist");
+
+    //级联：response_db等于各节双精度频响之和
+    bank_setup(&bq, 1);
+    double cascade_worst = 0.0;
+    for (int i = 0; i < TEST_POINTS; i++) {
+        float f = test_freq(i);
+        double expected = 0.0;
+        for (int s = 0; s < bq.stages; s++) {
+            expected += stage_db(&bq.coeffs[s], f);
+        }
+        double err = fabs(audio_biquad_response_db(&bq, SAMPLE_RATE, f) - expected);
+        cascade_worst = err > cascade_worst ? err : cascade_worst;
+        CHECK(err < 0.01, "cascade at %.0f Hz: response_db off by %.4f dB", f, err);
+    }
+    printf("design: high-pass max %.4f dB from Butterworth, cascade max %.4f dB, EQ peak %.2f dB\n", worst,
+           cascade_worst, peak);
+}
+
+//冲激响应在f处的DTFT幅度，按冲激幅度归一
+static double ir_gain(const double *ir, size_t len, double f, double amplitude)
+{
+    double w = 2.0 * M_PI * f / SAMPLE_RATE;
+    double re = 0.0, im = 0.0;
+    for (size_t n = 0; n < len; n++) {
+        re += ir[n] * cos(w * n);
+        im -= ir[n] * sin(w * n);
+    }
+    return sqrt(re * re + im * im) / fabs(amplitude);
+}
+
+//定点截断在低频的残余：输出衰减到0以后累加器里还留着不到1LSB的小数，相当于少了一段
+//总和为 小数/(1+a1+a2) 的低频长尾，极点最靠近z=1的那一节决定上限
+static double deadband_lsb(const audio_biquad_t *bq)
+{
+    double worst = 1.0;
+    for (int s = 0; s < bq->stages; s++) {
+        double a = fabs(1.0 + bq->coeffs[s].a1 + bq->coeffs[s].a2);
+        worst = 1.0 / a > worst ? 1.0 / a : worst;
+    }
+    return worst;
+}
+
+//定点冲激响应的频谱对照response_db，偏差按相对冲激幅度的绝对误差算（dB）
+//PASS_HZ以上不超过pass_limit_db，以下允许上面那段长尾，取四倍余量
+static void compare_ir(const audio_biquad_t *bq, const double *ir, double amplitude, double pass_limit_db,
+                       const char *name)
+{
+    double low_limit_db = 20.0 * log10(4.0 * deadband_lsb(bq) / fabs(amplitude));
+    double worst_low = -300.0, worst_pass = -300.0;
+    for (int i = 0; i < TEST_POINTS; i++) {
+        float f = test_freq(i);
+        double expected = pow(10.0, audio_biquad_response_db(bq, SAMPLE_RATE, f) / 20.0);
+        double err_db = 20.0 * log10(fabs(ir_gain(ir, IR_LEN, f, amplitude) - expected) + 1e-15);
+        double limit_db = f < PASS_HZ ? low_limit_db : pass_limit_db;
+        CHECK(err_db < limit_db, "%s at %.0f Hz: impulse response off by %.1f dB re impulse, limit %.1f dB", name, f,
+              err_db, limit_db);
+        if (f < PASS_HZ) {
+            worst_low = err_db > worst_low ? err_db : worst_low;
+        } else {
+            worst_pass = err_db > worst_pass ? err_db : worst_pass;
+        }
+    }
+    printf("%s: impulse response vs response_db %.1f dB re impulse below %.0f Hz (limit %.1f), %.1f dB above "
+           "(limit %.1f)\n", name, worst_low, PASS_HZ, low_limit_db, worst_pass, pass_limit_db);
+}
+
+//16位单声道
+static void test_s16(void)
+{
+    audio_biquad_t bq;
+    bank_setup(&bq, 1);
+
+    int16_t *samples = calloc(IR_LEN, sizeof(int16_t));
+    double *ir = calloc(IR_LEN, sizeof(double));
+    if (samples == NULL || ir == NULL) {
+        CHECK(false, "out of memory");
+        free(samples);
+        free(ir);
+        return;
+    }
+
+    //分几块处理，跨块的状态也在检查范围内
+    samples[0] = IMPULSE_S16;
+    for (size_t pos = 0; pos < IR_LEN; pos += 1000) {
+        size_t n = IR_LEN - pos < 1000 ? IR_LEN - pos : 1000;
+        audio_biquad_process_s16(&bq, samples + pos, n);
+    }
+    for (size_t i = 0; i < IR_LEN; i++) {
+        ir[i] = samples[i];
+    }
+
+    compare_ir(&bq, ir, IMPULSE_S16, -40.0, "s16");
+    free(samples);
+    free(ir);
+}
+
+//32位双声道交织：两个声道用不同的冲激幅度，各自的状态互不影响
+static void test_s32(void)
+{
+    audio_biquad_t bq;
+    bank_setup(&bq, 2);
+
+    int32_t *samples = calloc(2 * IR_LEN, sizeof(int32_t));
+    double *ir = calloc(IR_LEN, sizeof(double));
+    if (samples == NULL || ir == NULL) {
+        CHECK(false, "out of memory");
+        free(samples);
+        free(ir);
+        return;
+    }
+
+    //INMP441的24位数据在32位样本的高位
+    samples[0] = IMPULSE_S24 * 256;
+    samples[1] = -(IMPULSE_S24 / 2) * 256;
+    audio_biquad_process_s32(&bq, samples, 2 * IR_LEN);
+
+    for (int ch = 0; ch < 2; ch++) {
+        double amplitude = ch == 0 ? IMPULSE_S24 : -(IMPULSE_S24 / 2);
+        for (size_t i = 0; i < IR_LEN; i++) {
+            ir[i] = samples[2 * i + ch] >> 8;
+        }
+        compare_ir(&bq, ir, amplitude, -80.0, ch == 0 ? "s32 left" : "s32 right");
+    }
+    free(samples);
+    free(ir);
+}
+
+int main(void)
+{
+    test_design();
+    test_s16();
+    test_s32();
+
+    return host_test_result();
+}
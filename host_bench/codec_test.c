@@ -0,0 +1,175 @@
+#include "audio_codec.h"
+#include "host_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//IMA ADPCM的主机测试：类似语音的信号和满幅信号编码再解码，检查信噪比、包长和样本数，
+//以及每包的状态头：乱序解码和顺序解码一致，包头的预测值接着上一包的最后一个样本
+#define SAMPLE_RATE   16000
+#define SECONDS       4
+#define SAMPLES       (SECONDS * SAMPLE_RATE)
+#define PACKET        640 //40ms，和上行默认的包长一致
+#define ODD_PACKET    321 //奇数长度的包，最后一个字节只有低4位
+#define MAX_PACKETS   (SAMPLES / ODD_PACKET + 1)
+
+//信噪比下限：类似语音的信号和满幅正弦步长都跟得上
+#define SPEECH_SNR_MIN 25.0
+#define SINE_SNR_MIN   25.0
+//满幅方波每次跳变都要重新追，信噪比只有几dB，改为检查每个半周期结束时追到了满幅的1%以内
+#define SQUARE_HALF    (SAMPLE_RATE / 400)
+#define SQUARE_SETTLE  328
+
+static uint32_t seed = 1;
+
+static float rng_uniform(void)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+}
+
+static int16_t clamp_s16(float x)
+{
+    return (int16_t)lrintf(x > 32767.0f ? 32767.0f : (x < -32768.0f ? -32768.0f : x));
+}
+
+//类似语音：白噪声经过500Hz附近的二阶共振，按4Hz的音节包络调幅，每2秒停顿0.4秒
+static void make_speech(int16_t *pcm)
+{
+    float y1 = 0.0f, y2 = 0.0f;
+    const float r = 0.97f;
+    const float c = 2.0f * r * cosf(2.0f * (float)M_PI * 500.0f / SAMPLE_RATE);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        float t = (float)i / SAMPLE_RATE;
+        float y = rng_uniform() + c * y1 - r * r * y2;
+        y2 = y1;
+        y1 = y;
+        float env = 0.5f + 0.5f * sinf(2.0f * (float)M_PI * 4.0f * t);
+        if (fmodf(t, 2.0f) > 1.6f) {
+            env = 0.0f;
+        }
+        pcm[i] = clamp_s16(250.0f * env * y);
+    }
+}
+
+//满幅1kHz正弦，峰值顶到int16的两端
+static void make_sine(int16_t *pcm)
+{
+    for (size_t i = 0; i < SAMPLES; i++) {
+        pcm[i] = clamp_s16(32768.0f * sinf(2.0f * (float)M_PI * 1000.0f * i / SAMPLE_RATE));
+    }
+}
+
+//满幅200Hz方波，两端饱和，检查预测值不会溢出翻转
+static void make_square(int16_t *pcm)
+{
+    for (size_t i = 0; i < SAMPLES; i++) {
+        pcm[i] = (i / SQUARE_HALF) & 1 ? INT16_MIN : INT16_MAX;
+    }
+}
+
+static int16_t input[SAMPLES];
+static int16_t output[SAMPLES];
+static int16_t shuffled[SAMPLES];
+static uint8_t encoded[MAX_PACKETS][AUDIO_ADPCM_HEADER_SIZE + PACKET / 2 + 1];
+static size_t packet_len[MAX_PACKETS];
+static size_t packet_start[MAX_PACKETS];
+static size_t packet_samples[MAX_PACKETS];
+
+static double snr_db(void)
+{
+    double signal = 0.0;
+    double noise = 0.0;
+    for (size_t i = 0; i < SAMPLES; i++) {
+        double d = (double)output[i] - input[i];
+        signal += (double)input[i] * input[i];
+        noise += d * d;
+    }
+    return 10.0 * log10((signal + 1.0) / (noise + 1.0));
+}
+
+//按包编码再解码，包长在PACKET和ODD_PACKET之间交替
+static void run(const char *name, double snr_min)
+{
+    audio_adpcm_state_t state;
+    audio_adpcm_reset(&state);
+
+    size_t packets = 0;
+    for (size_t pos = 0; pos < SAMPLES; packets++) {
+        size_t n = packets & 1 ? ODD_PACKET : PACKET;
+        n = n < SAMPLES - pos ? n : SAMPLES - pos;
+        packet_start[packets] = pos;
+        packet_samples[packets] = n;
+        packet_len[packets] = audio_adpcm_encode(&state, input + pos, n, encoded[packets]);
+        CHECK(packet_len[packets] == audio_adpcm_encoded_size(n), "%s packet %zu: %zu bytes for %zu samples", name,
+              packets, packet_len[packets], n);
+        CHECK(audio_adpcm_decoded_samples(encoded[packets], packet_len[packets]) == n,
+              "%s packet %zu: decoded_samples %zu, encoded %zu", name, packets,
+              audio_adpcm_decoded_samples(encoded[packets], packet_len[packets]), n);
+        pos += n;
+    }
+
+    for (size_t k = 0; k < packets; k++) {
+        size_t n = audio_adpcm_decode(encoded[k], packet_len[k], output + packet_start[k]);
+        CHECK(n == packet_samples[k], "%s packet %zu: decoded %zu samples", name, k, n);
+        //包头是编码到这里时的状态，预测值就是上一包最后一个重建样本
+        if (k > 0) {
+            int16_t predictor = (int16_t)(encoded[k][0] | (encoded[k][1] << 8));
+            CHECK(predictor == output[packet_start[k] - 1], "%s packet %zu: header predictor %d, last sample %d",
+                  name, k, predictor, output[packet_start[k] - 1]);
+        }
+    }
+
+    //从任意一包开始解码：倒序、每包单独解码，结果和顺序解码逐样本一致
+    memset(shuffled, 0, sizeof(shuffled));
+    for (size_t k = packets; k-- > 0;) {
+        audio_adpcm_decode(encoded[k], packet_len[k], shuffled + packet_start[k]);
+    }
+    CHECK(memcmp(shuffled, output, sizeof(output)) == 0, "%s: out-of-order decode differs", name);
+
+    double snr = snr_db();
+    CHECK(snr >= snr_min, "%s: SNR %.1f dB below %.1f dB", name, snr, snr_min);
+    printf("%-7s %zu packets, SNR %.1f dB\n", name, packets, snr);
+}
+
+//方波：预测值在两端饱和，不溢出翻转，每个半周期结束前追到位
+static void check_square(void)
+{
+    int settled = 0;
+    int64_t worst = 0;
+    for (size_t end = SQUARE_HALF - 1; end < SAMPLES; end += SQUARE_HALF) {
+        int64_t err = llabs((int64_t)output[end] - input[end]);
+        worst = err > worst ? err : worst;
+        settled += err <= SQUARE_SETTLE;
+    }
+    CHECK(settled == SAMPLES / SQUARE_HALF, "square: %d of %d half periods settled, worst %lld", settled,
+          SAMPLES / SQUARE_HALF, (long long)worst);
+}
+
+//格式不对的包不解码
+static void test_malformed(void)
+{
+    uint8_t packet[AUDIO_ADPCM_HEADER_SIZE + 2] = { 0 };
+    CHECK(audio_adpcm_decoded_samples(packet, AUDIO_ADPCM_HEADER_SIZE) == 0, "empty packet decoded");
+    packet[2] = 89;
+    CHECK(audio_adpcm_decoded_samples(packet, sizeof(packet)) == 0, "step index 89 accepted");
+    packet[2] = 88;
+    packet[3] = 2;
+    CHECK(audio_adpcm_decoded_samples(packet, sizeof(packet)) == 0, "odd flag 2 accepted");
+    packet[3] = 1;
+    CHECK(audio_adpcm_decoded_samples(packet, sizeof(packet)) == 3, "odd packet length");
+}
+
+int main(void)
+{
+    make_speech(input);
+    run("speech", SPEECH_SNR_MIN);
+    make_sine(input);
+    run("sine", SINE_SNR_MIN);
+    make_square(input);
+    run("square", 0.0);
+    check_square();
+    test_malformed();
+    return host_test_result();
+}
@@ -0,0 +1,223 @@
+#include "host_i2s.h"
+#include "esp_timer.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+//接收：desc_num个DMA缓冲组成的队列
+static pthread_mutex_t rx_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t *rx_bufs = NULL;
+static size_t rx_frame_bytes = 0;
+static uint32_t rx_desc_num = 0;
+static uint32_t rx_head = 0;
+static uint32_t rx_count = 0;
+static int64_t rx_stamps[64];
+static TaskHandle_t volatile rx_notify_task = NULL;
+static mic_stats_t rx_stats;
+
+//发送：写入直接记录，hold时阻塞
+static pthread_mutex_t tx_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tx_cond = PTHREAD_COND_INITIALIZER;
+static bool tx_held = false;
+static size_t tx_frame_bytes = 0;
+static uint32_t tx_sent_count = 0;
+static TaskHandle_t tx_notify_task = NULL;
+static host_i2s_tx_record_t tx_log[HOST_I2S_TX_LOG_MAX];
+static size_t tx_log_count = 0;
+static spk_stats_t tx_stats;
+
+i2s_chan_handle_t rx_handle = NULL;
+i2s_chan_handle_t tx_handle = NULL;
+
+esp_err_t i2s_rx_init(const audio_dma_profile_t *profile)
+{
+    if (profile->desc_num > sizeof(rx_stamps) / sizeof(rx_stamps[0])) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&rx_lock);
+    rx_frame_bytes = profile->frame_num * I2S_RX_FRAME_BYTES;
+    rx_desc_num = profile->desc_num;
+    rx_head = 0;
+    rx_count = 0;
+    free(rx_bufs);
+    rx_bufs = calloc(rx_desc_num, rx_frame_bytes);
+    pthread_mutex_unlock(&rx_lock);
+    return rx_bufs != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void i2s_rx_deinit(void)
+{
+}
+
+size_t mic_frame_bytes(void)
+{
+    return rx_frame_bytes;
+}
+
+void mic_set_notify_task(TaskHandle_t task)
+{
+    rx_notify_task = task;
+}
+
+bool host_i2s_rx_ready(void)
+{
+    return rx_notify_task != NULL;
+}
+
+void host_i2s_rx_push(const void *data, size_t size, int64_t timestamp_us)
+{
+    pthread_mutex_lock(&rx_lock);
+    if (rx_count == rx_desc_num) {
+        //DMA覆盖最旧的缓冲
+        rx_head = (rx_head + 1) % rx_desc_num;
+        rx_count--;
+        rx_stats.overflow++;
+        rx_stats.overflow_last_us = esp_timer_get_time();
+    }
+    uint32_t tail = (rx_head + rx_count) % rx_desc_num;
+    size = size < rx_frame_bytes ? size : rx_frame_bytes;
+    memset(rx_bufs + (size_t)tail * rx_frame_bytes, 0, rx_frame_bytes);
+    memcpy(rx_bufs + (size_t)tail * rx_frame_bytes, data, size);
+    rx_stamps[tail] = timestamp_us;
+    rx_count++;
+    TaskHandle_t task = rx_notify_task;
+    pthread_mutex_unlock(&rx_lock);
+
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+esp_err_t mic_wait(TickType_t timeout, int64_t *timestamp_us)
+{
+    if (ulTaskNotifyTake(pdFALSE, timeout) == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    pthread_mutex_lock(&rx_lock);
+    *timestamp_us = rx_count > 0 ? rx_stamps[rx_head] : esp_timer_get_time();
+    pthread_mutex_unlock(&rx_lock);
+    return ESP_OK;
+}
+
+esp_err_t mic_read(void *dst, size_t size, size_t *bytes_read)
+{
+    esp_err_t ret = ESP_OK;
+
+    pthread_mutex_lock(&rx_lock);
+    rx_stats.reads++;
+    *bytes_read = 0;
+    if (rx_count == 0) {
+        rx_stats.read_errors++;
+        ret = ESP_ERR_TIMEOUT;
+    } else {
+        *bytes_read = size < rx_frame_bytes ? size : rx_frame_bytes;
+        memcpy(dst, rx_bufs + (size_t)rx_head * rx_frame_bytes, *bytes_read);
+        rx_head = (rx_head + 1) % rx_desc_num;
+        rx_count--;
+    }
+    pthread_mutex_unlock(&rx_lock);
+    return ret;
+}
+
+void mic_get_stats(mic_stats_t *out)
+{
+    pthread_mutex_lock(&rx_lock);
+    *out = rx_stats;
+    pthread_mutex_unlock(&rx_lock);
+}
+
+esp_err_t i2s_tx_init(const audio_dma_profile_t *profile)
+{
+    tx_frame_bytes = profile->frame_num * I2S_TX_FRAME_BYTES;
+    return ESP_OK;
+}
+
+void i2s_tx_deinit(void)
+{
+}
+
+size_t spk_frame_bytes(void)
+{
+    return tx_frame_bytes;
+}
+
+void host_i2s_tx_hold(bool hold)
+{
+    pthread_mutex_lock(&tx_lock);
+    tx_held = hold;
+    pthread_cond_broadcast(&tx_cond);
+    pthread_mutex_unlock(&tx_lock);
+}
+
+//样本全相同时返回这个值，否则返回-1
+static int32_t buffer_value(const int16_t *samples, size_t count)
+{
+    for (size_t i = 1; i < count; i++) {
+        if (samples[i] != samples[0]) {
+            return -1;
+        }
+    }
+    return count > 0 ? samples[0] : -1;
+}
+
+esp_err_t spk_write(const void *src, size_t size)
+{
+    pthread_mutex_lock(&tx_lock);
+    while (tx_held) {
+        pthread_cond_wait(&tx_cond, &tx_lock);
+    }
+    tx_stats.writes++;
+    if (tx_log_count < HOST_I2S_TX_LOG_MAX) {
+        tx_log[tx_log_count].size = size;
+        tx_log[tx_log_count].value = buffer_value(src, size / sizeof(int16_t));
+    }
+    tx_log_count++;
+    tx_sent_count++;
+    TaskHandle_t task = tx_notify_task;
+    pthread_mutex_unlock(&tx_lock);
+
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+    return ESP_OK;
+}
+
+void spk_set_notify_task(TaskHandle_t task)
+{
+    tx_notify_task = task;
+}
+
+esp_err_t spk_wait(TickType_t timeout)
+{
+    return ulTaskNotifyTake(pdTRUE, timeout) > 0 ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+uint32_t spk_get_sent(int64_t *last_sent_us)
+{
+    if (last_sent_us != NULL) {
+        *last_sent_us = esp_timer_get_time();
+    }
+    return tx_sent_count;
+}
+
+int64_t spk_play_time_us(size_t size)
+{
+    return esp_timer_get_time();
+}
+
+void spk_get_stats(spk_stats_t *out)
+{
+    pthread_mutex_lock(&tx_lock);
+    *out = tx_stats;
+    pthread_mutex_unlock(&tx_lock);
+}
+
+size_t host_i2s_tx_log(host_i2s_tx_record_t *out, size_t max)
+{
+    pthread_mutex_lock(&tx_lock);
+    size_t count = tx_log_count < HOST_I2S_TX_LOG_MAX ? tx_log_count : HOST_I2S_TX_LOG_MAX;
+    memcpy(out, tx_log, (count < max ? count : max) * sizeof(*out));
+    count = tx_log_count;
+    pthread_mutex_unlock(&tx_lock);
+    return count;
+}
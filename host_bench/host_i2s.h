@@ -0,0 +1,30 @@
+#ifndef __HOST_I2S_H_
+#define __HOST_I2S_H_
+
+//主机上模拟的I2S驱动：实现Mic_driver.h和Speaker_driver.h里的接口，测试线程扮演DMA
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "Audio_common.h"
+#include "Mic_driver.h"
+#include "Speaker_driver.h"
+
+//记录的写入次数上限，超出的不记录
+#define HOST_I2S_TX_LOG_MAX 4096
+
+//一次spk_write的记录，value是缓冲里的样本值，样本不全相同时为-1
+typedef struct {
+    size_t size;
+    int32_t value;
+} host_i2s_tx_record_t;
+
+//收到一个DMA缓冲：放进接收队列并唤醒mic_set_notify_task设置的任务，队列满时覆盖最旧的并计一次溢出
+void host_i2s_rx_push(const void *data, size_t size, int64_t timestamp_us);
+//采集任务已经调用mic_set_notify_task，之后送的缓冲才会唤醒它
+bool host_i2s_rx_ready(void);
+//hold为true时spk_write阻塞，模拟播放卡住，false时放行
+void host_i2s_tx_hold(bool hold);
+//复制spk_write的记录，返回总的记录数
+size_t host_i2s_tx_log(host_i2s_tx_record_t *out, size_t max);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef __HOST_TEST_H_
+#define __HOST_TEST_H_
+
+//主机测试共用的检查和等待，每个测试程序只有一个源文件包含它
+#include <stdio.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+//轮询等待的默认超时
+#define HOST_WAIT_MS 2000
+
+static int failures = 0;
+
+//条件不成立时打印位置和说明，计一次失败，测试继续
+#define CHECK(cond, ...)                                   \
+    do {                                                   \
+        if (!(cond)) {                                     \
+            failures++;                                    \
+            fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                  \
+            fprintf(stderr, "\n");                         \
+        }                                                  \
+    } while (0)
+
+//每毫秒求一次cond，HOST_WAIT_MS内成立为true，超时为false
+#define WAIT_UNTIL(cond)                                   \
+    ({                                                     \
+        bool met_ = false;                                 \
+        for (int ms_ = 0; ms_ < HOST_WAIT_MS; ms_++) {     \
+            if ((met_ = (cond))) {                         \
+                break;                                     \
+            }                                              \
+            usleep(1000);                                  \
+        }                                                  \
+        met_;                                              \
+    })
+
+//main的返回值：有失败时打印总数并返回1
+static inline int host_test_result(void)
+{
+    if (failures > 0) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
+
+#endif
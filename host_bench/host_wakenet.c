@@ -0,0 +1,80 @@
+#include "host_wakenet.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct model_iface_data_t {
+    int run; //连续的唤醒词块数
+};
+
+static char *model_names[] = { HOST_WAKENET_NAME };
+static srmodel_list_t model_list = { model_names, 1 };
+static volatile bool detect_hold = false;
+
+void host_wakenet_hold(bool hold)
+{
+    detect_hold = hold;
+}
+
+static model_iface_data_t *host_create(const void *model_name, det_mode_t det_mode)
+{
+    return calloc(1, sizeof(model_iface_data_t));
+}
+
+static int host_get_samp_chunksize(model_iface_data_t *model)
+{
+    return HOST_WAKENET_CHUNK;
+}
+
+static int host_get_samp_rate(model_iface_data_t *model)
+{
+    return 16000;
+}
+
+//第HOST_WAKENET_CHUNKS块报唤醒，唤醒词没有结束之前不再报
+static wakenet_state_t host_detect(model_iface_data_t *model, int16_t *samples)
+{
+    while (detect_hold) {
+        usleep(1000);
+    }
+    for (int i = 0; i < HOST_WAKENET_CHUNK; i++) {
+        if (samples[i] < HOST_WAKENET_LEVEL) {
+            model->run = 0;
+            return WAKENET_NO_DETECT;
+        }
+    }
+    return ++model->run == HOST_WAKENET_CHUNKS ? WAKENET_DETECTED : WAKENET_NO_DETECT;
+}
+
+static void host_destroy(model_iface_data_t *model)
+{
+    free(model);
+}
+
+static const esp_wn_iface_t host_wakenet = {
+    .create = host_create,
+    .get_samp_chunksize = host_get_samp_chunksize,
+    .get_samp_rate = host_get_samp_rate,
+    .detect = host_detect,
+    .destroy = host_destroy,
+};
+
+srmodel_list_t *esp_srmodel_init(const char *partition_label)
+{
+    return &model_list;
+}
+
+char *esp_srmodel_filter(srmodel_list_t *models, const char *keyword1, const char *keyword2)
+{
+    for (int i = 0; i < models->num; i++) {
+        if (strstr(models->model_name[i], keyword1) != NULL) {
+            return models->model_name[i];
+        }
+    }
+    return NULL;
+}
+
+const esp_wn_iface_t *esp_wn_handle_from_name(const char *model_name)
+{
+    return strcmp(model_name, HOST_WAKENET_NAME) == 0 ? &host_wakenet : NULL;
+}
@@ -0,0 +1,19 @@
+#ifndef __HOST_WAKENET_H_
+#define __HOST_WAKENET_H_
+
+//主机上的假WakeNet：实现esp-sr里audio_wake.c用到的接口，按样本幅度判定唤醒词
+//一块里所有样本都不小于HOST_WAKENET_LEVEL算一块“唤醒词”，连续HOST_WAKENET_CHUNKS块时报一次唤醒
+#include <stdbool.h>
+#include "esp_wn_iface.h"
+#include "esp_wn_models.h"
+#include "model_path.h"
+
+#define HOST_WAKENET_NAME   "wn9_host"
+#define HOST_WAKENET_CHUNK  512 //和WakeNet9在16kHz下的块长一致
+#define HOST_WAKENET_LEVEL  4096
+#define HOST_WAKENET_CHUNKS 8
+
+//hold为true时检测阻塞，模拟WakeNet一块算得比采集慢，false时放行
+void host_wakenet_hold(bool hold);
+
+#endif
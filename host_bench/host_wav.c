@@ -0,0 +1,71 @@
+#include "host_wav.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+static uint32_t read_le(const uint8_t *p, int bytes)
+{
+    uint32_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        v = v << 8 | p[i];
+    }
+    return v;
+}
+
+//读16位单声道PCM的WAV文件
+int host_wav_read(const char *path, host_pcm_t *out)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return -1;
+    }
+
+    uint8_t hdr[12];
+    uint8_t chunk[8];
+    int ret = -1;
+    bool fmt_ok = false;
+    if (fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr) || memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0) {
+        fprintf(stderr, "%s: not a WAV file\n", path);
+        goto done;
+    }
+
+    while (fread(chunk, 1, sizeof(chunk), f) == sizeof(chunk)) {
+        uint32_t size = read_le(chunk + 4, 4);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            if (size < sizeof(fmt) || fread(fmt, 1, sizeof(fmt), f) != sizeof(fmt)) {
+                break;
+            }
+            fseek(f, (long)(size - sizeof(fmt) + (size & 1)), SEEK_CUR);
+            out->sample_rate = read_le(fmt + 4, 4);
+            fmt_ok = read_le(fmt, 2) == 1 && read_le(fmt + 2, 2) == 1 && read_le(fmt + 14, 2) == 16;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!fmt_ok) {
+                break;
+            }
+            out->count = size / sizeof(int16_t);
+            out->pcm = malloc(out->count * sizeof(int16_t));
+            uint8_t *raw = (uint8_t *)out->pcm;
+            if (out->pcm == NULL || fread(raw, sizeof(int16_t), out->count, f) != out->count) {
+                break;
+            }
+            //文件是小端，样本按小端解码
+            for (size_t i = 0; i < out->count; i++) {
+                out->pcm[i] = (int16_t)read_le(raw + 2 * i, 2);
+            }
+            ret = 0;
+            break;
+        } else {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    if (ret != 0) {
+        fprintf(stderr, "%s: need 16-bit mono PCM\n", path);
+    }
+
+done:
+    fclose(f);
+    return ret;
+}
@@ -0,0 +1,17 @@
+#ifndef __HOST_WAV_H_
+#define __HOST_WAV_H_
+
+//主机测试读录音用：16位单声道PCM的WAV文件
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+    int16_t *pcm;
+    size_t count;
+    uint32_t sample_rate;
+} host_pcm_t;
+
+//读整个文件，pcm用free释放，失败时打印原因并返回-1
+int host_wav_read(const char *path, host_pcm_t *out);
+
+#endif
@@ -0,0 +1,82 @@
+#include "host_websocket.h"
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+static pthread_mutex_t ws_lock = PTHREAD_MUTEX_INITIALIZER;
+static host_ws_packet_t ws_log[HOST_WS_LOG_MAX];
+static size_t ws_log_count = 0;
+static int16_t ws_samples[HOST_WS_SAMPLES_MAX];
+static size_t ws_sample_count = 0;
+static volatile bool ws_hold = false;
+static volatile bool ws_blocked = false;
+
+esp_websocket_client_handle_t ws_client = NULL;
+
+void host_ws_hold(bool hold)
+{
+    ws_hold = hold;
+}
+
+bool host_ws_blocked(void)
+{
+    return ws_blocked;
+}
+
+size_t host_ws_log(host_ws_packet_t *out, size_t max)
+{
+    pthread_mutex_lock(&ws_lock);
+    size_t count = ws_log_count < max ? ws_log_count : max;
+    memcpy(out, ws_log, count * sizeof(ws_log[0]));
+    count = ws_log_count;
+    pthread_mutex_unlock(&ws_lock);
+    return count;
+}
+
+const int16_t *host_ws_samples(void)
+{
+    return ws_samples;
+}
+
+bool esp_websocket_client_is_connected(esp_websocket_client_handle_t client)
+{
+    return true;
+}
+
+//iov[0]是帧头，后面是音频数据
+int esp_websocket_client_send_bin_iov(esp_websocket_client_handle_t client, const esp_websocket_iov_t *iov, int iovcnt,
+                                      TickType_t timeout)
+{
+    ws_blocked = ws_hold;
+    while (ws_hold) {
+        usleep(1000);
+    }
+    ws_blocked = false;
+
+    int len = 0;
+    pthread_mutex_lock(&ws_lock);
+    if (ws_log_count < HOST_WS_LOG_MAX && iovcnt > 0 && iov[0].len == sizeof(audio_packet_header_t)) {
+        host_ws_packet_t *packet = &ws_log[ws_log_count++];
+        memcpy(&packet->header, iov[0].data, sizeof(packet->header));
+        packet->offset = ws_sample_count;
+        packet->count = 0;
+        for (int i = 1; i < iovcnt; i++) {
+            size_t n = iov[i].len / sizeof(int16_t);
+            n = n < HOST_WS_SAMPLES_MAX - ws_sample_count ? n : HOST_WS_SAMPLES_MAX - ws_sample_count;
+            memcpy(ws_samples + ws_sample_count, iov[i].data, n * sizeof(int16_t));
+            ws_sample_count += n;
+            packet->count += n;
+        }
+    }
+    pthread_mutex_unlock(&ws_lock);
+
+    //原地加掩码
+    for (int i = 0; i < iovcnt; i++) {
+        uint8_t *p = iov[i].data;
+        for (size_t j = 0; j < iov[i].len; j++) {
+            p[j] ^= 0xa5;
+        }
+        len += (int)iov[i].len;
+    }
+    return len;
+}
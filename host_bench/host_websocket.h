@@ -0,0 +1,32 @@
+#ifndef __HOST_WEBSOCKET_H_
+#define __HOST_WEBSOCKET_H_
+
+//主机上模拟的websocket客户端：实现上行用到的发送接口，记录每个二进制帧
+//和真实客户端一样，发送时帧头和数据原地加掩码，发送后再读缓冲就是错的
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_websocket_client.h"
+#include "audio_packet.h"
+
+//记录的帧数和样本数上限，超出的不记录
+#define HOST_WS_LOG_MAX     256
+#define HOST_WS_SAMPLES_MAX (256 * 1024)
+
+//一个二进制帧：帧头和数据在样本记录里的位置
+typedef struct {
+    audio_packet_header_t header;
+    size_t offset; //第一个样本在host_ws_samples里的下标
+    size_t count;  //样本数
+} host_ws_packet_t;
+
+//hold为true时发送阻塞，模拟网络卡住，false时放行
+void host_ws_hold(bool hold);
+//发送接口是否正被hold挡着
+bool host_ws_blocked(void);
+//复制发送记录，返回总的帧数
+size_t host_ws_log(host_ws_packet_t *out, size_t max);
+//记录下的样本，按发送顺序连续存放
+const int16_t *host_ws_samples(void);
+
+#endif
@@ -0,0 +1,58 @@
+#include "audio_jitter.h"
+#include "host_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+//抖动缓冲丢包降延迟的主机测试：连续的正弦按包送进去，取得比送得慢，缓冲变深后开始丢包
+//接缝处交叉淡化，输出相邻样本的跳变不能超过正弦本身的最大斜率太多
+#define SAMPLE_RATE 16000
+#define PACKET      320   //20ms
+#define PACKETS     400
+#define TONE_HZ     440.0
+#define TONE_AMP    10000.0
+#define SETTLE      2000  //开头的缓冲静音和淡入不算
+
+static int16_t pcm[PACKET];
+static int16_t out[PACKET];
+
+int main(void)
+{
+    static audio_jitter_t jb;
+    if (audio_jitter_init(&jb, SAMPLE_RATE, 2 * PACKET, 40, 200) != ESP_OK) {
+        fprintf(stderr, "setup failed\n");
+        return 1;
+    }
+
+    //正弦相邻样本的最大差，留一成余量给交叉淡化的舍入
+    int step_max = (int)(TONE_AMP * 2.0 * M_PI * TONE_HZ / SAMPLE_RATE * 1.1) + 1;
+    int prev = 0;
+    int jump_max = 0;
+    long played = 0;
+    for (uint32_t seq = 0; seq < PACKETS; seq++) {
+        for (int i = 0; i < PACKET; i++) {
+            pcm[i] = (int16_t)lrint(TONE_AMP * sin(2.0 * M_PI * TONE_HZ * ((double)seq * PACKET + i) / SAMPLE_RATE));
+        }
+        audio_jitter_push(&jb, seq, AUDIO_CODEC_PCM, (const uint8_t *)pcm, sizeof(pcm));
+        //每三包少取一次，缓冲比目标深以后就要丢包
+        if (seq % 3 == 0) {
+            continue;
+        }
+        size_t n = audio_jitter_pop(&jb, out, PACKET);
+        for (size_t i = 0; i < n; i++, played++) {
+            int jump = abs(out[i] - prev);
+            if (played > SETTLE && jump > jump_max) {
+                jump_max = jump;
+            }
+            prev = out[i];
+        }
+    }
+
+    audio_jitter_stats_t stats;
+    audio_jitter_get_stats(&jb, &stats);
+    CHECK(stats.trimmed > 0, "no packet trimmed");
+    CHECK(stats.concealed == 0, "%lu frames concealed", (unsigned long)stats.concealed);
+    CHECK(jump_max <= step_max, "jump of %d at a splice, tone steps at most %d", jump_max, step_max);
+    printf("%lu packets trimmed, largest step %d (tone %d)\n", (unsigned long)stats.trimmed, jump_max, step_max);
+    return host_test_result();
+}
@@ -0,0 +1,161 @@
+#include "audio_pipeline.h"
+#include "audio_chain.h"
+#include "host_i2s.h"
+#include "esp_timer.h"
+#include "host_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+//流水线的主机测试：测试线程扮演RX DMA，模拟的spk_write记录播放的帧
+//每个DMA缓冲的样本都填成它的序号，从播放记录里就能看出顺序、丢帧和重复
+#define TEST_FRAMES  50
+#define TEST_EXTRA   5 //播放卡住时比帧环多送的帧数
+
+static int16_t *rx_buf = NULL;
+static int16_t next_value = 0;
+static volatile uint32_t chain_calls = 0;
+
+//处理级：只计数，确认每帧都经过处理链
+static esp_err_t count_stage(void *ctx, audio_frame_t *frame)
+{
+    chain_calls++;
+    return ESP_OK;
+}
+
+static audio_pipeline_stats_t stats_now(void)
+{
+    audio_pipeline_stats_t s;
+    audio_pipeline_get_stats(&s);
+    return s;
+}
+
+#define wait_captured(target) WAIT_UNTIL(stats_now().captured >= (uint32_t)(target))
+#define wait_played(target)   WAIT_UNTIL(stats_now().played >= (uint32_t)(target))
+
+//送一个DMA缓冲，样本值为下一个序号
+static int16_t push_frame(void)
+{
+    size_t samples = mic_frame_bytes() / sizeof(int16_t);
+    int16_t value = next_value++;
+    for (size_t i = 0; i < samples; i++) {
+        rx_buf[i] = value;
+    }
+    host_i2s_rx_push(rx_buf, mic_frame_bytes(), esp_timer_get_time());
+    return value;
+}
+
+//播放记录从first开始的count条应该是序号from开始连续的完整帧
+static void check_played(const host_i2s_tx_record_t *log, size_t first, size_t count, int16_t from)
+{
+    for (size_t i = 0; i < count; i++) {
+        CHECK(log[first + i].size == mic_frame_bytes(), "write %zu: %zu bytes", first + i, log[first + i].size);
+        CHECK(log[first + i].value == from + (int32_t)i, "write %zu: value %d, expected %d", first + i,
+              log[first + i].value, from + (int)i);
+    }
+}
+
+//按采集节奏送帧，每帧都原样、按顺序播放，不丢帧
+static void test_handoff(void)
+{
+    int16_t from = next_value;
+    for (int i = 0; i < TEST_FRAMES; i++) {
+        push_frame();
+        CHECK(wait_captured(i + 1), "frame %d not captured", i);
+    }
+    CHECK(wait_played(TEST_FRAMES), "only %lu of %d frames played", (unsigned long)stats_now().played, TEST_FRAMES);
+
+    static host_i2s_tx_record_t log[HOST_I2S_TX_LOG_MAX];
+    size_t count = host_i2s_tx_log(log, HOST_I2S_TX_LOG_MAX);
+    CHECK(count == TEST_FRAMES, "%zu writes", count);
+    check_played(log, 0, TEST_FRAMES, from);
+
+    audio_pipeline_stats_t s = stats_now();
+    CHECK(s.dropped == 0, "%lu frames dropped", (unsigned long)s.dropped);
+    CHECK(chain_calls == TEST_FRAMES, "chain ran %lu times", (unsigned long)chain_calls);
+    printf("handoff: %d frames played in order, latency max %lld us\n", TEST_FRAMES, (long long)s.latency_max_us);
+}
+
+//播放卡住：正在写的一帧加上帧环里的AUDIO_FRAME_NUM帧之外的都被丢掉，恢复后按顺序播放留下的帧
+static void test_drop(void)
+{
+    audio_pipeline_stats_t before = stats_now();
+    static host_i2s_tx_record_t log[HOST_I2S_TX_LOG_MAX];
+    size_t written = host_i2s_tx_log(log, HOST_I2S_TX_LOG_MAX);
+
+    host_i2s_tx_hold(true);
+    int16_t from = next_value;
+    int pushed = AUDIO_FRAME_NUM + TEST_EXTRA;
+    for (int i = 0; i < pushed; i++) {
+        push_frame();
+        CHECK(wait_captured(before.captured + i + 1), "frame %d not captured", i);
+    }
+
+    audio_pipeline_stats_t s = stats_now();
+    uint32_t dropped = s.dropped - before.dropped;
+    //播放任务取出的那一帧还占着槽，帧环里一共只能留AUDIO_FRAME_NUM帧
+    CHECK(dropped == (uint32_t)(pushed - AUDIO_FRAME_NUM), "%lu dropped, expected %d", (unsigned long)dropped,
+          pushed - AUDIO_FRAME_NUM);
+
+    host_i2s_tx_hold(false);
+    CHECK(wait_played(before.played + AUDIO_FRAME_NUM), "stalled frames not played");
+    usleep(100 * 1000);
+    size_t count = host_i2s_tx_log(log, HOST_I2S_TX_LOG_MAX);
+    CHECK(count == written + AUDIO_FRAME_NUM, "%zu writes after the stall, expected %zu", count - written,
+          (size_t)AUDIO_FRAME_NUM);
+    //丢的是最新的帧，留下的是卡住之前最早进来的那几帧
+    check_played(log, written, AUDIO_FRAME_NUM, from);
+    printf("drop: %lu of %d frames dropped while playback stalled, the rest played in order\n",
+           (unsigned long)dropped, pushed);
+}
+
+//没有采集数据时，播放任务每两帧时间记一次欠载，数据恢复后照常播放
+static void test_underrun(void)
+{
+    const audio_dma_profile_t *profile = audio_pipeline_get_profile();
+    uint32_t period_ms = profile->frame_num * 1000 / MIC_SAMPLE_RATE;
+    uint32_t idle_ms = 10 * period_ms;
+
+    audio_pipeline_stats_t before = stats_now();
+    usleep(idle_ms * 1000);
+    audio_pipeline_stats_t s = stats_now();
+    uint32_t underrun = s.underrun - before.underrun;
+    //超时是两帧加一个tick，idle_ms内4到5次，调度抖动再留一次余量
+    CHECK(underrun >= 3 && underrun <= 5, "%lu underruns in %lu ms", (unsigned long)underrun, (unsigned long)idle_ms);
+    CHECK(s.played == before.played, "played changed while idle");
+
+    push_frame();
+    CHECK(wait_played(before.played + 1), "no playback after the underrun");
+    printf("underrun: %lu underruns in %lu ms idle, playback resumed\n", (unsigned long)underrun,
+           (unsigned long)idle_ms);
+}
+
+int main(void)
+{
+    const audio_dma_profile_t *profile = audio_pipeline_get_profile();
+    if (i2s_tx_init(profile) != ESP_OK || i2s_rx_init(profile) != ESP_OK || audio_chain_init() != ESP_OK) {
+        fprintf(stderr, "setup failed\n");
+        return 1;
+    }
+    rx_buf = malloc(mic_frame_bytes());
+
+    audio_stage_t stage = {
+        .name = "count",
+        .process = count_stage,
+        .ctx = NULL,
+    };
+    if (rx_buf == NULL || audio_chain_register(&stage, -1) != ESP_OK || audio_pipeline_init() != ESP_OK ||
+        audio_pipeline_start() != ESP_OK) {
+        fprintf(stderr, "pipeline start failed\n");
+        return 1;
+    }
+
+    //任务是异步启动的，采集任务注册通知之前送的缓冲不会唤醒它
+    CHECK(WAIT_UNTIL(host_i2s_rx_ready()), "capture task did not start");
+
+    test_handoff();
+    test_drop();
+    test_underrun();
+
+    return host_test_result();
+}
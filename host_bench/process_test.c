@@ -0,0 +1,179 @@
+#include "audio_process.h"
+#include "audio_simd.h"
+#include "audio_bench.h"
+#include "host_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//增益和压缩内核的主机测试：随机缓冲上Q31内核对照浮点内核，选中的增益限幅内核（32位和16位）对照标量版本逐位一致
+//数据和板上基准一样是INMP441量级，缓冲长度和起点随机，覆盖不成块的尾部和不对齐的起点
+#define MAX_SAMPLES 1024
+#define ROUNDS      64 //每组参数的随机缓冲数
+
+static uint32_t seed = 0x12345678;
+
+static uint32_t test_rand(void)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return seed;
+}
+
+//24位有效位放在32位容器的高位，留出一些余量，增益后一部分样本会饱和
+static void fill(int32_t *samples, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = ((int32_t)test_rand() >> 8) << 4;
+    }
+}
+
+//随机长度和起点，起点在16字节对齐的缓冲里偏移0到3个样本
+static size_t random_span(size_t *offset)
+{
+    *offset = test_rand() % AUDIO_SIMD_LANES;
+    return 1 + test_rand() % (MAX_SAMPLES - AUDIO_SIMD_LANES);
+}
+
+//定点输出与浮点参考的误差不超过AUDIO_BENCH_REL_TOLERANCE，返回超出的样本数
+static int compare_tolerance(const char *name, const int32_t *out, const int32_t *ref, size_t count, int64_t *max_diff)
+{
+    int bad = 0;
+    for (size_t i = 0; i < count; i++) {
+        int64_t diff = llabs((int64_t)out[i] - ref[i]);
+        int64_t limit = (int64_t)(fabsf((float)ref[i]) * AUDIO_BENCH_REL_TOLERANCE) + 1;
+        *max_diff = diff > *max_diff ? diff : *max_diff;
+        if (diff > limit && bad++ == 0) {
+            fprintf(stderr, "%s: sample %zu %ld vs %ld\n", name, i, (long)out[i], (long)ref[i]);
+        }
+    }
+    return bad;
+}
+
+static int32_t src_buf[MAX_SAMPLES] __attribute__((aligned(16)));
+static int32_t ref_buf[MAX_SAMPLES] __attribute__((aligned(16)));
+static int32_t out_buf[MAX_SAMPLES] __attribute__((aligned(16)));
+
+static void test_amplify(void)
+{
+    static const float gains[] = { 1.0f, 3.0f, 15.0f, 64.0f, 127.0f, 2.5f, 0.3f, 0.0f };
+
+    for (size_t g = 0; g < sizeof(gains) / sizeof(gains[0]); g++) {
+        audio_processor_t proc = { .gain = gains[g], .compression_ratio = 1.0f };
+        audio_processor_update(&proc);
+        int64_t max_diff = 0;
+        int bad = 0;
+        for (int r = 0; r < ROUNDS; r++) {
+            size_t offset;
+            size_t count = random_span(&offset);
+            fill(src_buf + offset, count);
+            memcpy(ref_buf + offset, src_buf + offset, count * sizeof(int32_t));
+            memcpy(out_buf + offset, src_buf + offset, count * sizeof(int32_t));
+            amplify_audio_buffer(ref_buf + offset, count * sizeof(int32_t), proc.gain);
+            amplify_audio_buffer_q31(out_buf + offset, count * sizeof(int32_t), proc.gain_q24);
+            bad += compare_tolerance("amplify", out_buf + offset, ref_buf + offset, count, &max_diff);
+        }
+        CHECK(bad == 0, "amplify gain %.1f: %d samples outside the tolerance", gains[g], bad);
+        printf("amplify  gain %5.1f: max diff %lld LSB\n", gains[g], (long long)max_diff);
+    }
+}
+
+static void test_compress(void)
+{
+    static const struct {
+        float threshold;
+        float ratio;
+    } cases[] = {
+        { 10000000.0f, 1.0f },
+        { 10000000.0f, 2.0f },
+        { 100000000.0f, 4.0f },
+        { 1000000.0f, 3.7f },
+        { 0.0f, 20.0f },
+    };
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        audio_processor_t proc = { .gain = 1.0f, .compression_threshold = cases[c].threshold,
+                                   .compression_ratio = cases[c].ratio };
+        audio_processor_update(&proc);
+        int64_t max_diff = 0;
+        int bad = 0;
+        for (int r = 0; r < ROUNDS; r++) {
+            size_t offset;
+            size_t count = random_span(&offset);
+            fill(src_buf + offset, count);
+            memcpy(ref_buf + offset, src_buf + offset, count * sizeof(int32_t));
+            memcpy(out_buf + offset, src_buf + offset, count * sizeof(int32_t));
+            compress_audio_buffer(ref_buf + offset, count * sizeof(int32_t), proc.compression_threshold,
+                                  proc.compression_ratio);
+            compress_audio_buffer_q31(out_buf + offset, count * sizeof(int32_t), proc.compression_threshold_q31,
+                                      proc.inv_ratio_q31);
+            bad += compare_tolerance("compress", out_buf + offset, ref_buf + offset, count, &max_diff);
+        }
+        CHECK(bad == 0, "compress threshold %.0f ratio %.1f: %d samples outside the tolerance", cases[c].threshold,
+              cases[c].ratio, bad);
+        printf("compress threshold %10.0f ratio %4.1f: max diff %lld LSB\n", cases[c].threshold, cases[c].ratio,
+               (long long)max_diff);
+    }
+}
+
+//构建时选中的内核（ESP32-S3上是PIE）必须和标量版本逐位一致，对齐、不对齐、整数和小数增益都要覆盖
+static void test_gain_limit(void)
+{
+    static const float gains[] = { 1.0f, 3.0f, 15.0f, 64.0f, 2.5f, 0.3f };
+    static const int32_t limits[] = { INT32_MAX, 1 << 27 };
+
+    for (size_t g = 0; g < sizeof(gains) / sizeof(gains[0]); g++) {
+        for (size_t l = 0; l < sizeof(limits) / sizeof(limits[0]); l++) {
+            int mismatch = 0;
+            for (int r = 0; r < ROUNDS; r++) {
+                size_t offset;
+                size_t count = random_span(&offset);
+                fill(src_buf + offset, count);
+                memcpy(ref_buf + offset, src_buf + offset, count * sizeof(int32_t));
+                memcpy(out_buf + offset, src_buf + offset, count * sizeof(int32_t));
+                audio_gain_limit_scalar(ref_buf + offset, count, GAIN_TO_Q24(gains[g]), limits[l]);
+                audio_gain_limit(out_buf + offset, count, GAIN_TO_Q24(gains[g]), limits[l]);
+                for (size_t i = 0; i < count; i++) {
+                    mismatch += out_buf[offset + i] != ref_buf[offset + i];
+                }
+            }
+            CHECK(mismatch == 0, "gain limit gain %.1f limit %ld: %d samples differ from the scalar kernel",
+                  gains[g], (long)limits[l], mismatch);
+        }
+    }
+}
+
+//16位版本：选中的内核（ESP32-S3上增益能写成16位整数除以2的幂时是PIE）和标量版本逐位一致
+static void test_gain_limit_s16(void)
+{
+    static const float gains[] = { 1.0f, 3.0f, 15.0f, 64.0f, 127.0f, 2.5f, 0.75f, 0.3f, -2.0f };
+    static int16_t ref16[MAX_SAMPLES] __attribute__((aligned(16)));
+    static int16_t out16[MAX_SAMPLES] __attribute__((aligned(16)));
+
+    for (size_t g = 0; g < sizeof(gains) / sizeof(gains[0]); g++) {
+        int mismatch = 0;
+        for (int r = 0; r < ROUNDS; r++) {
+            size_t offset;
+            size_t count = random_span(&offset);
+            for (size_t i = 0; i < count; i++) {
+                ref16[offset + i] = (int16_t)(test_rand() >> 16);
+            }
+            memcpy(out16 + offset, ref16 + offset, count * sizeof(int16_t));
+            audio_gain_limit_s16_scalar(ref16 + offset, count, GAIN_TO_Q24(gains[g]));
+            audio_gain_limit_s16(out16 + offset, count, GAIN_TO_Q24(gains[g]));
+            for (size_t i = 0; i < count; i++) {
+                mismatch += out16[offset + i] != ref16[offset + i];
+            }
+        }
+        CHECK(mismatch == 0, "s16 gain %.2f: %d samples differ from the scalar kernel", gains[g], mismatch);
+    }
+}
+
+int main(void)
+{
+    test_amplify();
+    test_compress();
+    test_gain_limit();
+    test_gain_limit_s16();
+    return host_test_result();
+}
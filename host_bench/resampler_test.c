@@ -0,0 +1,225 @@
+#include "audio_resampler.h"
+#include "host_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+//重采样器的主机测试：通带纹波、混叠（升采样时是镜像）抑制，以及按不同块长流式处理的结果一致
+//门限和板上audio_bench.c的验收一致：通带到较低采样率的0.3倍纹波不超过0.5dB，
+//降采样时从输出采样率的0.625倍起抑制至少60dB
+#define RIPPLE_DB    0.5f
+#define REJECTION_DB 60.0f
+
+#define AMPLITUDE   16000.0
+#define TONE_IN     32768  //每个测试音的输入样本数
+#define SETTLE      (2 * AUDIO_RESAMPLER_TAPS) //输出开头跳过的样本数，等滤波器填满
+#define BLOCK_MAX   512
+
+
+static int16_t in_buf[TONE_IN];
+static int16_t out_buf[TONE_IN * 6 + 16];
+
+//按BLOCK_MAX分块送入，返回输出样本数
+static size_t run_blocks(audio_resampler_t *rs, const int16_t *in, size_t count, int16_t *out)
+{
+    size_t produced = 0;
+    for (size_t pos = 0; pos < count; pos += BLOCK_MAX) {
+        size_t n = count - pos < BLOCK_MAX ? count - pos : BLOCK_MAX;
+        size_t got;
+        audio_resampler_process(rs, in + pos, n, out + produced, &got);
+        produced += got;
+    }
+    return produced;
+}
+
+//输出里频率为freq的正弦用最小二乘拟合，gain_db为它相对输入的增益，residual_db为其余成分相对输入的功率
+//输入的freq在输出采样率上超过奈奎斯特频率时不拟合，全部输出都算作residual
+static void tone_response(uint32_t in_rate, uint32_t out_rate, double freq, double *gain_db, double *residual_db)
+{
+    audio_resampler_t rs;
+    if (audio_resampler_init(&rs, in_rate, out_rate, BLOCK_MAX) != ESP_OK) {
+        CHECK(false, "init %lu->%lu failed", (unsigned long)in_rate, (unsigned long)out_rate);
+        *gain_db = *residual_db = 0.0;
+        return;
+    }
+    for (size_t i = 0; i < TONE_IN; i++) {
+        in_buf[i] = (int16_t)lrint(AMPLITUDE * sin(2.0 * M_PI * freq * i / in_rate));
+    }
+    size_t produced = run_blocks(&rs, in_buf, TONE_IN, out_buf);
+    audio_resampler_deinit(&rs);
+
+    //解2x2正规方程
+    double cc = 0.0, ss = 0.0, cs = 0.0, yc = 0.0, ys = 0.0, yy = 0.0;
+    bool in_band = freq < out_rate * 0.5;
+    double w = 2.0 * M_PI * freq / out_rate;
+    for (size_t n = SETTLE; n < produced; n++) {
+        double y = out_buf[n];
+        yy += y * y;
+        if (in_band) {
+            double c = cos(w * n), s = sin(w * n);
+            cc += c * c;
+            ss += s * s;
+            cs += c * s;
+            yc += y * c;
+            ys += y * s;
+        }
+    }
+    double a = 0.0, b = 0.0;
+    double det = cc * ss - cs * cs;
+    if (in_band && det > 0.0) {
+        a = (yc * ss - ys * cs) / det;
+        b = (ys * cc - yc * cs) / det;
+    }
+    size_t count = produced - SETTLE;
+    double fitted = a * yc + b * ys; //拟合出的正弦的能量
+    double input_power = AMPLITUDE * AMPLITUDE / 2.0;
+    *gain_db = 20.0 * log10(sqrt(a * a + b * b) / AMPLITUDE + 1e-12);
+    *residual_db = 10.0 * log10(fmax(yy - fitted, 0.0) / count / input_power + 1e-15);
+}
+
+//一组采样率：通带内测增益和失真，降采样时在阻带测混叠
+static void test_rates(uint32_t in_rate, uint32_t out_rate)
+{
+    double low_rate = in_rate < out_rate ? in_rate : out_rate;
+    double ripple = 0.0;
+    double spurious = -300.0;
+
+    for (double f = 100.0; f <= low_rate * 0.3; f += low_rate * 0.0125) {
+        double gain, residual;
+        tone_response(in_rate, out_rate, f, &gain, &residual);
+        ripple = fabs(gain) > ripple ? fabs(gain) : ripple;
+        spurious = residual > spurious ? residual : spurious;
+        CHECK(fabs(gain) <= RIPPLE_DB, "%lu->%lu: %.0f Hz gain %.2f dB", (unsigned long)in_rate,
+              (unsigned long)out_rate, f, gain);
+        //升采样的镜像、降采样的混叠和定点截断都在拟合的残差里
+        CHECK(residual <= -REJECTION_DB, "%lu->%lu: %.0f Hz spurious %.1f dB", (unsigned long)in_rate,
+              (unsigned long)out_rate, f, residual);
+    }
+
+    double rejection = 300.0;
+    if (in_rate > out_rate) {
+        for (double f = out_rate * 0.625; f < in_rate * 0.5; f += out_rate * 0.0125) {
+            double gain, residual;
+            tone_response(in_rate, out_rate, f, &gain, &residual);
+            //阻带的正弦落在输出奈奎斯特频率以上时拟合不到，全部输出都是混叠
+            double leak = f < out_rate * 0.5 ? 10.0 * log10(pow(10.0, gain / 10.0) + pow(10.0, residual / 10.0))
+                                             : residual;
+            rejection = -leak < rejection ? -leak : rejection;
+            CHECK(-leak >= REJECTION_DB, "%lu->%lu: %.0f Hz rejected only %.1f dB", (unsigned long)in_rate,
+                  (unsigned long)out_rate, f, -leak);
+        }
+    }
+
+    printf("%5lu->%-5lu ripple %.3f dB to %.0f Hz, spurious %.1f dB", (unsigned long)in_rate, (unsigned long)out_rate,
+           ripple, low_rate * 0.3, spurious);
+    if (in_rate > out_rate) {
+        printf(", rejection %.1f dB from %.0f Hz", rejection, out_rate * 0.625);
+    }
+    printf("\n");
+}
+
+//流式处理：同样的输入按不规则的块长送入，输出逐样本相同，输出总数等于按比例算出的个数
+static void test_streaming(uint32_t in_rate, uint32_t out_rate)
+{
+    static const size_t blocks[] = { 1, 97, 512, 3, 256, 160, 441 };
+    audio_resampler_t whole, pieces;
+    if (audio_resampler_init(&whole, in_rate, out_rate, BLOCK_MAX) != ESP_OK ||
+        audio_resampler_init(&pieces, in_rate, out_rate, BLOCK_MAX) != ESP_OK) {
+        CHECK(false, "init %lu->%lu failed", (unsigned long)in_rate, (unsigned long)out_rate);
+        return;
+    }
+
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < TONE_IN; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        in_buf[i] = (int16_t)(seed >> 18) - 8192;
+    }
+
+    size_t expected = run_blocks(&whole, in_buf, TONE_IN, out_buf);
+    int16_t *reference = malloc(expected * sizeof(int16_t));
+    int16_t *piece_out = malloc((audio_resampler_max_out(&pieces) + 1) * sizeof(int16_t));
+    if (reference == NULL || piece_out == NULL) {
+        CHECK(false, "out of memory");
+        free(reference);
+        free(piece_out);
+        return;
+    }
+    memcpy(reference, out_buf, expected * sizeof(int16_t));
+
+    size_t produced = 0;
+    size_t mismatch = 0;
+    size_t pos = 0;
+    for (int b = 0; pos < TONE_IN; b = (b + 1) % (int)(sizeof(blocks) / sizeof(blocks[0]))) {
+        size_t n = TONE_IN - pos < blocks[b] ? TONE_IN - pos : blocks[b];
+        size_t got;
+        audio_resampler_process(&pieces, in_buf + pos, n, piece_out, &got);
+        CHECK(got <= audio_resampler_max_out(&pieces), "%zu outputs exceed max_out", got);
+        for (size_t i = 0; i < got && produced + i < expected; i++) {
+            mismatch += piece_out[i] != reference[produced + i];
+        }
+        produced += got;
+        pos += n;
+    }
+
+    //输出个数：第k个输出对应输入位置k*down/up
+    size_t ideal = (size_t)(((uint64_t)TONE_IN * whole.up + whole.down - 1) / whole.down);
+    CHECK(produced == expected, "%lu->%lu: %zu outputs in pieces, %zu in whole blocks", (unsigned long)in_rate,
+          (unsigned long)out_rate, produced, expected);
+    CHECK(expected == ideal, "%lu->%lu: %zu outputs, expected %zu", (unsigned long)in_rate, (unsigned long)out_rate,
+          expected, ideal);
+    CHECK(mismatch == 0, "%lu->%lu: %zu samples differ between block sizes", (unsigned long)in_rate,
+          (unsigned long)out_rate, mismatch);
+
+    free(reference);
+    free(piece_out);
+    audio_resampler_deinit(&whole);
+    audio_resampler_deinit(&pieces);
+}
+
+//超过max_in的块不处理：返回错误、计数，状态不变，之后的输出和没送过这一块一样
+static void test_oversized(void)
+{
+    audio_resampler_t rs, ref;
+    if (audio_resampler_init(&rs, 44100, 16000, BLOCK_MAX) != ESP_OK ||
+        audio_resampler_init(&ref, 44100, 16000, BLOCK_MAX) != ESP_OK) {
+        CHECK(false, "audio_resampler_init failed");
+        return;
+    }
+
+    size_t produced = 1;
+    esp_err_t ret = audio_resampler_process(&rs, in_buf, BLOCK_MAX + 1, out_buf, &produced);
+    CHECK(ret == ESP_ERR_INVALID_SIZE, "oversized block returned %d", ret);
+    CHECK(produced == 0, "oversized block produced %zu outputs", produced);
+    CHECK(rs.rejected == BLOCK_MAX + 1, "rejected %lu samples, expected %d", (unsigned long)rs.rejected,
+          BLOCK_MAX + 1);
+
+    size_t got = run_blocks(&rs, in_buf, TONE_IN, out_buf);
+    size_t expected = run_blocks(&ref, in_buf, TONE_IN, out_buf + got);
+    CHECK(got == expected && memcmp(out_buf, out_buf + got, got * sizeof(int16_t)) == 0,
+          "output changed after an oversized block");
+
+    audio_resampler_deinit(&rs);
+    audio_resampler_deinit(&ref);
+}
+
+int main(void)
+{
+    //默认的44.1k采集，以及Kconfig允许的其他常见组合
+    static const uint32_t rates[][2] = {
+        { 44100, 16000 },
+        { 48000, 16000 },
+        { 32000, 16000 },
+        { 22050, 16000 },
+        { 8000, 16000 },
+    };
+
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        test_rates(rates[i][0], rates[i][1]);
+        test_streaming(rates[i][0], rates[i][1]);
+    }
+    test_oversized();
+
+    return host_test_result();
+}
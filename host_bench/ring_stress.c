@@ -0,0 +1,146 @@
+#include "audio_ring.h"
+#include "esp_heap_caps.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <sched.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdatomic.h>
+
+//环形缓冲的主机压力测试：一个生产者线程、一个消费者线程，校验顺序和内容，不对就返回1
+#define STRESS_ITEMS   200000
+#define STRESS_PAYLOAD 200
+#define STRESS_TIMEOUT pdMS_TO_TICKS(2000)
+
+typedef struct {
+    uint32_t seq;
+    uint32_t len;
+    uint8_t data[STRESS_PAYLOAD];
+} stress_item_t;
+
+typedef struct {
+    audio_ring_t ring;
+    uint32_t items;
+    bool pause;     //偶尔停一下，让另一侧走到阻塞等待
+    atomic_bool failed;
+} stress_ctx_t;
+
+static double stress_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t stress_rand(uint32_t *seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed;
+}
+
+static void *stress_producer(void *arg)
+{
+    stress_ctx_t *ctx = arg;
+    uint32_t seed = 1;
+
+    for (uint32_t seq = 0; seq < ctx->items && !ctx->failed; seq++) {
+        //一半用非阻塞接口自旋，一半用阻塞接口
+        stress_item_t *item = NULL;
+        if (seq & 1) {
+            item = audio_ring_reserve_wait(&ctx->ring, STRESS_TIMEOUT);
+        } else {
+            while ((item = audio_ring_reserve(&ctx->ring)) == NULL) {
+                sched_yield();
+            }
+        }
+        if (item == NULL) {
+            fprintf(stderr, "producer timed out at %u\n", seq);
+            ctx->failed = true;
+            break;
+        }
+
+        item->seq = seq;
+        item->len = 1 + seq % STRESS_PAYLOAD;
+        for (uint32_t i = 0; i < item->len; i++) {
+            item->data[i] = (uint8_t)(seq * 31 + i);
+        }
+        audio_ring_commit(&ctx->ring);
+
+        if (ctx->pause && (stress_rand(&seed) & 0x3fff) == 0) {
+            usleep(2000);
+        }
+    }
+    return NULL;
+}
+
+static void *stress_consumer(void *arg)
+{
+    stress_ctx_t *ctx = arg;
+    uint32_t seed = 2;
+
+    for (uint32_t seq = 0; seq < ctx->items && !ctx->failed; seq++) {
+        stress_item_t *item = audio_ring_peek_wait(&ctx->ring, STRESS_TIMEOUT);
+        if (item == NULL) {
+            fprintf(stderr, "consumer timed out at %u\n", seq);
+            ctx->failed = true;
+            break;
+        }
+
+        bool ok = item->seq == seq && item->len == 1 + seq % STRESS_PAYLOAD;
+        for (uint32_t i = 0; ok && i < item->len; i++) {
+            ok = item->data[i] == (uint8_t)(seq * 31 + i);
+        }
+        if (!ok) {
+            fprintf(stderr, "corrupt item: expected seq %u, got %u\n", seq, item->seq);
+            ctx->failed = true;
+            break;
+        }
+        audio_ring_release(&ctx->ring);
+
+        if (ctx->pause && (stress_rand(&seed) & 0x3fff) == 0) {
+            usleep(2000);
+        }
+    }
+    return NULL;
+}
+
+//跑一轮，返回是否通过
+static bool stress_run(uint32_t slot_num, bool pause)
+{
+    static stress_ctx_t ctx;
+    ctx.items = STRESS_ITEMS;
+    ctx.pause = pause;
+    ctx.failed = false;
+    if (audio_ring_init(&ctx.ring, sizeof(stress_item_t), slot_num, MALLOC_CAP_INTERNAL) != ESP_OK) {
+        fprintf(stderr, "ring init failed\n");
+        return false;
+    }
+
+    double start = stress_now_ns();
+    pthread_t producer, consumer;
+    pthread_create(&consumer, NULL, stress_consumer, &ctx);
+    pthread_create(&producer, NULL, stress_producer, &ctx);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    double ns = stress_now_ns() - start;
+
+    bool ok = !ctx.failed && audio_ring_count(&ctx.ring) == 0;
+    printf("%2u slots %-8s %s  %7.1f ns/item\n", (unsigned)slot_num, pause ? "pausing" : "flat-out",
+           ok ? "ok  " : "FAIL", ns / ctx.items);
+    audio_ring_deinit(&ctx.ring);
+    return ok;
+}
+
+int main(void)
+{
+    static const uint32_t slot_nums[] = { 1, 2, 5, 8 };
+    bool ok = true;
+
+    for (size_t i = 0; i < sizeof(slot_nums) / sizeof(slot_nums[0]); i++) {
+        ok &= stress_run(slot_nums[i], false);
+        ok &= stress_run(slot_nums[i], true);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,6 @@
+#ifndef __HOST_GPIO_H_
+#define __HOST_GPIO_H_
+
+//主机构建用的gpio.h，引脚号只出现在没有展开的宏里
+
+#endif
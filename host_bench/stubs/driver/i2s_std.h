@@ -0,0 +1,7 @@
+#ifndef __HOST_I2S_STD_H_
+#define __HOST_I2S_STD_H_
+
+//主机构建用的i2s_std.h，只有驱动头文件里出现的句柄类型，驱动本身由host_i2s.c模拟
+typedef struct i2s_channel_obj_t *i2s_chan_handle_t;
+
+#endif
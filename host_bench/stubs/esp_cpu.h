@@ -0,0 +1,15 @@
+#ifndef __HOST_ESP_CPU_H_
+#define __HOST_ESP_CPU_H_
+
+//主机构建用的esp_cpu.h，周期计数用单调时钟的纳秒数代替
+#include <stdint.h>
+#include <time.h>
+
+static inline uint32_t esp_cpu_get_cycle_count(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+#endif
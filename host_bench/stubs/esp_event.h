@@ -0,0 +1,18 @@
+#ifndef __HOST_ESP_EVENT_H_
+#define __HOST_ESP_EVENT_H_
+
+//主机构建用的esp_event.h，没有事件循环，esp_event_post由测试实现并记录
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef const char *esp_event_base_t;
+
+#define ESP_EVENT_DECLARE_BASE(id) extern esp_event_base_t const id
+#define ESP_EVENT_DEFINE_BASE(id) esp_event_base_t const id = #id
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id, const void *event_data,
+                         size_t event_data_size, TickType_t ticks_to_wait);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef __HOST_ESP_HEAP_CAPS_H_
+#define __HOST_ESP_HEAP_CAPS_H_
+
+//主机构建用的esp_heap_caps.h，内存能力标志被忽略，全部走libc
+#include <stdlib.h>
+#include <string.h>
+
+#define MALLOC_CAP_INTERNAL (1 << 0)
+#define MALLOC_CAP_SPIRAM   (1 << 1)
+#define MALLOC_CAP_DMA      (1 << 2)
+#define MALLOC_CAP_8BIT     (1 << 3)
+
+static inline void *heap_caps_malloc(size_t size, unsigned caps)
+{
+    return malloc(size);
+}
+
+static inline void *heap_caps_calloc(size_t n, size_t size, unsigned caps)
+{
+    return calloc(n, size);
+}
+
+static inline void *heap_caps_aligned_alloc(size_t alignment, size_t size, unsigned caps)
+{
+    //aligned_alloc要求长度是对齐的整数倍
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static inline void *heap_caps_aligned_calloc(size_t alignment, size_t n, size_t size, unsigned caps)
+{
+    void *p = heap_caps_aligned_alloc(alignment, n * size, caps);
+    if (p != NULL) {
+        memset(p, 0, n * size);
+    }
+    return p;
+}
+
+static inline void heap_caps_free(void *p)
+{
+    free(p);
+}
+
+//没有按能力分的堆，剩余空间一律报0
+static inline size_t heap_caps_get_free_size(unsigned caps)
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef __HOST_ESP_TIMER_H_
+#define __HOST_ESP_TIMER_H_
+
+//主机构建用的esp_timer.h，时间取单调时钟的微秒数
+#include <stdint.h>
+#include <time.h>
+
+static inline int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#endif
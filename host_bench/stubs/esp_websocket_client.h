@@ -0,0 +1,24 @@
+#ifndef __HOST_ESP_WEBSOCKET_CLIENT_H_
+#define __HOST_ESP_WEBSOCKET_CLIENT_H_
+
+//主机构建用的esp_websocket_client.h，只有上行发送用到的接口，由host_websocket.c实现
+//esp_websocket_mask用组件里的esp_websocket_mask.c
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef struct esp_websocket_client *esp_websocket_client_handle_t;
+
+typedef struct {
+    void *data;
+    size_t len;
+} esp_websocket_iov_t;
+
+void esp_websocket_mask(uint8_t *data, size_t len, const uint8_t mask[4], size_t offset);
+bool esp_websocket_client_is_connected(esp_websocket_client_handle_t client);
+int esp_websocket_client_send_bin_iov(esp_websocket_client_handle_t client, const esp_websocket_iov_t *iov, int iovcnt,
+                                      TickType_t timeout);
+
+#endif
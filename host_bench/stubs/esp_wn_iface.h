@@ -0,0 +1,28 @@
+#ifndef __HOST_ESP_WN_IFACE_H_
+#define __HOST_ESP_WN_IFACE_H_
+
+//主机构建用的esp-sr WakeNet接口，只有audio_wake.c用到的部分，由host_wakenet.c实现
+#include <stdint.h>
+
+typedef struct model_iface_data_t model_iface_data_t;
+
+typedef enum {
+    DET_MODE_90 = 0,
+    DET_MODE_95 = 1,
+} det_mode_t;
+
+typedef enum {
+    WAKENET_NO_DETECT = 0,
+    WAKENET_CHANNEL_VERIFIED = -1,
+    WAKENET_DETECTED = 1,
+} wakenet_state_t;
+
+typedef struct {
+    model_iface_data_t *(*create)(const void *model_name, det_mode_t det_mode);
+    int (*get_samp_chunksize)(model_iface_data_t *model);
+    int (*get_samp_rate)(model_iface_data_t *model);
+    wakenet_state_t (*detect)(model_iface_data_t *model, int16_t *samples);
+    void (*destroy)(model_iface_data_t *model);
+} esp_wn_iface_t;
+
+#endif
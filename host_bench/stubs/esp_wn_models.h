@@ -0,0 +1,11 @@
+#ifndef __HOST_ESP_WN_MODELS_H_
+#define __HOST_ESP_WN_MODELS_H_
+
+//主机构建用的esp_wn_models.h
+#include "esp_wn_iface.h"
+
+#define ESP_WN_PREFIX "wn"
+
+const esp_wn_iface_t *esp_wn_handle_from_name(const char *model_name);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef __HOST_FREERTOS_H_
+#define __HOST_FREERTOS_H_
+
+//主机构建用的FreeRTOS.h，只保留用到的类型，一个tick为1ms
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#define portMAX_DELAY      0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define portNUM_PROCESSORS 2
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef __HOST_FREERTOS_TASK_H_
+#define __HOST_FREERTOS_TASK_H_
+
+//主机构建用的task.h：每个pthread线程对应一个“任务”，任务通知用互斥锁加条件变量实现
+//优先级和核都被忽略，调度交给操作系统
+#include "freertos/FreeRTOS.h"
+
+#define tskNO_AFFINITY 0x7fffffff
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TickType_t xTaskGetTickCount(void);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t func, const char *name, uint32_t stack_depth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *created, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+
+static inline BaseType_t xTaskCreate(TaskFunction_t func, const char *name, uint32_t stack_depth, void *param,
+                                     UBaseType_t priority, TaskHandle_t *created)
+{
+    return xTaskCreatePinnedToCore(func, name, stack_depth, param, priority, created, tskNO_AFFINITY);
+}
+
+#endif
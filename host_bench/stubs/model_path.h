@@ -0,0 +1,13 @@
+#ifndef __HOST_MODEL_PATH_H_
+#define __HOST_MODEL_PATH_H_
+
+//主机构建用的model_path.h，模型列表里只有host_wakenet.c的假模型
+typedef struct {
+    char **model_name;
+    int num;
+} srmodel_list_t;
+
+srmodel_list_t *esp_srmodel_init(const char *partition_label);
+char *esp_srmodel_filter(srmodel_list_t *models, const char *keyword1, const char *keyword2);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef __HOST_SDKCONFIG_H_
+#define __HOST_SDKCONFIG_H_
+
+//主机构建没有PIE向量内核，各个测试用到的其余配置项在CMakeLists.txt里按目标定义
+#define CONFIG_AUDIO_SIMD_PIE 0
+//esp_cpu.h桩的“周期”是纳秒，相当于1000MHz
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 1000
+
+#endif
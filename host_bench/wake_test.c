@@ -0,0 +1,423 @@
+#include "audio_session.h"
+#include "host_websocket.h"
+#include "host_wakenet.h"
+#include "esp_timer.h"
+#include "host_test.h"
+#include "host_wav.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//唤醒会话的主机测试：假WakeNet按幅度报唤醒，模拟的websocket客户端记录上行发出的每一帧
+//测试线程扮演采集任务送帧，检测在唤醒任务里跑
+//audio_wake_test keyword.wav 按采集帧回放录音，报告每次唤醒的帧和补发的预录，不检查结果
+//样本值的低10位是它在整段输入里的序号，从发送记录里就能看出预录和采集帧是否连续、有没有重复
+#define SAMPLE_RATE     16000
+#define FRAME_SAMPLES   320    //20ms一帧，和WakeNet的块长不对齐
+#define PREROLL_SAMPLES 16000  //1秒预录
+#define SESSION_US      1000000
+#define START_US        1000000
+#define KEYWORD_LEVEL   (2 * HOST_WAKENET_LEVEL) //唤醒词样本的偏置，序号部分不超过1023
+#define WAKE_FRAMES_MAX 40     //唤醒词最多送这么多帧，足够假WakeNet攒满HOST_WAKENET_CHUNKS块
+#define LAG_FRAMES      (AUDIO_UPLINK_QUEUE_LEN / 2) //闸门关着时上行保留的帧数
+
+static audio_wake_t wake;
+static int16_t frame_buf[FRAME_SAMPLES];
+static int next_frame = 0;
+static volatile int wake_events = 0;
+static volatile int64_t wake_event_us = 0;
+static size_t ring_from = 0; //预录缓冲从这个样本序号起攒，会话结束后的下一帧重新开始
+
+//没有事件循环，只记下唤醒事件，在唤醒任务中调用
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id, const void *event_data,
+                         size_t event_data_size, TickType_t ticks_to_wait)
+{
+    if (event_base == AUDIO_WAKE_EVENT && event_id == AUDIO_WAKE_EVENT_DETECTED &&
+        event_data_size == sizeof(int64_t)) {
+        memcpy((void *)&wake_event_us, event_data, sizeof(wake_event_us));
+        wake_events++;
+    }
+    return ESP_OK;
+}
+
+//第k帧第一个样本的采集时刻
+static int64_t frame_us(int k)
+{
+    return START_US + (int64_t)k * FRAME_SAMPLES * 1000000 / SAMPLE_RATE;
+}
+
+static audio_uplink_stats_t stats_now(void)
+{
+    audio_uplink_stats_t s;
+    audio_uplink_get_stats(&s);
+    return s;
+}
+
+//唤醒任务取完了送去的帧
+static bool wake_idle(void)
+{
+    audio_session_stats_t s;
+    audio_session_get_stats(&s);
+    return s.pending == 0;
+}
+
+//发送任务把队列里的帧都发完，预录的引用也放掉
+static bool uplink_idle(void)
+{
+    audio_uplink_stats_t s = stats_now();
+    return s.sent + s.dropped >= s.queued && !audio_uplink_ref_busy();
+}
+
+static bool wait_wake(void)
+{
+    bool idle = WAIT_UNTIL(wake_idle());
+    usleep(1000);//唤醒任务放回槽之后还要打开闸门、发事件
+    return idle;
+}
+
+static bool wait_idle(void)
+{
+    bool idle = wait_wake() && WAIT_UNTIL(uplink_idle());
+    usleep(1000);//发送任务放回槽之前还有几条指令
+    return idle;
+}
+
+//送frame_buf里的一帧，不等
+//处理链里唤醒级在上行级前面，但唤醒级只是复制，这里先送上行：唤醒任务看到一帧时上行一定已经收到它，
+//和唤醒任务落后于采集的情况一样，结果不取决于线程调度
+static void feed_buf(void)
+{
+    audio_frame_t frame = {
+        .data = (uint8_t *)frame_buf,
+        .size = sizeof(frame_buf),
+        .timestamp_us = frame_us(next_frame),
+        .sample_rate = SAMPLE_RATE,
+        .channels = 1,
+        .bits = 16,
+    };
+    next_frame++;
+
+    audio_uplink_push(&frame);
+    audio_session_stage(NULL, &frame);
+}
+
+//送一帧合成的样本，不等。keyword为true时样本在HOST_WAKENET_LEVEL以上
+static void feed_frame(bool keyword)
+{
+    for (int i = 0; i < FRAME_SAMPLES; i++) {
+        frame_buf[i] = (int16_t)((((size_t)next_frame * FRAME_SAMPLES + i) & 1023) + (keyword ? KEYWORD_LEVEL : 0));
+    }
+    feed_buf();
+}
+
+//送一帧，等唤醒任务检测完；drain为true时还等上行发完
+static void step(bool keyword, bool drain)
+{
+    feed_frame(keyword);
+    CHECK(drain ? wait_idle() : wait_wake(), "frame %d not processed", next_frame - 1);
+}
+
+static void step_quiet(int frames, bool drain)
+{
+    for (int i = 0; i < frames; i++) {
+        step(false, drain);
+    }
+}
+
+//唤醒词从下一帧开始时应该触发唤醒的帧：前面是静音，从下一个块边界起攒满HOST_WAKENET_CHUNKS块
+static int expected_trigger(void)
+{
+    size_t skip = wake.chunk_fill == 0 ? 0 : HOST_WAKENET_CHUNK - wake.chunk_fill;
+    size_t end = (size_t)next_frame * FRAME_SAMPLES + skip + HOST_WAKENET_CHUNK * HOST_WAKENET_CHUNKS;
+    return (int)((end - 1) / FRAME_SAMPLES);
+}
+
+//送唤醒词直到唤醒，返回触发唤醒的帧号，没有唤醒返回-1
+static int feed_until_wake(bool drain)
+{
+    int events = wake_events;
+    int expected = expected_trigger();
+    for (int i = 0; i < WAKE_FRAMES_MAX; i++) {
+        step(true, drain);
+        if (wake_events > events) {
+            int trigger = next_frame - 1;
+            CHECK(wake_events == events + 1, "%d wake events for one keyword", wake_events - events);
+            CHECK(trigger == expected, "wake at frame %d, expected %d", trigger, expected);
+            CHECK(wake_event_us == frame_us(trigger), "wake event at %lld us, frame at %lld us",
+                  (long long)wake_event_us, (long long)frame_us(trigger));
+            return trigger;
+        }
+    }
+    CHECK(false, "no wake after %d keyword frames", WAKE_FRAMES_MAX);
+    return -1;
+}
+
+//预录缓冲里最早的样本序号：从ring_from起攒，只保留到触发帧为止的最近PREROLL_SAMPLES个
+static size_t preroll_first(int trigger)
+{
+    size_t end = (size_t)(trigger + 1) * FRAME_SAMPLES;
+    return end - ring_from > PREROLL_SAMPLES ? end - PREROLL_SAMPLES : ring_from;
+}
+
+//检查一次会话发出的帧：第一帧是预录（from_sample起到触发帧为止），之后是from_frame到to_frame的采集帧
+//from_sample为SIZE_MAX时不应该有预录。返回下一个会话的第一条记录
+static size_t check_session(const host_ws_packet_t *log, size_t logged, size_t first, int trigger, size_t from_sample,
+                            int from_frame, int to_frame)
+{
+    const int16_t *samples = host_ws_samples();
+    size_t at = first;
+
+    if (from_sample != SIZE_MAX) {
+        size_t count = (size_t)(trigger + 1) * FRAME_SAMPLES - from_sample;
+        CHECK(at < logged, "preroll of the wake at frame %d not sent", trigger);
+        if (at >= logged) {
+            return at;
+        }
+        const host_ws_packet_t *pre = &log[at++];
+        int64_t expected_us = frame_us(trigger + 1) - (int64_t)count * 1000000 / SAMPLE_RATE;
+        CHECK(pre->count == count, "preroll %zu samples, expected %zu", pre->count, count);
+        CHECK((int64_t)pre->header.timestamp_us == expected_us, "preroll at %lld us, expected %lld us",
+              (long long)pre->header.timestamp_us, (long long)expected_us);
+        CHECK(pre->header.sample_rate == SAMPLE_RATE && pre->header.channels == 1 && pre->header.bits == 16 &&
+              pre->header.codec == AUDIO_CODEC_PCM, "preroll header format");
+        //预录是唤醒词和它前面的连续音频，到触发帧为止
+        size_t bad = 0;
+        for (size_t i = 0; i < pre->count; i++) {
+            bad += (size_t)(samples[pre->offset + i] & 1023) != ((from_sample + i) & 1023);
+        }
+        CHECK(bad == 0, "%zu preroll samples out of sequence", bad);
+    } else if (at < logged) {
+        CHECK(log[at].count == FRAME_SAMPLES, "preroll sent while the previous one was still in flight");
+    }
+
+    for (int k = from_frame; k <= to_frame; k++) {
+        CHECK(at < logged, "frame %d not sent", k);
+        if (at >= logged) {
+            return at;
+        }
+        const host_ws_packet_t *p = &log[at];
+        CHECK(p->count == FRAME_SAMPLES, "frame %d: %zu samples", k, p->count);
+        CHECK((int64_t)p->header.timestamp_us == frame_us(k), "frame %d at %lld us", k,
+              (long long)p->header.timestamp_us);
+        CHECK(at == first || p->header.seq > log[at - 1].header.seq, "frame %d: seq %lu after %lu", k,
+              (unsigned long)p->header.seq, (unsigned long)log[at - 1].header.seq);
+        //和预录首尾相接，预录里已有的帧不重复
+        CHECK((samples[p->offset] & 1023) == (((size_t)k * FRAME_SAMPLES) & 1023), "frame %d starts at sample %d", k,
+              samples[p->offset] & 1023);
+        at++;
+    }
+    return at;
+}
+
+static host_ws_packet_t ws_log[HOST_WS_LOG_MAX];
+
+//唤醒前闸门关着什么都不发；唤醒后先发一帧到触发帧为止的预录，再发之后的帧，会话超时后闸门关上
+static size_t test_first_wake(void)
+{
+    step_quiet(100, true);
+    CHECK(host_ws_log(ws_log, HOST_WS_LOG_MAX) == 0, "sent before the wake word");
+    CHECK(stats_now().gated == 100 - LAG_FRAMES, "%lu frames gated, expected %d", (unsigned long)stats_now().gated,
+          100 - LAG_FRAMES);
+    CHECK(wake_events == 0, "wake without a keyword");
+
+    int trigger = feed_until_wake(true);
+    if (trigger < 0) {
+        return 0;
+    }
+    CHECK(audio_session_is_open(), "session not open after the wake");
+
+    //唤醒词后面接着说话，会话按帧时间戳超时，超时的那一帧在唤醒任务看到之前已经发出
+    for (int i = 0; i < 10; i++) {
+        step(true, true);
+    }
+    int closed = -1;
+    for (int i = 0; i < 100 && closed < 0; i++) {
+        step(false, true);
+        if (!audio_session_is_open()) {
+            closed = next_frame - 1;
+        }
+    }
+    CHECK(closed == trigger + (int)((int64_t)SESSION_US * SAMPLE_RATE / 1000000 / FRAME_SAMPLES) + 1,
+          "session closed at frame %d, wake at frame %d", closed, trigger);
+    size_t from = preroll_first(trigger);
+    //超时那一帧在会话内，没有进预录缓冲
+    ring_from = (size_t)(closed + 1) * FRAME_SAMPLES;
+    step_quiet(20, true);
+
+    size_t logged = host_ws_log(ws_log, HOST_WS_LOG_MAX);
+    size_t end = check_session(ws_log, logged, 0, trigger, from, trigger + 1, closed);
+    CHECK(end == logged, "%zu frames sent after the session closed", logged - end);
+    printf("first wake: frame %d, %zu ms preroll, %d frames until the %d ms timeout\n", trigger,
+           ((size_t)(trigger + 1) * FRAME_SAMPLES - from) * 1000 / SAMPLE_RATE, closed - trigger, SESSION_US / 1000);
+    return end;
+}
+
+//预录缓冲在唤醒时取空，第二次唤醒只补发会话结束以后的音频；语音结束在最短会话时长之后才结束会话
+static size_t test_second_wake(size_t first)
+{
+    int trigger = feed_until_wake(true);
+    if (trigger < 0) {
+        return first;
+    }
+    size_t from = preroll_first(trigger);
+    step_quiet(5, true);
+
+    audio_session_speech_end(frame_us(trigger) + AUDIO_SESSION_MIN_US - 100000);
+    CHECK(audio_session_is_open(), "speech end closed the session before the minimum");
+    audio_session_speech_end(frame_us(trigger) + AUDIO_SESSION_MIN_US + 100000);
+    CHECK(!audio_session_is_open(), "speech end did not close the session");
+    ring_from = (size_t)next_frame * FRAME_SAMPLES;
+    step_quiet(5, true);
+
+    size_t logged = host_ws_log(ws_log, HOST_WS_LOG_MAX);
+    size_t end = check_session(ws_log, logged, first, trigger, from, trigger + 1, trigger + 5);
+    CHECK(end == logged, "%zu frames sent after the speech end", logged - end);
+    printf("second wake: frame %d, %zu ms preroll since the last session\n", trigger,
+           ((size_t)(trigger + 1) * FRAME_SAMPLES - from) * 1000 / SAMPLE_RATE);
+    return end;
+}
+
+//唤醒任务落后于采集：判定出来之前触发帧和之后几帧已经送进上行
+//上行丢掉预录里已有的触发帧，之后的帧接在预录后面，不重复也不断
+static size_t test_lagging_wake(size_t first)
+{
+    step_quiet(10, true);
+    int events = wake_events;
+    int trigger = expected_trigger();
+    int last = trigger + LAG_FRAMES - 1;
+    while (next_frame < trigger - 1) {
+        step(true, true);
+    }
+
+    host_wakenet_hold(true);
+    while (next_frame <= last) {
+        feed_frame(true);
+    }
+    CHECK(wake_events == events, "woke while the detection was held");
+    host_wakenet_hold(false);
+    CHECK(wait_idle(), "lagging frames not processed");
+    CHECK(wake_events == events + 1 && wake_event_us == frame_us(trigger), "lagging wake not at frame %d", trigger);
+    size_t from = preroll_first(trigger);
+
+    audio_session_speech_end(frame_us(trigger) + AUDIO_SESSION_MIN_US + 100000);
+    CHECK(!audio_session_is_open(), "speech end did not close the session");
+    ring_from = (size_t)next_frame * FRAME_SAMPLES;
+
+    size_t logged = host_ws_log(ws_log, HOST_WS_LOG_MAX);
+    size_t end = check_session(ws_log, logged, first, trigger, from, trigger + 1, last);
+    CHECK(end == logged, "%zu unexpected frames", logged - end);
+    printf("lagging wake: detection %d frames behind capture, no gap after the preroll\n", last - trigger);
+    return end;
+}
+
+//上一段预录还卡在发送里时再次唤醒，不改写预录缓冲，这次不补发，闸门关着时留下的帧照常发
+static void test_wake_while_busy(size_t first)
+{
+    host_ws_hold(true);
+    step_quiet(30, false);
+    int busy_trigger = feed_until_wake(false);
+    if (busy_trigger < 0) {
+        host_ws_hold(false);
+        return;
+    }
+    size_t from = preroll_first(busy_trigger);
+
+    CHECK(WAIT_UNTIL(host_ws_blocked()) && audio_uplink_ref_busy(), "preroll not held by the sender");
+    audio_session_speech_end(frame_us(busy_trigger) + AUDIO_SESSION_MIN_US + 100000);
+
+    step_quiet(5, false);
+    int trigger = feed_until_wake(false);
+    CHECK(audio_uplink_ref_busy(), "preroll released while the sender was held");
+    host_ws_hold(false);
+    CHECK(wait_idle(), "uplink not drained after the hold");
+
+    size_t logged = host_ws_log(ws_log, HOST_WS_LOG_MAX);
+    size_t at = check_session(ws_log, logged, first, busy_trigger, from, busy_trigger + 1, busy_trigger);
+    if (trigger >= 0) {
+        at = check_session(ws_log, logged, at, trigger, SIZE_MAX, trigger - LAG_FRAMES + 1, trigger);
+    }
+    CHECK(at == logged, "%zu unexpected frames", logged - at);
+    printf("wake while busy: frame %d sent without preroll, %lu frames sent in total\n", trigger,
+           (unsigned long)stats_now().sent);
+}
+
+//回放录音：按采集帧送进唤醒级和上行，每帧等唤醒任务检测完，唤醒后从发送记录里找出这次的预录
+static int replay(const char *path)
+{
+    host_pcm_t in = { 0 };
+    if (host_wav_read(path, &in) != 0) {
+        return 1;
+    }
+    if (in.sample_rate != SAMPLE_RATE) {
+        fprintf(stderr, "need %d Hz input\n", SAMPLE_RATE);
+        free(in.pcm);
+        return 1;
+    }
+
+    int events = 0;
+    size_t logged = 0;
+    for (size_t pos = 0; pos + FRAME_SAMPLES <= in.count; pos += FRAME_SAMPLES) {
+        memcpy(frame_buf, in.pcm + pos, sizeof(frame_buf));
+        feed_buf();
+        if (!wait_wake()) {
+            fprintf(stderr, "wake task stuck at frame %d\n", next_frame - 1);
+            break;
+        }
+        if (wake_events == events) {
+            continue;
+        }
+        events = wake_events;
+        int trigger = next_frame - 1;
+        WAIT_UNTIL(uplink_idle());
+
+        //预录是这次会话里正好到触发帧结束的那个包，预录还在发送时没有
+        size_t preroll = 0;
+        size_t n = host_ws_log(ws_log, HOST_WS_LOG_MAX);
+        n = n < HOST_WS_LOG_MAX ? n : HOST_WS_LOG_MAX;
+        for (size_t i = logged; i < n; i++) {
+            int64_t end_us = (int64_t)ws_log[i].header.timestamp_us + (int64_t)ws_log[i].count * 1000000 / SAMPLE_RATE;
+            if (ws_log[i].count > 0 && end_us == frame_us(trigger + 1)) {
+                preroll = ws_log[i].count;
+            }
+        }
+        logged = n;
+        printf("wake %d: frame %d at %.2f s, %zu ms preroll%s\n", events, trigger,
+               (double)trigger * FRAME_SAMPLES / SAMPLE_RATE, preroll * 1000 / SAMPLE_RATE,
+               logged == HOST_WS_LOG_MAX ? " (send log full)" : "");
+    }
+
+    audio_session_stats_t s;
+    audio_session_get_stats(&s);
+    printf("%d frames, %lu chunks, %d wakes, %lu frames not checked\n", next_frame,
+           (unsigned long)wake.stats.chunks, events, (unsigned long)s.dropped);
+    free(in.pcm);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    audio_wake_backend_t backend;
+    if (audio_uplink_init(FRAME_SAMPLES * sizeof(int16_t)) != ESP_OK || audio_uplink_start() != ESP_OK ||
+        audio_wake_backend_wakenet(&backend, &wake.stats) != ESP_OK ||
+        audio_wake_init(&wake, &backend, PREROLL_SAMPLES) != ESP_OK ||
+        audio_session_init(&wake, SESSION_US, FRAME_SAMPLES * sizeof(int16_t)) != ESP_OK ||
+        audio_session_start() != ESP_OK) {
+        fprintf(stderr, "setup failed\n");
+        return 1;
+    }
+    if (argc > 1) {
+        return replay(argv[1]);
+    }
+    CHECK(backend.chunk == HOST_WAKENET_CHUNK, "chunk %zu", backend.chunk);
+
+    size_t at = test_first_wake();
+    at = test_second_wake(at);
+    at = test_lagging_wake(at);
+    test_wake_while_busy(at);
+
+    audio_session_stats_t s;
+    audio_session_get_stats(&s);
+    CHECK(s.dropped == 0, "%lu frames not checked for the wake word", (unsigned long)s.dropped);
+    return host_test_result();
+}
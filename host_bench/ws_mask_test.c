@@ -0,0 +1,94 @@
+#include "esp_websocket_client.h"
+#include "esp_cpu.h"
+#include "host_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//WebSocket掩码的主机测试：按字的esp_websocket_mask对照逐字节循环，密钥、长度、缓冲起点和帧内偏移都随机
+//之后比较两种写法每字节的耗时，主机上只做参考，不作为通过条件
+#define BUF_BYTES    260
+#define ROUNDS       20000
+#define BENCH_BYTES  4096 //和上行一帧PCM差不多大
+#define BENCH_ROUNDS 2000
+
+static uint32_t seed = 0x9E3779B9u;
+
+static uint32_t test_rand(void)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return seed;
+}
+
+//逐字节循环，作为参考
+static void mask_bytewise(uint8_t *data, size_t len, const uint8_t mask[4], size_t offset)
+{
+    for (size_t i = 0; i < len; i++) {
+        data[i] ^= mask[(offset + i) & 3];
+    }
+}
+
+static void test_equivalence(void)
+{
+    static uint8_t buf[BUF_BYTES] __attribute__((aligned(4)));
+    static uint8_t expected[BUF_BYTES] __attribute__((aligned(4)));
+    int bad = 0;
+
+    for (int r = 0; r < ROUNDS; r++) {
+        uint8_t mask[4];
+        uint32_t key = test_rand();
+        memcpy(mask, &key, sizeof(mask));
+        size_t align = test_rand() % 4;
+        size_t len = test_rand() % (BUF_BYTES - align + 1);
+        size_t offset = test_rand();
+        for (size_t i = 0; i < BUF_BYTES; i++) {
+            buf[i] = (uint8_t)(test_rand() >> 24);
+        }
+        memcpy(expected, buf, sizeof(buf));
+
+        //缓冲前后不在范围内的字节也要不变
+        esp_websocket_mask(buf + align, len, mask, offset);
+        mask_bytewise(expected + align, len, mask, offset);
+        if (memcmp(buf, expected, sizeof(buf)) != 0 && bad++ == 0) {
+            fprintf(stderr, "mismatch: align %zu len %zu offset %zu\n", align, len, offset);
+        }
+
+        //再加一次掩码还原
+        esp_websocket_mask(buf + align, len, mask, offset);
+        mask_bytewise(expected + align, len, mask, offset);
+        bad += memcmp(buf, expected, sizeof(buf)) != 0;
+    }
+    CHECK(bad == 0, "%d of %d rounds differ from the byte loop", bad, ROUNDS);
+}
+
+//每字节纳秒数，esp_cpu.h的桩按纳秒计数；noinline防止逐字节循环和外层循环合并后被优化掉
+typedef void (*mask_fn_t)(uint8_t *data, size_t len, const uint8_t mask[4], size_t offset);
+
+static __attribute__((noinline)) double bench(mask_fn_t fn, uint8_t *data)
+{
+    static const uint8_t mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        fn(data, BENCH_BYTES, mask, (size_t)r);
+    }
+    uint32_t elapsed = esp_cpu_get_cycle_count() - start;
+    return (double)elapsed / ((double)BENCH_ROUNDS * BENCH_BYTES);
+}
+
+static void test_speed(void)
+{
+    static uint8_t data[BENCH_BYTES + 4] __attribute__((aligned(4)));
+    for (size_t align = 0; align < 2; align++) {
+        double byte_ns = bench(mask_bytewise, data + align);
+        double word_ns = bench(esp_websocket_mask, data + align);
+        printf("mask %d bytes, start %s: byte loop %.3f ns/byte, word loop %.3f ns/byte, x%.1f\n", BENCH_BYTES,
+               align == 0 ? "aligned" : "unaligned", byte_ns, word_ns, byte_ns / word_ns);
+    }
+}
+
+int main(void)
+{
+    test_equivalence();
+    test_speed();
+    return host_test_result();
+}
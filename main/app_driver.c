@@ -1,40 +1,343 @@
 #include "app_driver.h"
+#include "esp_heap_caps.h"
 #include "websocket_client.h"
 #include "Mic_driver.h"
+#include "audio_pipeline.h"
+#include "audio_chain.h"
+#include "audio_resampler.h"
+#include "audio_uplink.h"
+#include "audio_downlink.h"
+#include "audio_vad.h"
+#include "audio_wake.h"
+#include "audio_session.h"
+#include "audio_aec.h"
+#include "audio_ns.h"
+#include "audio_biquad.h"
+#include "audio_trace.h"
+#include "audio_bench.h"
 
 #define TAG "app_driver"
 
 // 开始任务
-#define START_TASK_DEPTH 1024 // 任务栈深
+#define START_TASK_DEPTH 3072 // 任务栈深
 #define START_TASK_PRI   4 // 任务优先级
 
-// 语音播放任务
-#define AUDIO_TASK_DEPTH 8192 // 任务栈深
-#define AUDIO_TASK_PRI   3 // 任务优先级
+//处理级：增益/AGC，参数为audio_processor_t
+static esp_err_t process_stage(void *ctx, audio_frame_t *frame)
+{
+    if (frame->bits == 16) {
+        process_audio_buffer_s16((int16_t *)frame->data, frame->size / sizeof(int16_t), (audio_processor_t *)ctx);
+    } else {
+        process_audio_buffer(frame->data, frame->size, (audio_processor_t *)ctx);
+    }
+    return ESP_OK;
+}
+
+#if STREAM_SAMPLE_RATE != MIC_SAMPLE_RATE
+static audio_resampler_t resampler;
+
+//处理级：重采样到STREAM_SAMPLE_RATE，原地输出
+static esp_err_t resample_stage(void *ctx, audio_frame_t *frame)
+{
+    audio_resampler_t *rs = (audio_resampler_t *)ctx;
+
+    size_t count;
+    esp_err_t ret = audio_resampler_process(rs, (const int16_t *)frame->data, frame->size / sizeof(int16_t),
+                                            (int16_t *)frame->data, &count);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    frame->size = count * sizeof(int16_t);
+    frame->sample_rate = rs->out_rate;
+    return ESP_OK;
+}
+#endif
+
+#if CONFIG_AUDIO_HPF
+static audio_biquad_t hpf;
+
+//处理级：隔直、高通和均衡，放在增益之前，免得直流和低频隆隆声被放大后占掉余量
+static esp_err_t hpf_stage(void *ctx, audio_frame_t *frame)
+{
+    if (frame->bits == 16) {
+        audio_biquad_process_s16((audio_biquad_t *)ctx, (int16_t *)frame->data, frame->size / sizeof(int16_t));
+    } else {
+        audio_biquad_process_s32((audio_biquad_t *)ctx, (int32_t *)frame->data, frame->size / sizeof(int32_t));
+    }
+    return ESP_OK;
+}
+
+//按配置搭建滤波器组：一阶隔直、二阶巴特沃斯高通，增益不为0时加一节峰值均衡
+static esp_err_t hpf_setup(audio_biquad_t *bq)
+{
+    audio_biquad_init(bq, AUDIO_CHANNELS);
+
+    audio_biquad_coeffs_t dc = audio_biquad_dc_blocker(STREAM_SAMPLE_RATE, 5.0f);
+    audio_biquad_coeffs_t hp = audio_biquad_highpass(STREAM_SAMPLE_RATE, CONFIG_AUDIO_HPF_CUTOFF_HZ, 0.7071f);
+    esp_err_t ret = audio_biquad_add(bq, &dc);
+    if (ret == ESP_OK) {
+        ret = audio_biquad_add(bq, &hp);
+    }
+#if CONFIG_AUDIO_EQ_GAIN_DB != 0
+    audio_biquad_coeffs_t eq = audio_biquad_peaking(STREAM_SAMPLE_RATE, CONFIG_AUDIO_EQ_FREQ_HZ, 1.0f, CONFIG_AUDIO_EQ_GAIN_DB);
+    if (ret == ESP_OK) {
+        ret = audio_biquad_add(bq, &eq);
+    }
+#endif
+    return ret;
+}
+#endif
+
+#if CONFIG_AUDIO_AEC
+static audio_aec_t aec;
+
+//播放旁路：写进TX的下行语音作为回声参考
+static void aec_reference_tap(void *ctx, const uint8_t *buf, size_t size, int64_t play_us)
+{
+    audio_aec_push_reference((audio_aec_t *)ctx, (const int16_t *)buf, size / sizeof(int16_t), play_us);
+}
+
+//处理级：消除扬声器漏进麦克风的回声，帧时间戳是最后一个样本的采集时刻
+static esp_err_t aec_stage(void *ctx, audio_frame_t *frame)
+{
+    audio_aec_process((audio_aec_t *)ctx, (int16_t *)frame->data, frame->size / sizeof(int16_t), frame->timestamp_us);
+    return ESP_OK;
+}
+#endif
 
+#if CONFIG_AUDIO_NS
+static audio_ns_t ns;
 
-//语音播放任务
-static void audio_loop_task(void *param)
+//处理级：频域降噪，原地输出
+static esp_err_t ns_stage(void *ctx, audio_frame_t *frame)
 {
-    ESP_LOGI(TAG,"语音播放任务开始");
-    while (1) {
-        esp_err_t ret = mic_read();
-        if (ret == ESP_OK) 
-        {
-            spk_write();
-        }else
-        {
-            ESP_LOGW(TAG,"Mic 读取失败了：%s",esp_err_to_name(ret));
+    audio_ns_process((audio_ns_t *)ctx, (int16_t *)frame->data, frame->size / sizeof(int16_t));
+    return ESP_OK;
+}
+#endif
+
+#if CONFIG_AUDIO_UPLINK
+//处理级：复制一份处理后的帧交给上行发送任务，放在处理链最后
+static esp_err_t uplink_stage(void *ctx, audio_frame_t *frame)
+{
+    audio_uplink_push(frame);
+    return ESP_OK;
+}
+#endif
+
+#if CONFIG_AUDIO_WAKE
+#define WAKE_PREROLL_SAMPLES (STREAM_SAMPLE_RATE * CONFIG_AUDIO_WAKE_PREROLL_MS / 1000)
+#define WAKE_SESSION_US ((int64_t)CONFIG_AUDIO_WAKE_SESSION_MS * 1000)
+
+static audio_wake_t wake;
+#endif
+
+#if CONFIG_AUDIO_VAD
+//一帧的时长，按重采样前的DMA帧计算，随DMA档位变化
+#define VAD_FRAME_MS ((float)audio_pipeline_get_profile()->frame_num * 1000 / MIC_SAMPLE_RATE)
+#define VAD_PREROLL_FRAMES ((size_t)(CONFIG_AUDIO_VAD_PREROLL_MS / VAD_FRAME_MS) + 1)
+#define VAD_HANGOVER_FRAMES ((uint32_t)(CONFIG_AUDIO_VAD_HANGOVER_MS / VAD_FRAME_MS) + 1)
+
+static audio_vad_t vad;
+
+//处理级：语音检测，开关上行闸门，并把语音起止作为事件发出去，放在上行级之前
+static esp_err_t vad_stage(void *ctx, audio_frame_t *frame)
+{
+    audio_vad_t *v = (audio_vad_t *)ctx;
+    //拖尾按帧数计，切换DMA档位后帧长变了，保持毫秒数不变
+    v->hangover_blocks = VAD_HANGOVER_FRAMES;
+    audio_vad_result_t result = audio_vad_process(v, (const int16_t *)frame->data, frame->size / sizeof(int16_t));
+
+    if (result == AUDIO_VAD_NONE) {
+        return ESP_OK;
+    }
+
+#if CONFIG_AUDIO_WAKE
+    //有唤醒词时闸门由唤醒打开，语音结束只用来提前结束会话
+    if (result == AUDIO_VAD_END) {
+        audio_session_speech_end(frame->timestamp_us);
+    }
+#else
+    audio_uplink_set_gate(result == AUDIO_VAD_START, VAD_PREROLL_FRAMES);
+#endif
+
+    audio_vad_event_data_t data = {
+        .timestamp_us = frame->timestamp_us,
+        .energy_db = audio_vad_energy_db(v),
+        .noise_db = audio_vad_noise_db(v),
+    };
+    int32_t event = result == AUDIO_VAD_START ? AUDIO_VAD_EVENT_SPEECH_START : AUDIO_VAD_EVENT_SPEECH_END;
+    esp_event_post(AUDIO_VAD_EVENT, event, &data, sizeof(data), 0);//采集任务不等事件循环
+    ESP_LOGD(TAG,"语音%s：%.1f dBFS，噪声底 %.1f dBFS", result == AUDIO_VAD_START ? "开始" : "结束",
+             data.energy_db, data.noise_db);
+    return ESP_OK;
+}
+#endif
+
+//处理级加到链尾，链满或重名时打印出来，少一级不影响其他处理级
+static void chain_append(const audio_stage_t *stage)
+{
+    esp_err_t ret = audio_chain_register(stage, -1);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG,"处理级%s没有加入处理链：%s",stage->name,esp_err_to_name(ret));
+    }
+}
+
+//搭建采集处理链，按部署需要增删处理级
+static void audio_chain_setup(void)
+{
+    audio_chain_init();
+
+#if STREAM_SAMPLE_RATE != MIC_SAMPLE_RATE
+    //重采样放在最前面，后面的处理级都按STREAM_SAMPLE_RATE工作
+    esp_err_t ret = audio_resampler_init(&resampler, MIC_SAMPLE_RATE, STREAM_SAMPLE_RATE, I2S_DMA_FRAME_MAX);
+    if (ret == ESP_OK && audio_resampler_max_out(&resampler) * sizeof(int16_t) > BUF_SIZE) {
+        ret = ESP_ERR_INVALID_SIZE;//升采样的输出放不进帧缓冲
+    }
+    if (ret == ESP_OK) {
+        audio_stage_t resample = {
+            .name = "resample",
+            .process = resample_stage,
+            .ctx = &resampler,
+        };
+        chain_append(&resample);
+    } else {
+        ESP_LOGE(TAG,"重采样器初始化失败：%s",esp_err_to_name(ret));
+    }
+#endif
+
+#if CONFIG_AUDIO_HPF
+    if (hpf_setup(&hpf) == ESP_OK) {
+        audio_stage_t filter = {
+            .name = "hpf",
+            .process = hpf_stage,
+            .ctx = &hpf,
+        };
+        chain_append(&filter);
+    } else {
+        ESP_LOGE(TAG,"高通滤波器系数超出范围");
+    }
+#endif
+
+#if CONFIG_AUDIO_AEC
+    //回声消除放在增益/AGC之前，回声路径保持线性
+    if (audio_aec_init(&aec, STREAM_SAMPLE_RATE, CONFIG_AUDIO_AEC_TAIL_MS, BUF_SIZE / sizeof(int16_t)) == ESP_OK) {
+        audio_stage_t echo_cancel = {
+            .name = "aec",
+            .process = aec_stage,
+            .ctx = &aec,
+        };
+        chain_append(&echo_cancel);
+    } else {
+        ESP_LOGE(TAG,"回声消除初始化失败");
+    }
+#endif
+
+    audio_stage_t process = {
+        .name = "process",
+        .process = process_stage,
+        .ctx = &audio_proc,
+    };
+    chain_append(&process);
+
+#if CONFIG_AUDIO_NS
+    //降噪放在增益之后，语音检测、唤醒和上行都用降噪后的信号
+    if (audio_ns_init(&ns, STREAM_SAMPLE_RATE, CONFIG_AUDIO_NS_MAX_ATTEN_DB, BUF_SIZE / sizeof(int16_t)) == ESP_OK) {
+        audio_stage_t noise_suppress = {
+            .name = "ns",
+            .process = ns_stage,
+            .ctx = &ns,
+        };
+        chain_append(&noise_suppress);
+    } else {
+        ESP_LOGE(TAG,"降噪初始化失败");
+    }
+#endif
+
+#if CONFIG_AUDIO_UPLINK
+    if (audio_uplink_init(BUF_SIZE) == ESP_OK && audio_uplink_start() == ESP_OK) {
+#if CONFIG_AUDIO_WAKE
+        //闸门先关上，检测到唤醒词再打开
+        audio_wake_backend_t backend;
+        if (audio_wake_backend_wakenet(&backend, &wake.stats) == ESP_OK &&
+            audio_wake_init(&wake, &backend, WAKE_PREROLL_SAMPLES) == ESP_OK &&
+            audio_session_init(&wake, WAKE_SESSION_US, BUF_SIZE) == ESP_OK && audio_session_start() == ESP_OK) {
+            //WakeNet在唤醒任务里跑，处理级只复制帧
+            audio_stage_t wake_detect = {
+                .name = "wake",
+                .process = audio_session_stage,
+                .ctx = NULL,
+            };
+            chain_append(&wake_detect);
+        } else {
+            ESP_LOGE(TAG,"唤醒词初始化失败，上行不经唤醒");
         }
-        vTaskDelay(pdMS_TO_TICKS(5));
+#endif
+
+#if CONFIG_AUDIO_VAD
+        //闸门先关上，检测到语音再打开
+        audio_vad_init(&vad, CONFIG_AUDIO_VAD_THRESHOLD_DB, VAD_HANGOVER_FRAMES);
+#if !CONFIG_AUDIO_WAKE
+        audio_uplink_set_gate(false, VAD_PREROLL_FRAMES);
+#endif
+
+        audio_stage_t vad_detect = {
+            .name = "vad",
+            .process = vad_stage,
+            .ctx = &vad,
+        };
+        chain_append(&vad_detect);
+#endif
+
+        audio_stage_t uplink = {
+            .name = "uplink",
+            .process = uplink_stage,
+            .ctx = NULL,
+        };
+        chain_append(&uplink);
+    } else {
+        ESP_LOGE(TAG,"上行初始化失败");
     }
+#endif
 }
 
 //开始任务函数入口
 void start_task(void *param)
 {
-    //语音播放任务
-    xTaskCreate(audio_loop_task,"audio loop task",AUDIO_TASK_DEPTH,NULL,AUDIO_TASK_PRI,NULL);
+    //采集处理链
+    audio_chain_setup();
+
+    //语音采集、播放流水线
+    esp_err_t ret = audio_pipeline_init();
+
+#if CONFIG_AUDIO_SPK_DOWNLINK
+    //扬声器播放服务器下发的语音，采集只走处理链和上行
+    if (ret == ESP_OK) {
+        ret = audio_downlink_init();
+    }
+    if (ret == ESP_OK) {
+        audio_pipeline_set_playback_source(audio_downlink_read, NULL);
+#if CONFIG_AUDIO_AEC
+        if (aec.partitions > 0) {
+            audio_pipeline_set_playback_tap(aec_reference_tap, &aec);
+        }
+#endif
+    }
+#endif
+    if (ret == ESP_OK) {
+        ret = audio_pipeline_start();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG,"音频流水线启动失败：%s",esp_err_to_name(ret));
+    }
+#if CONFIG_AUDIO_BENCH_PROFILES
+    if (ret == ESP_OK) {
+        audio_bench_profiles();
+    }
+#endif
+#if CONFIG_AUDIO_TRACE && CONFIG_AUDIO_TRACE_DUMP_INTERVAL_S > 0
+    audio_trace_start_dump(CONFIG_AUDIO_TRACE_DUMP_INTERVAL_S * 1000);
+#endif
 
     //删除启动任务
     vTaskDelete(NULL);
@@ -4,15 +4,76 @@
 #include <stdio.h>
 #include "driver/i2s_std.h"
 #include "driver/gpio.h"
+#include "sdkconfig.h"
 
 
-//配置rx对INMP441的采样率为44.1kHz，这是常用的人声采样率
-#define SAMPLE_RATE 44100
+//INMP441的I2S RX采样率，默认44.1kHz，设为16kHz时可以省掉重采样
+#define MIC_SAMPLE_RATE CONFIG_AUDIO_MIC_SAMPLE_RATE
 
-//buf size计算方法：根据esp32官方文档，buf size = dma frame num * 声道数 * 数据位宽 / 8
-#define BUF_SIZE (1023 * 1 * 32 / 8) //4092
- 
-//音频buffer
-extern uint8_t buf[BUF_SIZE];
+//流水线中音频的格式：单声道16位，或者原来的双声道32位
+#if CONFIG_AUDIO_CAPTURE_MONO_16
+#define AUDIO_CHANNELS 1
+#define AUDIO_BITS     16
+#else
+#define AUDIO_CHANNELS 2
+#define AUDIO_BITS     32
+#endif
+
+//处理链输出的采样率，扬声器和上行都使用这个采样率，和MIC_SAMPLE_RATE不同时由重采样级转换
+#if CONFIG_AUDIO_CAPTURE_MONO_16
+#define STREAM_SAMPLE_RATE CONFIG_AUDIO_STREAM_SAMPLE_RATE
+#else
+#define STREAM_SAMPLE_RATE MIC_SAMPLE_RATE
+#endif
+
+//I2S RX实际收到的格式，软件提取单声道时硬件仍按双声道32位接收
+#if CONFIG_AUDIO_CAPTURE_SW_EXTRACT
+#define I2S_RX_CHANNELS 2
+#define I2S_RX_BITS     32
+#else
+#define I2S_RX_CHANNELS AUDIO_CHANNELS
+#define I2S_RX_BITS     AUDIO_BITS
+#endif
+
+//RX、TX每帧（一个采样时刻）的字节数
+#define I2S_RX_FRAME_BYTES (I2S_RX_CHANNELS * I2S_RX_BITS / 8)
+#define I2S_TX_FRAME_BYTES (AUDIO_CHANNELS * AUDIO_BITS / 8)
+
+//一个DMA缓冲的字节数 = dma frame num * 声道数 * 数据位宽 / 8，每次接收回调对应一个DMA缓冲
+//驱动要求一个DMA缓冲不超过4092字节，rx和tx使用同样的dma frame num，按每帧字节数大的一方限制
+#define I2S_DMA_BUF_MAX 4092
+#define I2S_FRAME_BYTES_MAX (I2S_RX_FRAME_BYTES > I2S_TX_FRAME_BYTES ? I2S_RX_FRAME_BYTES : I2S_TX_FRAME_BYTES)
+#define I2S_DMA_FRAME_MAX (I2S_DMA_BUF_MAX / I2S_FRAME_BYTES_MAX)
+
+//DMA配置档位，rx和tx始终使用同一档，运行中可以切换
+typedef enum {
+    AUDIO_DMA_PROFILE_LOW_LATENCY,  //小DMA缓冲、多描述符：延迟低，中断和任务切换多
+    AUDIO_DMA_PROFILE_BALANCED,     //原来的配置
+    AUDIO_DMA_PROFILE_LOW_POWER,    //DMA缓冲取最大：中断最少，延迟最高
+    AUDIO_DMA_PROFILE_NUM
+} audio_dma_profile_id_t;
+
+typedef struct {
+    const char *name;
+    uint32_t frame_num; //dma frame num，一个DMA缓冲的采样帧数
+    uint32_t desc_num;  //DMA描述符（缓冲）个数
+} audio_dma_profile_t;
+
+#if CONFIG_AUDIO_DMA_PROFILE_LOW_LATENCY
+#define AUDIO_DMA_PROFILE_DEFAULT AUDIO_DMA_PROFILE_LOW_LATENCY
+#elif CONFIG_AUDIO_DMA_PROFILE_LOW_POWER
+#define AUDIO_DMA_PROFILE_DEFAULT AUDIO_DMA_PROFILE_LOW_POWER
+#else
+#define AUDIO_DMA_PROFILE_DEFAULT AUDIO_DMA_PROFILE_BALANCED
+#endif
+
+//流水线帧缓冲的大小：任何档位下都能放下一个RX或TX的DMA缓冲，以及升采样后处理链的输出
+#define I2S_DMA_BUF_SIZE_MAX (I2S_DMA_FRAME_MAX * I2S_FRAME_BYTES_MAX)
+#if STREAM_SAMPLE_RATE != MIC_SAMPLE_RATE
+#define STREAM_BUF_SIZE_MAX ((I2S_DMA_FRAME_MAX * STREAM_SAMPLE_RATE / MIC_SAMPLE_RATE + 2) * I2S_TX_FRAME_BYTES)
+#define BUF_SIZE (I2S_DMA_BUF_SIZE_MAX > STREAM_BUF_SIZE_MAX ? I2S_DMA_BUF_SIZE_MAX : STREAM_BUF_SIZE_MAX)
+#else
+#define BUF_SIZE I2S_DMA_BUF_SIZE_MAX
+#endif
 
 #endif
\ No newline at end of file
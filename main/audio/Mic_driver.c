@@ -1,36 +1,94 @@
 #include "Audio_common.h"
 #include "esp_log.h"
 #include "Mic_driver.h"
-#include <math.h>
+#include "esp_timer.h"
+#include "audio_simd.h"
 #include "websocket_client.h"
 
 #define TAG  "INMP441"
 
 
-uint8_t buf[BUF_SIZE] = {0};
 i2s_chan_handle_t rx_handle =NULL;
 
+//接收完成时刻环形记录，中断里写入，采集任务按顺序取出
+#define RX_STAMP_NUM 8
+static int64_t rx_stamp[RX_STAMP_NUM];
+static volatile uint32_t rx_stamp_head = 0;
+static uint32_t rx_stamp_tail = 0;
+static TaskHandle_t rx_notify_task = NULL;//收到数据后需要唤醒的任务
+
+//溢出计数在中断里写，其余在采集任务里写
+static mic_stats_t rx_stats;
+
+//64位的时刻在中断和任务之间不是原子的，rx_stamp和溢出统计的读写都在这把锁里
+static portMUX_TYPE rx_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static size_t rx_frame_bytes = 0;//一个DMA缓冲的字节数
+
 audio_processor_t audio_proc = {
     .gain = 15.0f,//增益倍数
     .compression_threshold = 10000000.0f,//压缩阈值
     .compression_ratio = 1.0f,//压缩比例
-    .enable_agc = true//是否启用自动增益
+    .enable_agc = true,//是否启用自动增益
+    .use_fixed_point = true,//使用定点内核
+    .gain_q24 = GAIN_TO_Q24(15.0f),
+    .compression_threshold_q31 = 10000000,
+    .inv_ratio_q31 = INV_RATIO_TO_Q31(1.0f),
+    .limit = INT32_MAX,//硬限幅
+    .agc = AUDIO_AGC_INIT(STREAM_SAMPLE_RATE, AUDIO_CHANNELS),//自动增益
 };
 
-//初始化i2s rx，用于从INMP441接收数据
-esp_err_t i2s_rx_init(void)
+//DMA接收完成回调，在中断中执行：记录时刻并唤醒采集任务
+static IRAM_ATTR bool i2s_rx_on_recv(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    BaseType_t need_yield = pdFALSE;
+
+    portENTER_CRITICAL_ISR(&rx_lock);
+    rx_stamp[rx_stamp_head % RX_STAMP_NUM] = esp_timer_get_time();
+    rx_stamp_head++;
+    portEXIT_CRITICAL_ISR(&rx_lock);
+
+    if (rx_notify_task != NULL) {
+        vTaskNotifyGiveFromISR(rx_notify_task, &need_yield);
+    }
+
+    return need_yield == pdTRUE;
+}
+
+//DMA接收队列溢出回调，在中断中执行：采集任务没有及时读走，最旧的一个DMA缓冲被覆盖
+static IRAM_ATTR bool i2s_rx_on_overflow(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    portENTER_CRITICAL_ISR(&rx_lock);
+    rx_stats.overflow_last_us = esp_timer_get_time();
+    rx_stats.overflow++;
+    portEXIT_CRITICAL_ISR(&rx_lock);
+
+    return false;
+}
+
+//初始化i2s rx，用于从INMP441接收数据，DMA缓冲按profile配置
+esp_err_t i2s_rx_init(const audio_dma_profile_t *profile)
 {
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
     
-    //dma frame num使用最大值，增大dma一次搬运的数据量，能够提高效率，减小杂音，使用1023可以做到没有一丝杂音
-    chan_cfg.dma_frame_num = 511;
-    i2s_new_channel(&chan_cfg, NULL, &rx_handle);
+    //dma frame num越大，dma一次搬运的数据量越大，中断越少，但每帧多等一个DMA缓冲的时间
+    chan_cfg.dma_frame_num = profile->frame_num;
+    chan_cfg.dma_desc_num = profile->desc_num;
+    esp_err_t ret = i2s_new_channel(&chan_cfg, NULL, &rx_handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
  
     i2s_std_config_t std_cfg = {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SAMPLE_RATE),
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(MIC_SAMPLE_RATE),
         
         //虽然inmp441采集数据为24bit，但是仍可使用32bit来接收，中间存储过程不需考虑，只要让声音怎么进来就怎么出去即可
+#if I2S_RX_CHANNELS == 1
+        //inmp441是单声道麦克风，只接收左声道，数据位宽16bit、声道位宽仍为32bit，由硬件取高16位
+        .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+#else
         .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT, I2S_SLOT_MODE_STEREO),
+#endif
         .gpio_cfg = {
             .mclk = I2S_GPIO_UNUSED,
             .dout = I2S_GPIO_UNUSED,
@@ -45,72 +103,106 @@ esp_err_t i2s_rx_init(void)
         },
     };
  
-    i2s_channel_init_std_mode(rx_handle, &std_cfg);
- 
-    i2s_channel_enable(rx_handle);
+#if I2S_RX_CHANNELS == 1
+    std_cfg.slot_cfg.slot_bit_width = I2S_SLOT_BIT_WIDTH_32BIT;
+#endif
+    ret = i2s_channel_init_std_mode(rx_handle, &std_cfg);
+
+    //回调必须在通道使能之前注册
+    i2s_event_callbacks_t cbs = {
+        .on_recv = i2s_rx_on_recv,
+        .on_recv_q_ovf = i2s_rx_on_overflow,
+    };
+    if (ret == ESP_OK) {
+        ret = i2s_channel_register_event_callback(rx_handle, &cbs, NULL);
+    }
+    if (ret == ESP_OK) {
+        ret = i2s_channel_enable(rx_handle);
+    }
+    if (ret != ESP_OK) {
+        //通道没有使能，可以直接删除
+        i2s_del_channel(rx_handle);
+        rx_handle = NULL;
+        return ret;
+    }
+    rx_frame_bytes = profile->frame_num * I2S_RX_FRAME_BYTES;
 
     return ESP_OK;
 }
 
-//软件放大
-void amplify_audio_buffer(void* buffer, size_t bytes, float gain)
+//关闭并删除rx通道，之后可以用另一档配置重新初始化
+void i2s_rx_deinit(void)
 {
-    // 假设是32位数据（24位数据存储在32位容器中）
-    int32_t* samples = (int32_t*)buffer;
-    size_t sample_count = bytes / sizeof(int32_t);
-    
-    for (size_t i = 0; i < sample_count; i++) {
-        // 应用增益，注意防止溢出
-        int64_t amplified = (int64_t)samples[i] * gain;
-        
-        // 限制在32位范围内
-        if (amplified > INT32_MAX) {
-            samples[i] = INT32_MAX;
-        } else if (amplified < INT32_MIN) {
-            samples[i] = INT32_MIN;
-        } else {
-            samples[i] = (int32_t)amplified;
-        }
+    if (rx_handle == NULL) {
+        return;
     }
+    i2s_channel_disable(rx_handle);
+    i2s_del_channel(rx_handle);
+    rx_handle = NULL;
 }
 
-//动态范围压缩
-void compress_audio_buffer(void* buffer, size_t bytes, float threshold, float ratio)
+//当前配置下一个DMA缓冲的字节数，mic_read每次读这么多
+size_t mic_frame_bytes(void)
 {
-    int32_t* samples = (int32_t*)buffer;
-    size_t sample_count = bytes / sizeof(int32_t);
-    
-    for (size_t i = 0; i < sample_count; i++) {
-        float sample = (float)samples[i];
-        float abs_sample = fabsf(sample);
-        
-        if (abs_sample > threshold) {
-            // 超过阈值的部分按比例压缩
-            float excess = abs_sample - threshold;
-            float compressed_excess = excess / ratio;
-            float compressed_sample = threshold + compressed_excess;
-            
-            samples[i] = (int32_t)(copysignf(compressed_sample, sample));
-        }
-    }
+    return rx_frame_bytes;
 }
 
-//音频处理
-void process_audio_buffer(void* buffer, size_t bytes, audio_processor_t* proc)
+//设置DMA接收完成后要唤醒的任务，之后由该任务调用mic_wait
+void mic_set_notify_task(TaskHandle_t task)
 {
-    if (proc->enable_agc) {
-        compress_audio_buffer(buffer, bytes, proc->compression_threshold, proc->compression_ratio);
+    rx_stamp_tail = rx_stamp_head;
+    rx_notify_task = task;
+}
+
+//等待一个DMA缓冲接收完成，timestamp_us返回该缓冲在中断中记录的完成时刻
+esp_err_t mic_wait(TickType_t timeout, int64_t *timestamp_us)
+{
+    if (ulTaskNotifyTake(pdFALSE, timeout) == 0) {
+        return ESP_ERR_TIMEOUT;
     }
-    
-    amplify_audio_buffer(buffer, bytes, proc->gain);
+
+    //积压超过记录深度时只保留最近的时刻，此时DMA本身已经溢出，中断可能正在改写最旧的一项
+    portENTER_CRITICAL(&rx_lock);
+    if (rx_stamp_head - rx_stamp_tail > RX_STAMP_NUM) {
+        rx_stamp_tail = rx_stamp_head - RX_STAMP_NUM;
+    }
+    *timestamp_us = rx_stamp[rx_stamp_tail % RX_STAMP_NUM];
+    rx_stamp_tail++;
+    portEXIT_CRITICAL(&rx_lock);
+
+    return ESP_OK;
 }
 
-//音频读取
-esp_err_t mic_read(void)
+//音频读取，读入调用者提供的缓冲区，bytes_read返回实际读到的字节数
+esp_err_t mic_read(void *dst, size_t size, size_t *bytes_read)
 {
-    size_t bytes = 0;
+    *bytes_read = 0;
+
+    esp_err_t ret = i2s_channel_read(rx_handle,dst,size,bytes_read,1000);
+
+    rx_stats.reads++;
+    if (ret != ESP_OK) {
+        rx_stats.read_errors++;
+    }
+    if (*bytes_read < size) {
+        rx_stats.short_reads++;
+        rx_stats.short_bytes += size - *bytes_read;
+    }
 
-    esp_err_t ret = i2s_channel_read(rx_handle,buf,BUF_SIZE,&bytes,1000);
+#if CONFIG_AUDIO_CAPTURE_SW_EXTRACT
+    //硬件不能直接给出单声道16bit时，在原缓冲区里提取左声道并截成16bit
+    size_t frame_count = *bytes_read / (I2S_RX_CHANNELS * sizeof(int32_t));
+    audio_extract_mono_s16((const int32_t*)dst, (int16_t*)dst, frame_count, 0);
+    *bytes_read = frame_count * sizeof(int16_t);
+#endif
 
     return ret;
 }
+
+//获取采集统计
+void mic_get_stats(mic_stats_t *out)
+{
+    portENTER_CRITICAL(&rx_lock);
+    *out = rx_stats;
+    portEXIT_CRITICAL(&rx_lock);
+}
@@ -4,26 +4,32 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "freertos/task.h"
+#include "audio_process.h"
 
 //INMP引脚
 #define INMP_SD     GPIO_NUM_5
 #define INMP_SCK    GPIO_NUM_4
 #define INMP_WS     GPIO_NUM_6
 
+//I2S接收统计
 typedef struct {
-    float gain;           // 增益倍数
-    float compression_threshold; // 压缩阈值
-    float compression_ratio;     // 压缩比例
-    bool enable_agc;      // 是否启用自动增益
-} audio_processor_t;
-
+    uint32_t reads;         //mic_read调用次数
+    uint32_t read_errors;   //i2s_channel_read返回错误的次数
+    uint32_t short_reads;   //读到的字节数少于请求的次数
+    uint32_t short_bytes;   //短读累计少读的字节数
+    uint32_t overflow;      //DMA接收队列溢出次数，每次丢失一个DMA缓冲
+    int64_t overflow_last_us; //最近一次溢出的时刻（esp_timer），0表示没有发生过
+} mic_stats_t;
 
 extern i2s_chan_handle_t rx_handle;
+extern audio_processor_t audio_proc;
 
-esp_err_t i2s_rx_init(void);
-esp_err_t mic_read(void);
-void amplify_audio_buffer(void* buffer, size_t bytes, float gain);
-void compress_audio_buffer(void* buffer, size_t bytes, float threshold, float ratio);
-void process_audio_buffer(void* buffer, size_t bytes, audio_processor_t* proc);
+esp_err_t i2s_rx_init(const audio_dma_profile_t *profile);
+void i2s_rx_deinit(void);
+size_t mic_frame_bytes(void);
+void mic_set_notify_task(TaskHandle_t task);
+esp_err_t mic_wait(TickType_t timeout, int64_t *timestamp_us);
+esp_err_t mic_read(void *dst, size_t size, size_t *bytes_read);
+void mic_get_stats(mic_stats_t *out);
 
 #endif
\ No newline at end of file
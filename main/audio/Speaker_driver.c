@@ -1,21 +1,74 @@
 #include "Audio_common.h"
 #include "Speaker_driver.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #define TAG "SPEAKER"
 
 i2s_chan_handle_t tx_handle = NULL;
 
-//初始化tx，用于向MAX98357A写数据
-esp_err_t i2s_tx_init(void)
+//当前的DMA配置，两者的乘积决定写入的数据要排队多久才播放
+static uint32_t tx_frame_num = 0;
+static uint32_t tx_desc_num = 0;
+
+static volatile uint32_t tx_sent_count = 0;//已经发送完成的DMA缓冲数
+static volatile int64_t tx_sent_us = 0;//最近一次发送完成的时刻
+static TaskHandle_t tx_notify_task = NULL;//每发送完一个DMA缓冲唤醒的任务
+
+//欠载计数在中断里写，其余在播放任务里写
+static spk_stats_t tx_stats;
+
+//64位的时刻在中断和任务之间不是原子的，tx_sent_us和欠载统计的读写都在这把锁里
+static portMUX_TYPE tx_lock = portMUX_INITIALIZER_UNLOCKED;
+
+//DMA发送完成回调，在中断中执行
+static IRAM_ATTR bool i2s_tx_on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    BaseType_t need_yield = pdFALSE;
+
+    portENTER_CRITICAL_ISR(&tx_lock);
+    tx_sent_us = esp_timer_get_time();
+    tx_sent_count++;
+    portEXIT_CRITICAL_ISR(&tx_lock);
+    if (tx_notify_task != NULL) {
+        vTaskNotifyGiveFromISR(tx_notify_task, &need_yield);
+    }
+
+    return need_yield == pdTRUE;
+}
+
+//DMA发送队列溢出回调，在中断中执行：所有DMA缓冲都已播完而没有新数据写入，auto_clear输出了静音
+static IRAM_ATTR bool i2s_tx_on_underflow(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    portENTER_CRITICAL_ISR(&tx_lock);
+    tx_stats.underflow_last_us = esp_timer_get_time();
+    tx_stats.underflow++;
+    portEXIT_CRITICAL_ISR(&tx_lock);
+
+    return false;
+}
+
+//初始化tx，用于向MAX98357A写数据，DMA缓冲按profile配置，和rx保持一致
+esp_err_t i2s_tx_init(const audio_dma_profile_t *profile)
 {
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_1, I2S_ROLE_MASTER);
-    chan_cfg.dma_frame_num = 511;
-    i2s_new_channel(&chan_cfg, &tx_handle, NULL);
+    chan_cfg.dma_frame_num = profile->frame_num;
+    chan_cfg.dma_desc_num = profile->desc_num;
+    //没有新数据时DMA自动输出静音，播放欠载不会重复播放旧数据
+    chan_cfg.auto_clear = true;
+    esp_err_t ret = i2s_new_channel(&chan_cfg, &tx_handle, NULL);
+    if (ret != ESP_OK) {
+        return ret;
+    }
  
     i2s_std_config_t std_cfg = {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SAMPLE_RATE),
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(STREAM_SAMPLE_RATE),
+        //和流水线的格式一致，单声道时硬件把同一份数据送到左右两个声道
+#if AUDIO_CHANNELS == 1
+        .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT,I2S_SLOT_MODE_MONO),
+#else
         .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT,I2S_SLOT_MODE_STEREO),
+#endif
         .gpio_cfg = {
             .mclk = I2S_GPIO_UNUSED,
             .din = I2S_GPIO_UNUSED,
@@ -30,25 +83,118 @@ esp_err_t i2s_tx_init(void)
         },
     };
  
-    i2s_channel_init_std_mode(tx_handle, &std_cfg);
- 
-    i2s_channel_enable(tx_handle);
+    ret = i2s_channel_init_std_mode(tx_handle, &std_cfg);
+
+    i2s_event_callbacks_t cbs = {
+        .on_sent = i2s_tx_on_sent,
+        .on_send_q_ovf = i2s_tx_on_underflow,
+    };
+    if (ret == ESP_OK) {
+        ret = i2s_channel_register_event_callback(tx_handle, &cbs, NULL);
+    }
+    if (ret == ESP_OK) {
+        ret = i2s_channel_enable(tx_handle);
+    }
+    if (ret != ESP_OK) {
+        //通道没有使能，可以直接删除
+        i2s_del_channel(tx_handle);
+        tx_handle = NULL;
+        return ret;
+    }
+    tx_frame_num = profile->frame_num;
+    tx_desc_num = profile->desc_num;
 
     return ESP_OK;
 }
 
-//音频播放
-esp_err_t spk_write(void)
+//关闭并删除tx通道，之后可以用另一档配置重新初始化
+void i2s_tx_deinit(void)
+{
+    if (tx_handle == NULL) {
+        return;
+    }
+    i2s_channel_disable(tx_handle);
+    i2s_del_channel(tx_handle);
+    tx_handle = NULL;
+}
+
+//当前配置下一个DMA缓冲的字节数，每次按这个大小写入刚好填满一个DMA缓冲
+size_t spk_frame_bytes(void)
+{
+    return tx_frame_num * I2S_TX_FRAME_BYTES;
+}
+
+//音频播放，写出调用者提供的缓冲区
+esp_err_t spk_write(const void *src, size_t size)
 {
     size_t bytes = 0;
-    esp_err_t ret = i2s_channel_write(tx_handle, buf,BUF_SIZE,&bytes,1000);
+    esp_err_t ret = i2s_channel_write(tx_handle, src,size,&bytes,1000);
+
+    tx_stats.writes++;
     if (ret != ESP_OK)
     {
+        tx_stats.write_errors++;
         ESP_LOGE(TAG,"SPEAKER 写入失败：%s",esp_err_to_name(ret));
-    }else if (bytes == 0)
+    }
+    if (bytes < size)
     {
-        ESP_LOGW(TAG,"写入0字节");
+        //超时只写进去一部分，剩下的被丢弃
+        tx_stats.short_writes++;
+        tx_stats.short_bytes += size - bytes;
+        ESP_LOGW(TAG,"只写入%u/%u字节",(unsigned)bytes,(unsigned)size);
     }
 
     return ret;
+}
+
+//设置DMA发送完成后要唤醒的任务，之后由该任务调用spk_wait
+void spk_set_notify_task(TaskHandle_t task)
+{
+    tx_notify_task = task;
+}
+
+//等待下一个DMA缓冲发送完成，没有数据可写时用它按播放时钟计时
+//auto_clear输出静音时也会发送完成，调用前积累的通知不算
+esp_err_t spk_wait(TickType_t timeout)
+{
+    uint32_t sent = tx_sent_count;
+    while (tx_sent_count == sent) {
+        if (ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ESP_OK;
+}
+
+//获取已发送完成的DMA缓冲数以及最近一次发送完成的时刻
+uint32_t spk_get_sent(int64_t *last_sent_us)
+{
+    portENTER_CRITICAL(&tx_lock);
+    uint32_t count = tx_sent_count;
+    if (last_sent_us != NULL) {
+        *last_sent_us = tx_sent_us;
+    }
+    portEXIT_CRITICAL(&tx_lock);
+
+    return count;
+}
+
+//估计刚写完的size字节中第一个样本的播放时刻
+//spk_write阻塞到数据全部放进DMA缓冲才返回，此时DMA队列基本是满的，最后一个样本要等整个队列播完
+int64_t spk_play_time_us(size_t size)
+{
+    int64_t queued = (int64_t)tx_desc_num * tx_frame_num - (int64_t)(size / I2S_TX_FRAME_BYTES);
+    if (queued < 0) {
+        queued = 0;
+    }
+
+    return esp_timer_get_time() + queued * 1000000 / STREAM_SAMPLE_RATE;
+}
+
+//获取播放统计
+void spk_get_stats(spk_stats_t *out)
+{
+    portENTER_CRITICAL(&tx_lock);
+    *out = tx_stats;
+    portEXIT_CRITICAL(&tx_lock);
 }
\ No newline at end of file
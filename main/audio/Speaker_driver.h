@@ -6,9 +6,26 @@
 #define MAX_BCLK    GPIO_NUM_7
 #define MAX_LRC     GPIO_NUM_16
 
+//I2S发送统计
+typedef struct {
+    uint32_t writes;        //spk_write调用次数
+    uint32_t write_errors;  //i2s_channel_write返回错误的次数
+    uint32_t short_writes;  //写入的字节数少于请求的次数
+    uint32_t short_bytes;   //短写累计丢弃的字节数
+    uint32_t underflow;     //DMA发送队列播空的次数，包括没有下行数据时的空闲静音
+    int64_t underflow_last_us; //最近一次播空的时刻（esp_timer），0表示没有发生过
+} spk_stats_t;
+
 extern i2s_chan_handle_t tx_handle;
 
-esp_err_t i2s_tx_init(void);
-esp_err_t spk_write(void);
+esp_err_t i2s_tx_init(const audio_dma_profile_t *profile);
+void i2s_tx_deinit(void);
+size_t spk_frame_bytes(void);
+esp_err_t spk_write(const void *src, size_t size);
+void spk_set_notify_task(TaskHandle_t task);
+esp_err_t spk_wait(TickType_t timeout);
+uint32_t spk_get_sent(int64_t *last_sent_us);
+int64_t spk_play_time_us(size_t size);
+void spk_get_stats(spk_stats_t *out);
 
 #endif
\ No newline at end of file
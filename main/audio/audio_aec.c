@@ -0,0 +1,294 @@
+#include "audio_aec.h"
+#include "esp_heap_caps.h"
+#include "esp_cpu.h"
+#include <math.h>
+#include <string.h>
+#include <stdbool.h>
+
+//参考信号环形缓冲的长度，要能覆盖TX DMA队列加上麦克风帧的延迟
+#define REF_RING_MS 500
+
+//参考信号取得比估计的播放时刻稍早一点，估计偏晚时回声仍落在滤波器窗口内
+#define REF_LEAD_US 4000
+
+//播放时间线与估计相差超过这个值时重新对齐（欠载后DMA输出过静音、播放重新开始）
+#define REF_RESYNC_US 3000
+
+#define POWER_SMOOTH  0.9f  //参考功率平滑系数
+#define ENERGY_SMOOTH 0.95f //步长控制用的能量平滑系数
+#define REF_ACTIVE    1e-6f //每样本参考能量低于此值（约-60dBFS）时不更新滤波器
+#define CONVERGED_ERLE 2.0f //ERLE超过3dB后才按双讲调整步长
+
+static void *aec_alloc(size_t size)
+{
+    void *p = heap_caps_calloc(1, size, MALLOC_CAP_INTERNAL);
+    if (p == NULL) {
+        p = heap_caps_calloc(1, size, MALLOC_CAP_SPIRAM);
+    }
+    return p;
+}
+
+//tail_ms为要消除的回声尾长，max_frame为audio_aec_process一次最多处理的样本数
+esp_err_t audio_aec_init(audio_aec_t *aec, uint32_t sample_rate, uint32_t tail_ms, size_t max_frame)
+{
+    memset(aec, 0, sizeof(*aec));
+    aec->sample_rate = sample_rate;
+    aec->partitions = (int)((sample_rate * tail_ms / 1000 + AUDIO_AEC_BLOCK - 1) / AUDIO_AEC_BLOCK);
+    if (aec->partitions < 1) {
+        aec->partitions = 1;
+    }
+    aec->mu = 0.5f / aec->partitions;
+
+    esp_err_t ret = audio_fft_init(&aec->fft, AUDIO_AEC_FFT);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    size_t spectrum = AUDIO_AEC_FFT * 2 * sizeof(float);
+    aec->X = aec_alloc(aec->partitions * spectrum);
+    aec->W = aec_alloc(aec->partitions * spectrum);
+    aec->power = aec_alloc(AUDIO_AEC_FFT * sizeof(float));
+    aec->work = aec_alloc(spectrum);
+    aec->ref_prev = aec_alloc(AUDIO_AEC_BLOCK * sizeof(float));
+
+    //输出先垫一块静音，之后每进一块出一块
+    aec->out_cap = max_frame + 2 * AUDIO_AEC_BLOCK;
+    aec->out_fifo = aec_alloc(aec->out_cap * sizeof(int16_t));
+    aec->out_count = AUDIO_AEC_BLOCK;
+
+    aec->ref_len = sample_rate * REF_RING_MS / 1000;
+    aec->ref_ring = aec_alloc(aec->ref_len * sizeof(int16_t));
+    aec->ref_lock = xSemaphoreCreateMutex();
+
+    if (aec->X == NULL || aec->W == NULL || aec->power == NULL || aec->work == NULL || aec->ref_prev == NULL ||
+        aec->out_fifo == NULL || aec->ref_ring == NULL || aec->ref_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+//写入远端参考，play_us为第一个样本的估计播放时刻，在播放任务中调用
+void audio_aec_push_reference(audio_aec_t *aec, const int16_t *pcm, size_t count, int64_t play_us)
+{
+    xSemaphoreTake(aec->ref_lock, portMAX_DELAY);
+
+    int64_t gap_us = play_us - aec->ref_end_us;
+    if (aec->ref_written == 0 || gap_us > REF_RESYNC_US || gap_us < -REF_RESYNC_US) {
+        //欠载期间DMA输出的是静音，补上对应长度的零，保持时间线连续
+        if (aec->ref_written != 0 && gap_us > 0) {
+            uint64_t zeros = (uint64_t)gap_us * aec->sample_rate / 1000000;
+            zeros = zeros < aec->ref_len ? zeros : aec->ref_len;
+            for (uint64_t i = 0; i < zeros; i++) {
+                aec->ref_ring[aec->ref_written++ % aec->ref_len] = 0;
+            }
+        }
+        aec->ref_end_us = play_us;
+        aec->stats.ref_resync++;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        aec->ref_ring[aec->ref_written++ % aec->ref_len] = pcm[i];
+    }
+    aec->ref_end_us += (int64_t)count * 1000000 / aec->sample_rate;
+
+    xSemaphoreGive(aec->ref_lock);
+}
+
+//取出与麦克风帧对齐的count个参考样本，end_us为最后一个样本的播放时刻，不在缓冲里的按静音处理
+//读位置按样本连续推进，只有和时间戳算出的位置偏差超过REF_RESYNC_US时才跳过去，否则取整误差会让回声路径来回抖一个样本
+static void ref_read(audio_aec_t *aec, int64_t end_us, int16_t *out, size_t count)
+{
+    xSemaphoreTake(aec->ref_lock, portMAX_DELAY);
+
+    int64_t behind = (aec->ref_end_us - end_us) * aec->sample_rate / 1000000;
+    int64_t expected = (int64_t)aec->ref_written - behind - (int64_t)count;
+    int64_t tolerance = (int64_t)aec->sample_rate * REF_RESYNC_US / 1000000;
+    if (!aec->ref_pos_valid || aec->ref_pos - expected > tolerance || expected - aec->ref_pos > tolerance) {
+        aec->ref_pos = expected;
+        aec->ref_pos_valid = aec->ref_written != 0;
+        aec->stats.ref_resync++;
+    }
+
+    int64_t oldest = (int64_t)aec->ref_written - (int64_t)aec->ref_len;
+    for (size_t i = 0; i < count; i++) {
+        int64_t idx = aec->ref_pos + (int64_t)i;
+        if (aec->ref_written == 0 || idx < 0 || idx < oldest || idx >= (int64_t)aec->ref_written) {
+            out[i] = 0;
+            aec->stats.ref_missing++;
+        } else {
+            out[i] = aec->ref_ring[idx % aec->ref_len];
+        }
+    }
+    aec->ref_pos += count;
+
+    xSemaphoreGive(aec->ref_lock);
+}
+
+//复数乘加 acc += a * b，conj_a为true时用a的共轭
+static inline void cmac(float *acc, const float *a, const float *b, bool conj_a, float scale)
+{
+    float ai = conj_a ? -a[1] : a[1];
+    acc[0] += (a[0] * b[0] - ai * b[1]) * scale;
+    acc[1] += (a[0] * b[1] + ai * b[0]) * scale;
+}
+
+//处理一块：估计回声、相减、更新滤波器，结果写回mic_block
+static void aec_block(audio_aec_t *aec)
+{
+    const size_t n = AUDIO_AEC_BLOCK;
+    const size_t f = AUDIO_AEC_FFT;
+    float *work = aec->work;
+    float echo[AUDIO_AEC_BLOCK];
+    float err[AUDIO_AEC_BLOCK];
+
+    //参考频谱：上一块和这一块拼成2N点
+    float ref_energy = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        float x = aec->ref_block[i] / 32768.0f;
+        work[2 * i] = aec->ref_prev[i];
+        work[2 * i + 1] = 0.0f;
+        work[2 * (n + i)] = x;
+        work[2 * (n + i) + 1] = 0.0f;
+        aec->ref_prev[i] = x;
+        ref_energy += x * x;
+    }
+    audio_fft_forward(&aec->fft, work);
+
+    aec->head = (aec->head + 1) % aec->partitions;
+    float *x0 = aec->X + (size_t)aec->head * f * 2;
+    memcpy(x0, work, f * 2 * sizeof(float));
+    for (size_t k = 0; k < f; k++) {
+        float p = x0[2 * k] * x0[2 * k] + x0[2 * k + 1] * x0[2 * k + 1];
+        aec->power[k] = POWER_SMOOTH * aec->power[k] + (1.0f - POWER_SMOOTH) * p;
+    }
+
+    //回声估计 Y = sum W_p * X_(head-p)，取逆变换的后N点
+    memset(work, 0, f * 2 * sizeof(float));
+    for (int p = 0; p < aec->partitions; p++) {
+        const float *xp = aec->X + (size_t)((aec->head - p + aec->partitions) % aec->partitions) * f * 2;
+        const float *wp = aec->W + (size_t)p * f * 2;
+        for (size_t k = 0; k < f; k++) {
+            cmac(&work[2 * k], wp + 2 * k, xp + 2 * k, false, 1.0f);
+        }
+    }
+    audio_fft_inverse(&aec->fft, work);
+
+    float mic_energy = 0.0f;
+    float err_energy = 0.0f;
+    float echo_energy = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        float d = aec->mic_block[i] / 32768.0f;
+        echo[i] = work[2 * (n + i)];
+        err[i] = d - echo[i];
+        mic_energy += d * d;
+        err_energy += err[i] * err[i];
+        echo_energy += echo[i] * echo[i];
+
+        float out = err[i] * 32768.0f;
+        out = out > 32767.0f ? 32767.0f : (out < -32768.0f ? -32768.0f : out);
+        aec->mic_block[i] = (int16_t)lrintf(out);
+    }
+
+    aec->stats.blocks++;
+    if (ref_energy < REF_ACTIVE * n) {
+        return;//远端没有声音，没有回声可学
+    }
+
+    aec->mic_energy = ENERGY_SMOOTH * aec->mic_energy + (1.0f - ENERGY_SMOOTH) * mic_energy;
+    aec->err_energy = ENERGY_SMOOTH * aec->err_energy + (1.0f - ENERGY_SMOOTH) * err_energy;
+    aec->echo_energy = ENERGY_SMOOTH * aec->echo_energy + (1.0f - ENERGY_SMOOTH) * echo_energy;
+    float erle = aec->mic_energy / (aec->err_energy + 1e-12f);
+    aec->stats.erle_db = 10.0f * log10f(erle + 1e-12f);
+
+    //收敛后残差远大于回声估计说明近端在说话（双讲），减小步长防止滤波器被带偏
+    float mu = aec->mu;
+    if (erle > CONVERGED_ERLE) {
+        mu *= aec->echo_energy / (aec->echo_energy + aec->err_energy + 1e-12f);
+    }
+
+    //误差频谱：前N点补零
+    for (size_t i = 0; i < n; i++) {
+        work[2 * i] = 0.0f;
+        work[2 * i + 1] = 0.0f;
+        work[2 * (n + i)] = err[i];
+        work[2 * (n + i) + 1] = 0.0f;
+    }
+    audio_fft_forward(&aec->fft, work);
+
+    //归一化步长，按频点功率
+    float delta = (float)f * REF_ACTIVE;
+    for (size_t k = 0; k < f; k++) {
+        float g = mu / (aec->power[k] + delta);
+        work[2 * k] *= g;
+        work[2 * k + 1] *= g;
+    }
+
+    //W_p += conj(X_(head-p)) * E
+    for (int p = 0; p < aec->partitions; p++) {
+        const float *xp = aec->X + (size_t)((aec->head - p + aec->partitions) % aec->partitions) * f * 2;
+        float *wp = aec->W + (size_t)p * f * 2;
+        for (size_t k = 0; k < f; k++) {
+            cmac(wp + 2 * k, xp + 2 * k, work + 2 * k, true, 1.0f);
+        }
+    }
+
+    //梯度约束：每块轮流对一个分块把时域后N点清零，保证是线性卷积，成本平摊到各块
+    float *wc = aec->W + (size_t)aec->constrain_next * f * 2;
+    memcpy(work, wc, f * 2 * sizeof(float));
+    audio_fft_inverse(&aec->fft, work);
+    memset(&work[2 * n], 0, n * 2 * sizeof(float));
+    audio_fft_forward(&aec->fft, work);
+    memcpy(wc, work, f * 2 * sizeof(float));
+    aec->constrain_next = (aec->constrain_next + 1) % aec->partitions;
+
+    aec->stats.adapted++;
+}
+
+//原地消除一帧的回声，end_us为该帧最后一个样本的采集时刻。输出比输入晚AUDIO_AEC_BLOCK个样本
+void audio_aec_process(audio_aec_t *aec, int16_t *samples, size_t count, int64_t end_us)
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+    int blocks = 0;
+    size_t done = 0;
+
+    while (done < count) {
+        size_t m = AUDIO_AEC_BLOCK - aec->block_fill;
+        m = m < count - done ? m : count - done;
+
+        //这一段的最后一个样本在帧尾之前(count - done - m)个样本
+        int64_t piece_end_us = end_us - (int64_t)(count - done - m) * 1000000 / aec->sample_rate;
+        memcpy(aec->mic_block + aec->block_fill, samples + done, m * sizeof(int16_t));
+        ref_read(aec, piece_end_us + REF_LEAD_US, aec->ref_block + aec->block_fill, m);
+        aec->block_fill += m;
+        done += m;
+
+        if (aec->block_fill == AUDIO_AEC_BLOCK) {
+            aec_block(aec);
+            blocks++;
+            for (size_t i = 0; i < AUDIO_AEC_BLOCK; i++) {
+                aec->out_fifo[(aec->out_read + aec->out_count++) % aec->out_cap] = aec->mic_block[i];
+            }
+            aec->block_fill = 0;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = aec->out_fifo[aec->out_read];
+        aec->out_read = (aec->out_read + 1) % aec->out_cap;
+    }
+    aec->out_count -= count;
+
+    if (blocks > 0) {
+        aec->stats.cycles = (esp_cpu_get_cycle_count() - start) / blocks;
+        if (aec->stats.cycles > aec->stats.cycles_max) {
+            aec->stats.cycles_max = aec->stats.cycles;
+        }
+    }
+}
+
+//获取统计
+void audio_aec_get_stats(audio_aec_t *aec, audio_aec_stats_t *stats)
+{
+    *stats = aec->stats;
+}
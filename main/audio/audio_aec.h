@@ -0,0 +1,72 @@
+#ifndef __AUDIO_AEC_H_
+#define __AUDIO_AEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "audio_fft.h"
+
+//块长（样本数），也是AEC引入的固定延迟，16kHz时8ms
+#define AUDIO_AEC_BLOCK 128
+#define AUDIO_AEC_FFT   (2 * AUDIO_AEC_BLOCK)
+
+//回声消除统计
+typedef struct {
+    uint32_t blocks;        //处理的块数
+    uint32_t adapted;       //有远端信号、更新了滤波器的块数
+    uint32_t ref_missing;   //参考信号不在环形缓冲里、按静音处理的样本数
+    uint32_t ref_resync;    //参考信号重新对齐的次数（欠载、重新开始播放）
+    float erle_db;          //回声损耗增强，远端有声时平滑的麦克风能量/残差能量
+    uint32_t cycles;        //最近一块的耗时（CPU周期）
+    uint32_t cycles_max;    //单块耗时的最大值
+} audio_aec_stats_t;
+
+//分块频域NLMS回声消除（overlap-save），16位单声道
+//远端参考是写进I2S TX的数据，按估计的播放时刻存进环形缓冲，与麦克风帧的DMA时间戳对齐
+typedef struct {
+    uint32_t sample_rate;
+    int partitions;         //分块数，滤波器长度 = partitions * AUDIO_AEC_BLOCK
+    float mu;               //步长
+    audio_fft_t fft;
+
+    //频域状态，全部在初始化时分配
+    float *X;               //partitions个参考频谱，环形使用
+    float *W;               //partitions个滤波器频谱
+    float *power;           //每个频点的参考功率（平滑）
+    float *work;            //FFT工作区
+    float *ref_prev;        //上一块参考信号
+    int head;               //X中最新一块的位置
+    int constrain_next;     //下一个做梯度约束的分块
+    float mic_energy;       //平滑能量，用于步长控制和ERLE
+    float err_energy;
+    float echo_energy;
+
+    //块缓冲：麦克风帧长度与块长不同，攒满一块处理一次
+    int16_t mic_block[AUDIO_AEC_BLOCK];
+    int16_t ref_block[AUDIO_AEC_BLOCK];
+    size_t block_fill;
+    int16_t *out_fifo;      //处理后的样本，比输入晚一块
+    size_t out_cap;
+    size_t out_read;
+    size_t out_count;
+
+    //参考信号环形缓冲，播放任务写、采集任务读
+    SemaphoreHandle_t ref_lock;
+    int16_t *ref_ring;
+    size_t ref_len;
+    uint64_t ref_written;   //累计写入的样本数
+    int64_t ref_end_us;     //最后一个写入样本之后的播放时刻
+    int64_t ref_pos;        //下一个要读的参考样本（累计下标）
+    bool ref_pos_valid;
+
+    audio_aec_stats_t stats;
+} audio_aec_t;
+
+esp_err_t audio_aec_init(audio_aec_t *aec, uint32_t sample_rate, uint32_t tail_ms, size_t max_frame);
+void audio_aec_push_reference(audio_aec_t *aec, const int16_t *pcm, size_t count, int64_t play_us);
+void audio_aec_process(audio_aec_t *aec, int16_t *samples, size_t count, int64_t end_us);
+void audio_aec_get_stats(audio_aec_t *aec, audio_aec_stats_t *stats);
+
+#endif
@@ -0,0 +1,153 @@
+#include "audio_agc.h"
+#include <math.h>
+
+#define AGC_GAIN_FRAC_BITS 24
+#define AGC_FULL_SCALE 2147483648.0f
+
+//初始化AGC
+void audio_agc_init(audio_agc_t *agc, const audio_agc_config_t *cfg, uint32_t sample_rate, uint32_t channels)
+{
+    agc->sample_rate = sample_rate;
+    agc->channels = channels;
+    agc->envelope = 0.0f;
+    agc->gain_q24 = 1 << AGC_GAIN_FRAC_BITS;
+    audio_agc_set_config(agc, cfg);
+}
+
+//运行时修改配置，平滑系数在下一块重新计算
+void audio_agc_set_config(audio_agc_t *agc, const audio_agc_config_t *cfg)
+{
+    agc->cfg = *cfg;
+    if (agc->cfg.max_gain > 127.0f) {
+        agc->cfg.max_gain = 127.0f;
+    }
+    if (agc->cfg.min_gain > agc->cfg.max_gain) {
+        agc->cfg.min_gain = agc->cfg.max_gain;
+    }
+    agc->coeff_count = 0;
+}
+
+//按块长计算平滑系数：系数 = exp(-块时长 / 时间常数)，块长不变时只算一次
+static void agc_update_coeff(audio_agc_t *agc, size_t count)
+{
+    float block_ms = (float)count * 1000.0f / ((float)agc->sample_rate * agc->channels);
+
+    agc->attack_coeff = expf(-block_ms / agc->cfg.attack_ms);
+    agc->release_coeff = expf(-block_ms / agc->cfg.release_ms);
+    agc->coeff_count = count;
+}
+
+//检测一块的电平，峰值或RMS
+static float agc_detect_level(const audio_agc_t *agc, const int32_t *samples, size_t count)
+{
+    if (agc->cfg.use_peak) {
+        uint32_t peak = 0;
+        for (size_t i = 0; i < count; i++) {
+            int32_t s = samples[i];
+            uint32_t mag = s < 0 ? 0u - (uint32_t)s : (uint32_t)s;
+            peak = mag > peak ? mag : peak;
+        }
+        return (float)peak / AGC_FULL_SCALE;
+    }
+
+    //丢掉低16位再平方，1024个样本的平方和也不会溢出int64
+    int64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        int32_t s = samples[i] >> 16;
+        sum += (int64_t)s * s;
+    }
+    return sqrtf((float)sum / (float)count) * 65536.0f / AGC_FULL_SCALE;
+}
+
+//包络跟随并计算本块结束时的目标增益，level为本块电平
+static int32_t agc_update_gain(audio_agc_t *agc, float level, size_t count)
+{
+    if (agc->coeff_count != count) {
+        agc_update_coeff(agc, count);
+    }
+
+    float coeff = level > agc->envelope ? agc->attack_coeff : agc->release_coeff;
+    agc->envelope = coeff * agc->envelope + (1.0f - coeff) * level;
+
+    //噪声门关闭时回落到最小增益，避免放大底噪
+    float gain = agc->cfg.min_gain;
+    if (agc->envelope >= agc->cfg.noise_gate) {
+        gain = agc->cfg.target_level / agc->envelope;
+        gain = gain > agc->cfg.max_gain ? agc->cfg.max_gain : gain;
+        gain = gain < agc->cfg.min_gain ? agc->cfg.min_gain : gain;
+    }
+
+    return (int32_t)(gain * (float)(1 << AGC_GAIN_FRAC_BITS));
+}
+
+//AGC处理：每块计算一次目标增益，块内从上一块的增益线性插值过去
+void audio_agc_process(audio_agc_t *agc, int32_t *samples, size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    int32_t target_q24 = agc_update_gain(agc, agc_detect_level(agc, samples, count), count);
+    int32_t gain_q24 = agc->gain_q24;
+    int32_t step = (int32_t)(((int64_t)target_q24 - gain_q24) / (int64_t)count);
+
+    for (size_t i = 0; i < count; i++) {
+        gain_q24 += step;
+        int64_t value = ((int64_t)samples[i] * gain_q24) >> AGC_GAIN_FRAC_BITS;
+
+        value = value > INT32_MAX ? INT32_MAX : value;
+        value = value < INT32_MIN ? INT32_MIN : value;
+        samples[i] = (int32_t)value;
+    }
+
+    //插值的整除误差在这里消掉
+    agc->gain_q24 = target_q24;
+}
+
+//检测一块16位样本的电平
+static float agc_detect_level_s16(const audio_agc_t *agc, const int16_t *samples, size_t count)
+{
+    if (agc->cfg.use_peak) {
+        int32_t peak = 0;
+        for (size_t i = 0; i < count; i++) {
+            int32_t mag = samples[i] < 0 ? -(int32_t)samples[i] : samples[i];
+            peak = mag > peak ? mag : peak;
+        }
+        return (float)peak / 32768.0f;
+    }
+
+    int64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += (int32_t)samples[i] * samples[i];
+    }
+    return sqrtf((float)sum / (float)count) / 32768.0f;
+}
+
+//AGC处理，16位版本
+void audio_agc_process_s16(audio_agc_t *agc, int16_t *samples, size_t count)
+{
+    if (count == 0) {
+        return;
+    }
+
+    int32_t target_q24 = agc_update_gain(agc, agc_detect_level_s16(agc, samples, count), count);
+    int32_t gain_q24 = agc->gain_q24;
+    int32_t step = (int32_t)(((int64_t)target_q24 - gain_q24) / (int64_t)count);
+
+    for (size_t i = 0; i < count; i++) {
+        gain_q24 += step;
+        int32_t value = (int32_t)(((int64_t)samples[i] * gain_q24) >> AGC_GAIN_FRAC_BITS);
+
+        value = value > INT16_MAX ? INT16_MAX : value;
+        value = value < INT16_MIN ? INT16_MIN : value;
+        samples[i] = (int16_t)value;
+    }
+
+    agc->gain_q24 = target_q24;
+}
+
+//当前增益
+float audio_agc_get_gain(const audio_agc_t *agc)
+{
+    return (float)agc->gain_q24 / (float)(1 << AGC_GAIN_FRAC_BITS);
+}
@@ -0,0 +1,58 @@
+#ifndef __AUDIO_AGC_H_
+#define __AUDIO_AGC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+//AGC配置，电平均为相对满幅的比例（0~1）
+typedef struct {
+    float target_level; //目标电平
+    float noise_gate;   //噪声门限，包络低于该电平时增益回落到min_gain
+    float attack_ms;    //起音时间：电平上升时包络的跟随时间常数
+    float release_ms;   //释放时间：电平下降时包络的跟随时间常数
+    float max_gain;     //最大增益，不超过127
+    float min_gain;     //最小增益，同时也是噪声门关闭时的增益
+    bool use_peak;      //true使用峰值检测，false使用RMS检测
+} audio_agc_config_t;
+
+//AGC状态
+typedef struct {
+    audio_agc_config_t cfg;
+    uint32_t sample_rate;   //采样率
+    uint32_t channels;      //交织的声道数，用来换算块时长
+    float envelope;         //包络电平
+    int32_t gain_q24;       //上一块结束时的增益，Q7.24
+    size_t coeff_count;     //当前平滑系数对应的块长（样本数），块长变化时重新计算
+    float attack_coeff;     //每块的起音平滑系数
+    float release_coeff;    //每块的释放平滑系数
+} audio_agc_t;
+
+//默认配置：目标-12dBFS，噪声门-60dBFS，起音10ms，释放300ms
+#define AUDIO_AGC_DEFAULT_CONFIG() { \
+    .target_level = 0.25f,           \
+    .noise_gate = 0.001f,            \
+    .attack_ms = 10.0f,              \
+    .release_ms = 300.0f,            \
+    .max_gain = 30.0f,               \
+    .min_gain = 0.1f,                \
+    .use_peak = false,               \
+}
+
+//静态初始化，平滑系数在第一次处理时计算
+#define AUDIO_AGC_INIT(rate, ch) {           \
+    .cfg = AUDIO_AGC_DEFAULT_CONFIG(),       \
+    .sample_rate = (rate),                   \
+    .channels = (ch),                        \
+    .envelope = 0.0f,                        \
+    .gain_q24 = 1 << 24,                     \
+    .coeff_count = 0,                        \
+}
+
+void audio_agc_init(audio_agc_t *agc, const audio_agc_config_t *cfg, uint32_t sample_rate, uint32_t channels);
+void audio_agc_set_config(audio_agc_t *agc, const audio_agc_config_t *cfg);
+void audio_agc_process(audio_agc_t *agc, int32_t *samples, size_t count);
+void audio_agc_process_s16(audio_agc_t *agc, int16_t *samples, size_t count);
+float audio_agc_get_gain(const audio_agc_t *agc);
+
+#endif
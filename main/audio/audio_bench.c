@@ -0,0 +1,517 @@
+#include "Audio_common.h"
+#include "audio_bench.h"
+#include "Mic_driver.h"
+#include "audio_simd.h"
+#include "audio_resampler.h"
+#include "audio_bench_suite.h"
+#include "audio_pipeline.h"
+#include "audio_ring.h"
+#include "esp_websocket_client.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include <math.h>
+#include <string.h>
+
+#define TAG "BENCH"
+
+#define BENCH_SAMPLES 1024 //每轮处理的样本数
+#define BENCH_ROUNDS  32   //重复次数，取平均
+
+#define RING_ITEMS 20000 //跨核传递的项数
+#define RING_SLOTS 4
+
+#define PROFILE_SETTLE_MS 500  //切换档位后先跳过这段时间
+#define PROFILE_RUN_MS    5000 //每个档位的测量时长
+
+typedef void (*bench_kernel_t)(int32_t *samples, size_t bytes);
+
+static int32_t *bench_src = NULL; //输入数据
+static int32_t *bench_ref = NULL; //浮点参考输出
+static int32_t *bench_out = NULL; //被测内核输出
+static float bench_gain = 1.0f;   //增益加限幅测试使用的增益
+
+//固定种子的伪随机数，保证每次测试数据一致
+static uint32_t bench_rand(uint32_t *seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed;
+}
+
+//生成INMP441量级的测试数据：24位有效位放在32位容器的高位
+static void bench_fill(int32_t *samples, size_t count, uint32_t seed)
+{
+    for (size_t i = 0; i < count; i++) {
+        int32_t value = (int32_t)bench_rand(&seed) >> 8;
+        samples[i] = value << 4;//留出一些余量，增益后一部分样本会饱和
+    }
+}
+
+static void kernel_amplify_float(int32_t *samples, size_t bytes)
+{
+    amplify_audio_buffer(samples, bytes, audio_proc.gain);
+}
+
+static void kernel_amplify_q31(int32_t *samples, size_t bytes)
+{
+    amplify_audio_buffer_q31(samples, bytes, audio_proc.gain_q24);
+}
+
+static void kernel_compress_float(int32_t *samples, size_t bytes)
+{
+    compress_audio_buffer(samples, bytes, audio_proc.compression_threshold, audio_proc.compression_ratio);
+}
+
+static void kernel_compress_q31(int32_t *samples, size_t bytes)
+{
+    compress_audio_buffer_q31(samples, bytes, audio_proc.compression_threshold_q31, audio_proc.inv_ratio_q31);
+}
+
+static void kernel_amplify_loop(int32_t *samples, size_t bytes)
+{
+    amplify_audio_buffer(samples, bytes, bench_gain);
+}
+
+static void kernel_gain_limit_scalar(int32_t *samples, size_t bytes)
+{
+    audio_gain_limit_scalar(samples, bytes / sizeof(int32_t), GAIN_TO_Q24(bench_gain), audio_proc.limit);
+}
+
+static void kernel_gain_limit(int32_t *samples, size_t bytes)
+{
+    audio_gain_limit(samples, bytes / sizeof(int32_t), GAIN_TO_Q24(bench_gain), audio_proc.limit);
+}
+
+//测量内核的每样本周期数，输出留在out中
+static float bench_cycles(bench_kernel_t kernel, int32_t *out)
+{
+    uint32_t total = 0;
+
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        memcpy(out, bench_src, BENCH_SAMPLES * sizeof(int32_t));
+
+        uint32_t start = esp_cpu_get_cycle_count();
+        kernel(out, BENCH_SAMPLES * sizeof(int32_t));
+        total += esp_cpu_get_cycle_count() - start;
+    }
+
+    return (float)total / (BENCH_ROUNDS * BENCH_SAMPLES);
+}
+
+//比较定点输出与浮点参考，返回超出容差的样本数
+static int bench_compare(const char *name, int64_t *max_diff)
+{
+    int bad = 0;
+    *max_diff = 0;
+
+    for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+        int64_t diff = llabs((int64_t)bench_out[i] - bench_ref[i]);
+        int64_t limit = (int64_t)(fabsf((float)bench_ref[i]) * AUDIO_BENCH_REL_TOLERANCE) + 1;
+
+        if (diff > *max_diff) {
+            *max_diff = diff;
+        }
+        if (diff > limit) {
+            if (bad == 0) {
+                ESP_LOGW(TAG, "%s 第%u个样本超出容差：%ld vs %ld", name, (unsigned)i,
+                         (long)bench_out[i], (long)bench_ref[i]);
+            }
+            bad++;
+        }
+    }
+
+    return bad;
+}
+
+//对比一组浮点/定点内核：打印每样本周期数与最大误差
+static int bench_pair(const char *name, bench_kernel_t ref, bench_kernel_t fixed)
+{
+    int64_t max_diff = 0;
+
+    float ref_cycles = bench_cycles(ref, bench_ref);
+    float fixed_cycles = bench_cycles(fixed, bench_out);
+    int bad = bench_compare(name, &max_diff);
+
+    ESP_LOGI(TAG, "%-10s float %.2f cycles/sample, q31 %.2f cycles/sample, x%.2f, 最大误差 %lld LSB%s",
+             name, ref_cycles, fixed_cycles, ref_cycles / fixed_cycles, (long long)max_diff,
+             bad == 0 ? "" : "（超出容差）");
+
+    return bad;
+}
+
+//16位增益：同一块数据按16位样本处理，选中的内核与标量版本逐位比较
+static int bench_gain_limit_s16(void)
+{
+    int16_t *ref = (int16_t *)bench_ref;
+    int16_t *out = (int16_t *)bench_out;
+    size_t count = BENCH_SAMPLES * sizeof(int32_t) / sizeof(int16_t);
+    int mismatch = 0;
+
+    memcpy(bench_ref, bench_src, BENCH_SAMPLES * sizeof(int32_t));
+    memcpy(bench_out, bench_src, BENCH_SAMPLES * sizeof(int32_t));
+    audio_gain_limit_s16_scalar(ref, count, GAIN_TO_Q24(bench_gain));
+    audio_gain_limit_s16(out, count, GAIN_TO_Q24(bench_gain));
+    for (size_t i = 0; i < count; i++) {
+        if (out[i] != ref[i]) {
+            mismatch++;
+        }
+    }
+    return mismatch;
+}
+
+//增益加限幅：构建时选中的内核与标量版本逐位比较，并与原来的浮点循环比较吞吐
+static int bench_gain_limit(void)
+{
+    static const float gains[] = { 1.0f, 3.0f, 15.0f, 64.0f, 2.5f, 0.75f };
+    int bad = 0;
+
+    for (size_t g = 0; g < sizeof(gains) / sizeof(gains[0]); g++) {
+        bench_gain = gains[g];
+        bench_fill(bench_src, BENCH_SAMPLES, 0x9E3779B9u * (g + 1));
+
+        float loop_cycles = bench_cycles(kernel_amplify_loop, bench_out);
+        float scalar_cycles = bench_cycles(kernel_gain_limit_scalar, bench_ref);
+        float kernel_cycles = bench_cycles(kernel_gain_limit, bench_out);
+
+        int mismatch = 0;
+        for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+            if (bench_out[i] != bench_ref[i]) {
+                mismatch++;
+            }
+        }
+        int mismatch_s16 = bench_gain_limit_s16();
+        bad += mismatch + mismatch_s16;
+
+        ESP_LOGI(TAG, "gain %5.2f 原循环 %.2f, 标量 %.2f, 选中内核 %.2f cycles/sample, 加速 x%.2f, 不一致 %d，16位不一致 %d",
+                 bench_gain, loop_cycles, scalar_cycles, kernel_cycles, loop_cycles / kernel_cycles, mismatch,
+                 mismatch_s16);
+    }
+
+    return bad;
+}
+
+//WebSocket掩码：逐字节循环作为参考，数据起点和帧内偏移都不对齐时也要逐字节一致
+static void mask_bytewise(uint8_t *data, size_t len, const uint8_t mask[4], size_t offset)
+{
+    for (size_t i = 0; i < len; i++) {
+        data[i] ^= mask[(offset + i) & 3];
+    }
+}
+
+//跨核传递的一项，大小和一个音频帧描述差不多
+typedef struct {
+    uint32_t seq;
+    uint8_t data[60];
+} ring_item_t;
+
+static audio_ring_t ring_bench;
+static QueueHandle_t ring_queue = NULL;
+static SemaphoreHandle_t ring_done = NULL;
+static volatile int ring_errors = 0;
+
+static bool ring_item_ok(const ring_item_t *item, uint32_t seq)
+{
+    return item->seq == seq && item->data[0] == (uint8_t)seq && item->data[sizeof(item->data) - 1] == (uint8_t)~seq;
+}
+
+static void ring_item_fill(ring_item_t *item, uint32_t seq)
+{
+    item->seq = seq;
+    item->data[0] = (uint8_t)seq;
+    item->data[sizeof(item->data) - 1] = (uint8_t)~seq;
+}
+
+//消费者：在另一个核上按顺序取出并校验
+static void ring_consumer_task(void *param)
+{
+    for (uint32_t seq = 0; seq < RING_ITEMS; seq++) {
+        ring_item_t *item = audio_ring_peek_wait(&ring_bench, pdMS_TO_TICKS(1000));
+        if (item == NULL || !ring_item_ok(item, seq)) {
+            ring_errors++;
+            break;
+        }
+        audio_ring_release(&ring_bench);
+    }
+    xSemaphoreGive(ring_done);
+    vTaskDelete(NULL);
+}
+
+static void queue_consumer_task(void *param)
+{
+    ring_item_t item;
+    for (uint32_t seq = 0; seq < RING_ITEMS; seq++) {
+        if (xQueueReceive(ring_queue, &item, pdMS_TO_TICKS(1000)) != pdTRUE || !ring_item_ok(&item, seq)) {
+            ring_errors++;
+            break;
+        }
+    }
+    xSemaphoreGive(ring_done);
+    vTaskDelete(NULL);
+}
+
+//SPSC环形缓冲和FreeRTOS队列的跨核传递：生产者在当前任务，消费者在最后一个核上，同优先级
+//两边都会频繁阻塞，测到的是包括任务通知和切换在内的每项开销，同时校验顺序和内容
+static int bench_ring(void)
+{
+    ring_queue = xQueueCreate(RING_SLOTS, sizeof(ring_item_t));
+    ring_done = xSemaphoreCreateBinary();
+    if (ring_queue == NULL || ring_done == NULL ||
+        audio_ring_init(&ring_bench, sizeof(ring_item_t), RING_SLOTS, MALLOC_CAP_INTERNAL) != ESP_OK) {
+        ESP_LOGE(TAG, "环形缓冲测试分配失败");
+        return 1;
+    }
+    ring_errors = 0;
+
+    int64_t start = esp_timer_get_time();
+    xTaskCreatePinnedToCore(ring_consumer_task, "ring bench", 2048, NULL, uxTaskPriorityGet(NULL), NULL,
+                            portNUM_PROCESSORS - 1);
+    for (uint32_t seq = 0; seq < RING_ITEMS; seq++) {
+        ring_item_t *item = audio_ring_reserve_wait(&ring_bench, pdMS_TO_TICKS(1000));
+        if (item == NULL) {
+            ring_errors++;
+            break;
+        }
+        ring_item_fill(item, seq);
+        audio_ring_commit(&ring_bench);
+    }
+    xSemaphoreTake(ring_done, portMAX_DELAY);
+    float ring_us = (float)(esp_timer_get_time() - start) / RING_ITEMS;
+
+    start = esp_timer_get_time();
+    xTaskCreatePinnedToCore(queue_consumer_task, "queue bench", 2048, NULL, uxTaskPriorityGet(NULL), NULL,
+                            portNUM_PROCESSORS - 1);
+    for (uint32_t seq = 0; seq < RING_ITEMS; seq++) {
+        ring_item_t item;
+        ring_item_fill(&item, seq);
+        if (xQueueSend(ring_queue, &item, pdMS_TO_TICKS(1000)) != pdTRUE) {
+            ring_errors++;
+            break;
+        }
+    }
+    xSemaphoreTake(ring_done, portMAX_DELAY);
+    float queue_us = (float)(esp_timer_get_time() - start) / RING_ITEMS;
+
+    ESP_LOGI(TAG, "跨核传递%u字节：SPSC环 %.2f us/项，FreeRTOS队列 %.2f us/项，%s", (unsigned)sizeof(ring_item_t),
+             ring_us, queue_us, ring_errors == 0 ? "校验通过" : "校验失败");
+
+    audio_ring_deinit(&ring_bench);
+    vQueueDelete(ring_queue);
+    vSemaphoreDelete(ring_done);
+    return ring_errors == 0 ? 0 : 1;
+}
+
+static int bench_ws_mask(void)
+{
+    static const uint8_t mask[4] = { 0x3A, 0xC5, 0x17, 0xE9 };
+    uint8_t *ref = (uint8_t *)bench_ref;
+    uint8_t *out = (uint8_t *)bench_out;
+    size_t bytes = BENCH_SAMPLES * sizeof(int32_t) - 4;
+    int bad = 0;
+
+    for (size_t align = 0; align < 4; align++) {
+        uint32_t byte_cycles = 0;
+        uint32_t word_cycles = 0;
+
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            size_t offset = r * 7 + align;
+            memcpy(ref, bench_src, bytes + 4);
+            memcpy(out, bench_src, bytes + 4);
+
+            uint32_t start = esp_cpu_get_cycle_count();
+            mask_bytewise(ref + align, bytes, mask, offset);
+            byte_cycles += esp_cpu_get_cycle_count() - start;
+
+            start = esp_cpu_get_cycle_count();
+            esp_websocket_mask(out + align, bytes, mask, offset);
+            word_cycles += esp_cpu_get_cycle_count() - start;
+
+            if (memcmp(ref, out, bytes + 4) != 0) {
+                bad++;
+            }
+        }
+
+        ESP_LOGI(TAG, "ws mask 起点偏移%u 逐字节 %.2f, 按字 %.2f cycles/byte, 加速 x%.2f%s", (unsigned)align,
+                 (float)byte_cycles / (BENCH_ROUNDS * bytes), (float)word_cycles / (BENCH_ROUNDS * bytes),
+                 (float)byte_cycles / word_cycles, bad == 0 ? "" : "（结果不一致）");
+    }
+
+    return bad;
+}
+
+//重采样器验收门限：通带纹波与混叠抑制
+#define RESAMPLE_RIPPLE_DB    0.5f
+#define RESAMPLE_REJECTION_DB 60.0f
+#define RESAMPLE_BLOCK        256
+
+//输入一个正弦，返回稳态输出相对输入的功率（dB）
+static float bench_resample_tone(audio_resampler_t *rs, float freq, int16_t *in, int16_t *out)
+{
+    const float amplitude = 16000.0f;
+    float phase = 0.0f;
+    float step = 2.0f * (float)M_PI * freq / (float)rs->in_rate;
+    double energy = 0.0;
+    size_t count = 0;
+
+    audio_resampler_reset(rs);
+    for (int block = 0; block < 24; block++) {
+        for (int i = 0; i < RESAMPLE_BLOCK; i++) {
+            in[i] = (int16_t)(amplitude * sinf(phase));
+            phase = fmodf(phase + step, 2.0f * (float)M_PI);
+        }
+
+        size_t produced;
+        audio_resampler_process(rs, in, RESAMPLE_BLOCK, out, &produced);
+        //跳过前几块，等滤波器填满
+        if (block >= 4) {
+            for (size_t i = 0; i < produced; i++) {
+                energy += (double)out[i] * out[i];
+            }
+            count += produced;
+        }
+    }
+
+    double ref = (double)amplitude * amplitude / 2.0;
+    return 10.0f * log10f((float)(energy / count / ref) + 1e-12f);
+}
+
+//重采样器：吞吐、通带纹波、混叠抑制
+static int bench_resampler(uint32_t in_rate, uint32_t out_rate)
+{
+    audio_resampler_t rs;
+    if (audio_resampler_init(&rs, in_rate, out_rate, RESAMPLE_BLOCK) != ESP_OK) {
+        return 1;
+    }
+
+    int16_t *in = (int16_t *)bench_src;
+    int16_t *out = (int16_t *)bench_out;
+
+    //通带：100Hz到输出采样率的0.3倍
+    float ripple = 0.0f;
+    for (float f = 100.0f; f <= out_rate * 0.3f; f += out_rate * 0.025f) {
+        float db = bench_resample_tone(&rs, f, in, out);
+        ripple = fmaxf(ripple, fabsf(db));
+    }
+
+    //阻带：从输出采样率的0.625倍到输入奈奎斯特频率，这些频率会混叠进通带
+    float rejection = 200.0f;
+    for (float f = out_rate * 0.625f; f < in_rate * 0.5f; f += out_rate * 0.05f) {
+        float db = bench_resample_tone(&rs, f, in, out);
+        rejection = fminf(rejection, -db);
+    }
+
+    size_t produced;
+    uint32_t start = esp_cpu_get_cycle_count();
+    audio_resampler_process(&rs, in, RESAMPLE_BLOCK, out, &produced);
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+
+    audio_resampler_deinit(&rs);
+
+    bool ok = ripple <= RESAMPLE_RIPPLE_DB && rejection >= RESAMPLE_REJECTION_DB;
+    ESP_LOGI(TAG, "resample %lu->%lu 通带纹波 %.2f dB, 混叠抑制 %.1f dB, %.1f cycles/输出样本%s",
+             (unsigned long)in_rate, (unsigned long)out_rate, ripple, rejection,
+             (float)cycles / (produced ? produced : 1), ok ? "" : "（未达标）");
+
+    return ok ? 0 : 1;
+}
+
+//吞吐测试表的输出，和主机版host_bench的列一致
+static void bench_suite_report(const audio_bench_result_t *r)
+{
+    ESP_LOGI(TAG, "%-18s %5u gain %5.1f %9.3f ns/sample %11.0f samples/s 实时 x%.1f (44.1k) x%.1f (16k)",
+             r->name, (unsigned)r->samples, r->gain, r->ns_per_sample, r->samples_per_sec,
+             r->realtime_44k, r->realtime_16k);
+
+    //整张表要测两秒多，每项之间让出CPU，空闲任务喂狗
+    vTaskDelay(1);
+}
+
+static uint32_t bench_suite_clock(void)
+{
+    return esp_cpu_get_cycle_count();
+}
+
+//DSP内核基准测试，在目标板上用CPU周期计数
+esp_err_t audio_bench_run(void)
+{
+    //16字节对齐，和流水线中的帧缓冲一致
+    bench_src = heap_caps_aligned_alloc(16, BENCH_SAMPLES * sizeof(int32_t), MALLOC_CAP_INTERNAL);
+    bench_ref = heap_caps_aligned_alloc(16, BENCH_SAMPLES * sizeof(int32_t), MALLOC_CAP_INTERNAL);
+    bench_out = heap_caps_aligned_alloc(16, BENCH_SAMPLES * sizeof(int32_t), MALLOC_CAP_INTERNAL);
+    if (bench_src == NULL || bench_ref == NULL || bench_out == NULL) {
+        heap_caps_free(bench_src);
+        heap_caps_free(bench_ref);
+        heap_caps_free(bench_out);
+        return ESP_ERR_NO_MEM;
+    }
+
+    bench_fill(bench_src, BENCH_SAMPLES, 0x12345678);
+
+    int bad = 0;
+    bad += bench_pair("amplify", kernel_amplify_float, kernel_amplify_q31);
+    bad += bench_pair("compress", kernel_compress_float, kernel_compress_q31);
+    bad += bench_gain_limit();
+    bad += bench_ws_mask();
+    bad += bench_resampler(44100, 16000);
+    bad += bench_ring();
+
+    heap_caps_free(bench_src);
+    heap_caps_free(bench_ref);
+    heap_caps_free(bench_out);
+    bench_src = bench_ref = bench_out = NULL;
+
+    //与主机共用的吞吐测试表，CPU周期按默认主频换算成纳秒
+    if (audio_bench_suite_run(bench_suite_clock, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ / 1000.0, bench_suite_report) != ESP_OK) {
+        bad++;
+    }
+
+    return bad == 0 ? ESP_OK : ESP_FAIL;
+}
+
+//DMA档位基准测试，需要在流水线运行中调用，测完切回原来的档位
+//延迟按缓冲计算：采集要等满一个RX DMA缓冲，播放前要经过整个TX DMA队列，再加上实测的处理时间
+//CPU占用是采集、播放任务处理帧的周期数占一个核的比例，不含等待DMA和写TX的阻塞
+esp_err_t audio_bench_profiles(void)
+{
+    const audio_dma_profile_t *orig = audio_pipeline_get_profile();
+    int orig_id = audio_pipeline_find_profile(orig->name, strlen(orig->name));
+    const double cycles_per_us = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+
+    ESP_LOGI(TAG, "DMA档位测试，每档%d ms", PROFILE_RUN_MS);
+    for (int id = 0; id < AUDIO_DMA_PROFILE_NUM; id++) {
+        esp_err_t ret = audio_pipeline_set_profile((audio_dma_profile_id_t)id);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        vTaskDelay(pdMS_TO_TICKS(PROFILE_SETTLE_MS));
+
+        audio_pipeline_stats_t before, after;
+        audio_pipeline_get_stats(&before);
+        int64_t start_us = esp_timer_get_time();
+        vTaskDelay(pdMS_TO_TICKS(PROFILE_RUN_MS));
+        audio_pipeline_get_stats(&after);
+        double elapsed_us = (double)(esp_timer_get_time() - start_us);
+
+        const audio_dma_profile_t *p = audio_pipeline_get_profile();
+        uint32_t frames = after.captured - before.captured;
+        double capture_cycles = (double)(after.capture_cycles - before.capture_cycles);
+        double playback_cycles = (double)(after.playback_cycles - before.playback_cycles);
+        double rx_ms = p->frame_num * 1000.0 / MIC_SAMPLE_RATE;
+        double tx_ms = (double)p->frame_num * p->desc_num * 1000.0 / STREAM_SAMPLE_RATE;
+        double work_ms = frames > 0 ? capture_cycles / frames / cycles_per_us / 1000.0 : 0.0;
+
+        ESP_LOGI(TAG, "%-11s %4lu帧x%lu  %6.1f帧/s  延迟%6.1f ms（RX %.1f + 处理 %.2f + TX %.1f）"
+                 "  CPU 采集%5.2f%% 播放%5.2f%%  溢出%lu 播空%lu",
+                 p->name, (unsigned long)p->frame_num, (unsigned long)p->desc_num,
+                 frames * 1e6 / elapsed_us, rx_ms + work_ms + tx_ms, rx_ms, work_ms, tx_ms,
+                 capture_cycles / (elapsed_us * cycles_per_us) * 100.0,
+                 playback_cycles / (elapsed_us * cycles_per_us) * 100.0,
+                 (unsigned long)(after.rx.overflow - before.rx.overflow),
+                 (unsigned long)(after.tx.underflow - before.tx.underflow));
+    }
+
+    return audio_pipeline_set_profile((audio_dma_profile_id_t)orig_id);
+}
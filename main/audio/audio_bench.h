@@ -0,0 +1,13 @@
+#ifndef __AUDIO_BENCH_H_
+#define __AUDIO_BENCH_H_
+
+#include "esp_err.h"
+
+//定点内核与浮点参考之间允许的误差：相对误差2^-21再加1个LSB。
+//浮点内核只有24位尾数，压缩内核又经过减、除、加三次舍入，误差在几个ulp以内
+#define AUDIO_BENCH_REL_TOLERANCE (1.0f / 2097152.0f)
+
+esp_err_t audio_bench_run(void);
+esp_err_t audio_bench_profiles(void);
+
+#endif
@@ -0,0 +1,263 @@
+#include "audio_bench_suite.h"
+#include "audio_process.h"
+#include "audio_simd.h"
+#include "audio_agc.h"
+#include "audio_biquad.h"
+#include "audio_resampler.h"
+#include "audio_ns.h"
+#include "audio_codec.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+#include <stdbool.h>
+
+#define SUITE_MAX_SAMPLES 2048
+#define SUITE_MIN_ROUNDS  8
+
+//缓冲长度：小块、半个DMA缓冲、balanced档位的一个DMA缓冲、流水线帧缓冲能放下的16位样本数
+static const size_t suite_sizes[] = { 64, 256, 511, 2048 };
+//增益：单位增益、Mic_driver的默认固定增益、AGC的上限附近
+static const float suite_gains[] = { 1.0f, 15.0f, 64.0f };
+
+typedef void (*suite_kernel_t)(void *samples, size_t count);
+
+typedef struct {
+    const char *name;
+    suite_kernel_t run;
+    bool s16;       //输入为16位样本，否则为32位
+    bool uses_gain; //按suite_gains逐个测
+} suite_case_t;
+
+static void *suite_src = NULL;  //测试数据，每轮拷进suite_buf
+static void *suite_buf = NULL;
+static uint8_t *suite_aux = NULL; //重采样、编码的输出
+static float suite_gain = 1.0f;
+static audio_processor_t suite_proc;
+static audio_biquad_t suite_biquad;
+static audio_ns_t suite_ns;
+static audio_resampler_t suite_resampler;
+static audio_adpcm_state_t suite_adpcm;
+
+//固定种子的伪随机数，保证每次测试数据一致
+static uint32_t suite_rand(uint32_t *seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed;
+}
+
+static void kernel_amplify_float(void *samples, size_t count)
+{
+    amplify_audio_buffer(samples, count * sizeof(int32_t), suite_gain);
+}
+
+static void kernel_amplify_q31(void *samples, size_t count)
+{
+    amplify_audio_buffer_q31(samples, count * sizeof(int32_t), GAIN_TO_Q24(suite_gain));
+}
+
+static void kernel_gain_limit_scalar(void *samples, size_t count)
+{
+    audio_gain_limit_scalar(samples, count, GAIN_TO_Q24(suite_gain), INT32_MAX);
+}
+
+static void kernel_gain_limit(void *samples, size_t count)
+{
+    audio_gain_limit(samples, count, GAIN_TO_Q24(suite_gain), INT32_MAX);
+}
+
+static void kernel_gain_limit_s16(void *samples, size_t count)
+{
+    audio_gain_limit_s16(samples, count, GAIN_TO_Q24(suite_gain));
+}
+
+//固定增益路径，AGC关闭，增益的预计算在每一行测量之前做完
+static void kernel_process_fixed(void *samples, size_t count)
+{
+    suite_proc.enable_agc = false;
+    process_audio_buffer(samples, count * sizeof(int32_t), &suite_proc);
+}
+
+static void kernel_compress_float(void *samples, size_t count)
+{
+    compress_audio_buffer(samples, count * sizeof(int32_t), 1 << 28, 4.0f);
+}
+
+static void kernel_compress_q31(void *samples, size_t count)
+{
+    compress_audio_buffer_q31(samples, count * sizeof(int32_t), 1 << 28, INV_RATIO_TO_Q31(4.0f));
+}
+
+static void kernel_process_agc(void *samples, size_t count)
+{
+    suite_proc.enable_agc = true;
+    process_audio_buffer(samples, count * sizeof(int32_t), &suite_proc);
+}
+
+static void kernel_process_agc_s16(void *samples, size_t count)
+{
+    suite_proc.enable_agc = true;
+    process_audio_buffer_s16(samples, count, &suite_proc);
+}
+
+static void kernel_biquad_s16(void *samples, size_t count)
+{
+    audio_biquad_process_s16(&suite_biquad, samples, count);
+}
+
+static void kernel_biquad_s32(void *samples, size_t count)
+{
+    audio_biquad_process_s32(&suite_biquad, samples, count);
+}
+
+static void kernel_ns(void *samples, size_t count)
+{
+    audio_ns_process(&suite_ns, samples, count);
+}
+
+static void kernel_resample(void *samples, size_t count)
+{
+    size_t produced;
+    audio_resampler_process(&suite_resampler, samples, count, (int16_t *)suite_aux, &produced);
+}
+
+static void kernel_adpcm_encode(void *samples, size_t count)
+{
+    audio_adpcm_encode(&suite_adpcm, samples, count, suite_aux);
+}
+
+static const suite_case_t suite_cases[] = {
+    { "amplify float",    kernel_amplify_float,     false, true  },
+    { "amplify q31",      kernel_amplify_q31,       false, true  },
+    { "gain_limit scalar", kernel_gain_limit_scalar, false, true  },
+    { "gain_limit",       kernel_gain_limit,        false, true  },
+    { "gain_limit s16",   kernel_gain_limit_s16,    true,  true  },
+    { "process fixed",    kernel_process_fixed,     false, true  },
+    { "compress float",   kernel_compress_float,    false, false },
+    { "compress q31",     kernel_compress_q31,      false, false },
+    { "process agc",      kernel_process_agc,       false, false },
+    { "process agc s16",  kernel_process_agc_s16,   true,  false },
+    { "biquad x3 s16",    kernel_biquad_s16,        true,  false },
+    { "biquad x3 s32",    kernel_biquad_s32,        false, false },
+    { "ns",               kernel_ns,                true,  false },
+    { "resample 44k->16k", kernel_resample,         true,  false },
+    { "adpcm encode",     kernel_adpcm_encode,      true,  false },
+};
+
+//测试数据：INMP441量级的32位样本（24位有效位在高位）和语音量级的16位样本
+static void suite_fill(uint32_t seed)
+{
+    int32_t *s32 = suite_src;
+    for (size_t i = 0; i < SUITE_MAX_SAMPLES; i++) {
+        s32[i] = ((int32_t)suite_rand(&seed) >> 8) << 4;
+    }
+}
+
+static void suite_fill_s16(uint32_t seed)
+{
+    int16_t *s16 = suite_src;
+    for (size_t i = 0; i < SUITE_MAX_SAMPLES; i++) {
+        s16[i] = (int16_t)((int32_t)suite_rand(&seed) >> 20);
+    }
+}
+
+//有状态的内核在这里一次性初始化，测量过程中不分配内存
+static esp_err_t suite_setup(void)
+{
+    audio_agc_config_t agc = AUDIO_AGC_DEFAULT_CONFIG();
+    memset(&suite_proc, 0, sizeof(suite_proc));
+    suite_proc.compression_threshold = 10000000.0f;
+    suite_proc.compression_ratio = 1.0f;
+    suite_proc.use_fixed_point = true;
+    suite_proc.limit = INT32_MAX;
+    audio_agc_init(&suite_proc.agc, &agc, 16000, 1);
+
+    audio_biquad_init(&suite_biquad, 1);
+    audio_biquad_coeffs_t dc = audio_biquad_dc_blocker(16000, 5.0f);
+    audio_biquad_coeffs_t hp = audio_biquad_highpass(16000, 80.0f, 0.7071f);
+    audio_biquad_coeffs_t eq = audio_biquad_peaking(16000, 3000.0f, 1.0f, 3.0f);
+    audio_biquad_add(&suite_biquad, &dc);
+    audio_biquad_add(&suite_biquad, &hp);
+    audio_biquad_add(&suite_biquad, &eq);
+
+    audio_adpcm_reset(&suite_adpcm);
+
+    esp_err_t ret = audio_ns_init(&suite_ns, 16000, 12, SUITE_MAX_SAMPLES);
+    if (ret == ESP_OK) {
+        ret = audio_resampler_init(&suite_resampler, 44100, 16000, SUITE_MAX_SAMPLES);
+    }
+    return ret;
+}
+
+//测一项：每轮先拷入同样的数据，只计内核本身的时间，累计到AUDIO_BENCH_MIN_NS以上
+static void suite_measure(const suite_case_t *c, size_t samples, audio_bench_clock_t now, double ticks_per_ns,
+                          audio_bench_report_t report)
+{
+    size_t bytes = samples * (c->s16 ? sizeof(int16_t) : sizeof(int32_t));
+    double min_ticks = AUDIO_BENCH_MIN_NS * ticks_per_ns;
+    double ticks = 0.0;
+    uint32_t rounds = 0;
+
+    //预热一次，让指令和数据进缓存
+    memcpy(suite_buf, suite_src, bytes);
+    c->run(suite_buf, samples);
+
+    while (rounds < SUITE_MIN_ROUNDS || ticks < min_ticks) {
+        memcpy(suite_buf, suite_src, bytes);
+        uint32_t start = now();
+        c->run(suite_buf, samples);
+        ticks += (uint32_t)(now() - start);
+        rounds++;
+    }
+
+    double ns = ticks / ticks_per_ns / ((double)rounds * samples);
+    audio_bench_result_t result = {
+        .name = c->name,
+        .samples = samples,
+        .gain = c->uses_gain ? suite_gain : 0.0f,
+        .ns_per_sample = ns,
+        .samples_per_sec = 1e9 / ns,
+        .realtime_44k = 1e9 / ns / 44100.0,
+        .realtime_16k = 1e9 / ns / 16000.0,
+    };
+    report(&result);
+}
+
+//依次测量所有内核、缓冲长度和增益
+esp_err_t audio_bench_suite_run(audio_bench_clock_t now, double ticks_per_ns, audio_bench_report_t report)
+{
+    suite_src = heap_caps_aligned_alloc(16, SUITE_MAX_SAMPLES * sizeof(int32_t), MALLOC_CAP_INTERNAL);
+    suite_buf = heap_caps_aligned_alloc(16, SUITE_MAX_SAMPLES * sizeof(int32_t), MALLOC_CAP_INTERNAL);
+    suite_aux = heap_caps_aligned_alloc(16, SUITE_MAX_SAMPLES * sizeof(int32_t), MALLOC_CAP_INTERNAL);
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    if (suite_src != NULL && suite_buf != NULL && suite_aux != NULL) {
+        ret = suite_setup();
+    }
+
+    for (size_t i = 0; ret == ESP_OK && i < sizeof(suite_cases) / sizeof(suite_cases[0]); i++) {
+        const suite_case_t *c = &suite_cases[i];
+        if (c->s16) {
+            suite_fill_s16(0x12345678);
+        } else {
+            suite_fill(0x12345678);
+        }
+
+        for (size_t s = 0; s < sizeof(suite_sizes) / sizeof(suite_sizes[0]); s++) {
+            size_t ngains = c->uses_gain ? sizeof(suite_gains) / sizeof(suite_gains[0]) : 1;
+            for (size_t g = 0; g < ngains; g++) {
+                suite_gain = suite_gains[g];
+                //audio_processor_update不计入测量，和固定增益路径的运行时一样只在改参数时调用
+                suite_proc.gain = suite_gain;
+                audio_processor_update(&suite_proc);
+                suite_measure(c, suite_sizes[s], now, ticks_per_ns, report);
+            }
+        }
+    }
+
+    audio_resampler_deinit(&suite_resampler);
+    audio_ns_deinit(&suite_ns);
+    heap_caps_free(suite_src);
+    heap_caps_free(suite_buf);
+    heap_caps_free(suite_aux);
+    suite_src = suite_buf = suite_aux = NULL;
+
+    return ret;
+}
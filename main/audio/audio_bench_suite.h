@@ -0,0 +1,32 @@
+#ifndef __AUDIO_BENCH_SUITE_H_
+#define __AUDIO_BENCH_SUITE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+//计时源：返回一个递增的计数，允许32位回绕，单次调用的耗时远小于回绕周期
+//目标板上是CPU周期计数，主机上是单调时钟的纳秒数
+typedef uint32_t (*audio_bench_clock_t)(void);
+
+//一项测量结果
+typedef struct {
+    const char *name;       //内核名
+    size_t samples;         //每次调用处理的样本数
+    float gain;             //增益，与增益无关的内核为0
+    double ns_per_sample;   //每个样本的耗时
+    double samples_per_sec; //吞吐
+    double realtime_44k;    //相对44.1kHz单声道实时的倍数，小于1就跟不上采集
+    double realtime_16k;    //相对16kHz单声道实时的倍数
+} audio_bench_result_t;
+
+typedef void (*audio_bench_report_t)(const audio_bench_result_t *result);
+
+//每项至少测这么久，再取平均
+#define AUDIO_BENCH_MIN_NS 20000000.0
+
+//DSP内核在不同缓冲长度、不同增益下的吞吐，目标板和主机共用同一份测试表
+//ticks_per_ns为计时源每纳秒的计数，每测完一项调用一次report
+esp_err_t audio_bench_suite_run(audio_bench_clock_t now, double ticks_per_ns, audio_bench_report_t report);
+
+#endif
@@ -0,0 +1,245 @@
+#include "audio_biquad.h"
+#include <math.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define BIQUAD_ONE ((float)(1 << BIQUAD_Q_FRAC_BITS))
+
+//32位样本先右移到24位再滤波，五个乘积相加不会溢出int64
+#define S32_SHIFT 8
+#define S24_MAX   ((1 << 23) - 1)
+#define S24_MIN   (-(1 << 23))
+
+//一阶隔直：H(z) = (1 - z^-1) / (1 - r*z^-1)，fc为-3dB频率
+audio_biquad_coeffs_t audio_biquad_dc_blocker(uint32_t sample_rate, float fc)
+{
+    float r = expf(-2.0f * (float)M_PI * fc / sample_rate);
+    audio_biquad_coeffs_t c = {
+        .b0 = 1.0f, .b1 = -1.0f, .b2 = 0.0f,
+        .a1 = -r, .a2 = 0.0f,
+    };
+    return c;
+}
+
+//以下按RBJ Audio EQ Cookbook的公式，a0归一化为1
+audio_biquad_coeffs_t audio_biquad_highpass(uint32_t sample_rate, float fc, float q)
+{
+    float w = 2.0f * (float)M_PI * fc / sample_rate;
+    float cw = cosf(w);
+    float alpha = sinf(w) / (2.0f * q);
+    float a0 = 1.0f + alpha;
+    audio_biquad_coeffs_t c = {
+        .b0 = (1.0f + cw) / 2.0f / a0,
+        .b1 = -(1.0f + cw) / a0,
+        .b2 = (1.0f + cw) / 2.0f / a0,
+        .a1 = -2.0f * cw / a0,
+        .a2 = (1.0f - alpha) / a0,
+    };
+    return c;
+}
+
+audio_biquad_coeffs_t audio_biquad_lowpass(uint32_t sample_rate, float fc, float q)
+{
+    float w = 2.0f * (float)M_PI * fc / sample_rate;
+    float cw = cosf(w);
+    float alpha = sinf(w) / (2.0f * q);
+    float a0 = 1.0f + alpha;
+    audio_biquad_coeffs_t c = {
+        .b0 = (1.0f - cw) / 2.0f / a0,
+        .b1 = (1.0f - cw) / a0,
+        .b2 = (1.0f - cw) / 2.0f / a0,
+        .a1 = -2.0f * cw / a0,
+        .a2 = (1.0f - alpha) / a0,
+    };
+    return c;
+}
+
+audio_biquad_coeffs_t audio_biquad_peaking(uint32_t sample_rate, float fc, float q, float gain_db)
+{
+    float a = powf(10.0f, gain_db / 40.0f);
+    float w = 2.0f * (float)M_PI * fc / sample_rate;
+    float cw = cosf(w);
+    float alpha = sinf(w) / (2.0f * q);
+    float a0 = 1.0f + alpha / a;
+    audio_biquad_coeffs_t c = {
+        .b0 = (1.0f + alpha * a) / a0,
+        .b1 = -2.0f * cw / a0,
+        .b2 = (1.0f - alpha * a) / a0,
+        .a1 = -2.0f * cw / a0,
+        .a2 = (1.0f - alpha / a) / a0,
+    };
+    return c;
+}
+
+//搁架斜率S取1
+audio_biquad_coeffs_t audio_biquad_highshelf(uint32_t sample_rate, float fc, float gain_db)
+{
+    float a = powf(10.0f, gain_db / 40.0f);
+    float w = 2.0f * (float)M_PI * fc / sample_rate;
+    float cw = cosf(w);
+    float alpha = sinf(w) / 2.0f * sqrtf(2.0f);
+    float sa = 2.0f * sqrtf(a) * alpha;
+    float a0 = (a + 1.0f) - (a - 1.0f) * cw + sa;
+    audio_biquad_coeffs_t c = {
+        .b0 = a * ((a + 1.0f) + (a - 1.0f) * cw + sa) / a0,
+        .b1 = -2.0f * a * ((a - 1.0f) + (a + 1.0f) * cw) / a0,
+        .b2 = a * ((a + 1.0f) + (a - 1.0f) * cw - sa) / a0,
+        .a1 = 2.0f * ((a - 1.0f) - (a + 1.0f) * cw) / a0,
+        .a2 = ((a + 1.0f) - (a - 1.0f) * cw - sa) / a0,
+    };
+    return c;
+}
+
+//初始化为空的级联，不含任何节时处理函数直接返回
+void audio_biquad_init(audio_biquad_t *bq, int channels)
+{
+    memset(bq, 0, sizeof(*bq));
+    bq->channels = channels < 1 ? 1 : (channels > AUDIO_BIQUAD_MAX_CHANNELS ? AUDIO_BIQUAD_MAX_CHANNELS : channels);
+}
+
+static bool coeff_to_q30(float c, int32_t *out)
+{
+    if (!(c >= -2.0f && c < 2.0f)) {
+        return false;
+    }
+    *out = (int32_t)lrintf(c * BIQUAD_ONE);
+    return true;
+}
+
+//追加一节，系数超出Q2.30范围时返回ESP_ERR_INVALID_ARG
+esp_err_t audio_biquad_add(audio_biquad_t *bq, const audio_biquad_coeffs_t *coeffs)
+{
+    if (bq->stages >= AUDIO_BIQUAD_MAX_STAGES) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int s = bq->stages;
+    if (!coeff_to_q30(coeffs->b0, &bq->b0[s]) || !coeff_to_q30(coeffs->b1, &bq->b1[s]) ||
+        !coeff_to_q30(coeffs->b2, &bq->b2[s]) || !coeff_to_q30(coeffs->a1, &bq->a1[s]) ||
+        !coeff_to_q30(coeffs->a2, &bq->a2[s])) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    bq->coeffs[s] = *coeffs;
+    bq->stages++;
+    return ESP_OK;
+}
+
+//清除滤波器状态，系数不变
+void audio_biquad_reset(audio_biquad_t *bq)
+{
+    memset(bq->x1, 0, sizeof(bq->x1));
+    memset(bq->x2, 0, sizeof(bq->x2));
+    memset(bq->y1, 0, sizeof(bq->y1));
+    memset(bq->y2, 0, sizeof(bq->y2));
+    memset(bq->err, 0, sizeof(bq->err));
+}
+
+//整个级联在freq处的幅度响应（dB），按浮点系数计算
+float audio_biquad_response_db(const audio_biquad_t *bq, uint32_t sample_rate, float freq)
+{
+    float w = 2.0f * (float)M_PI * freq / sample_rate;
+    float c1 = cosf(w), s1 = -sinf(w);
+    float c2 = cosf(2.0f * w), s2 = -sinf(2.0f * w);
+    float db = 0.0f;
+
+    for (int s = 0; s < bq->stages; s++) {
+        const audio_biquad_coeffs_t *c = &bq->coeffs[s];
+        float nr = c->b0 + c->b1 * c1 + c->b2 * c2;
+        float ni = c->b1 * s1 + c->b2 * s2;
+        float dr = 1.0f + c->a1 * c1 + c->a2 * c2;
+        float di = c->a1 * s1 + c->a2 * s2;
+        db += 10.0f * log10f((nr * nr + ni * ni) / (dr * dr + di * di) + 1e-30f);
+    }
+    return db;
+}
+
+//一节一个声道的整块滤波，交织的样本按声道数跳着取，输出饱和到16位
+//y = (b0*x + b1*x1 + b2*x2 - a1*y1 - a2*y2 + err) >> 30，err为上一个样本被截掉的小数部分
+static void biquad_stage_s16(audio_biquad_t *bq, int s, int ch, int16_t *samples, size_t count)
+{
+    const int64_t b0 = bq->b0[s], b1 = bq->b1[s], b2 = bq->b2[s];
+    const int64_t a1 = bq->a1[s], a2 = bq->a2[s];
+    int32_t x1 = bq->x1[ch][s], x2 = bq->x2[ch][s];
+    int32_t y1 = bq->y1[ch][s], y2 = bq->y2[ch][s];
+    int64_t err = bq->err[ch][s];
+    const int stride = bq->channels;
+
+    for (size_t i = ch; i < count; i += stride) {
+        int32_t x = samples[i];
+        int64_t acc = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2 + err;
+        int32_t y = (int32_t)(acc >> BIQUAD_Q_FRAC_BITS);
+        err = acc - ((int64_t)y << BIQUAD_Q_FRAC_BITS);
+        y = y > INT16_MAX ? INT16_MAX : (y < INT16_MIN ? INT16_MIN : y);
+        samples[i] = (int16_t)y;
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+    }
+
+    bq->x1[ch][s] = x1;
+    bq->x2[ch][s] = x2;
+    bq->y1[ch][s] = y1;
+    bq->y2[ch][s] = y2;
+    bq->err[ch][s] = (int32_t)err;
+}
+
+//同上，样本为右移后的24位，输出饱和到24位
+static void biquad_stage_s24(audio_biquad_t *bq, int s, int ch, int32_t *samples, size_t count)
+{
+    const int64_t b0 = bq->b0[s], b1 = bq->b1[s], b2 = bq->b2[s];
+    const int64_t a1 = bq->a1[s], a2 = bq->a2[s];
+    int32_t x1 = bq->x1[ch][s], x2 = bq->x2[ch][s];
+    int32_t y1 = bq->y1[ch][s], y2 = bq->y2[ch][s];
+    int64_t err = bq->err[ch][s];
+    const int stride = bq->channels;
+
+    for (size_t i = ch; i < count; i += stride) {
+        int32_t x = samples[i];
+        int64_t acc = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2 + err;
+        int32_t y = (int32_t)(acc >> BIQUAD_Q_FRAC_BITS);
+        err = acc - ((int64_t)y << BIQUAD_Q_FRAC_BITS);
+        y = y > S24_MAX ? S24_MAX : (y < S24_MIN ? S24_MIN : y);
+        samples[i] = y;
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+    }
+
+    bq->x1[ch][s] = x1;
+    bq->x2[ch][s] = x2;
+    bq->y1[ch][s] = y1;
+    bq->y2[ch][s] = y2;
+    bq->err[ch][s] = (int32_t)err;
+}
+
+//逐节、逐声道处理整块，系数和状态在一节内都放在寄存器里
+void audio_biquad_process_s16(audio_biquad_t *bq, int16_t *samples, size_t count)
+{
+    for (int ch = 0; ch < bq->channels; ch++) {
+        for (int s = 0; s < bq->stages; s++) {
+            biquad_stage_s16(bq, s, ch, samples, count);
+        }
+    }
+}
+
+void audio_biquad_process_s32(audio_biquad_t *bq, int32_t *samples, size_t count)
+{
+    if (bq->stages == 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        samples[i] >>= S32_SHIFT;
+    }
+    for (int ch = 0; ch < bq->channels; ch++) {
+        for (int s = 0; s < bq->stages; s++) {
+            biquad_stage_s24(bq, s, ch, samples, count);
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = (int32_t)((uint32_t)samples[i] << S32_SHIFT);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef __AUDIO_BIQUAD_H_
+#define __AUDIO_BIQUAD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+//级联的最大节数和最大声道数
+#define AUDIO_BIQUAD_MAX_STAGES   6
+#define AUDIO_BIQUAD_MAX_CHANNELS 2
+
+//定点系数的小数位数，Q2.30可以表示[-2, 2)，二阶节的a1最接近-2
+#define BIQUAD_Q_FRAC_BITS 30
+
+//一节二阶滤波器的系数，已按a0归一化：
+//H(z) = (b0 + b1*z^-1 + b2*z^-2) / (1 + a1*z^-1 + a2*z^-2)
+typedef struct {
+    float b0, b1, b2;
+    float a1, a2;
+} audio_biquad_coeffs_t;
+
+//级联二阶滤波器，直接I型，定点系数按struct-of-arrays存放，一节处理完整块后再处理下一节
+//每个声道每节有自己的状态，截断误差反馈到下一个样本，低频极点靠近单位圆时也不会积累偏差
+typedef struct {
+    int stages;
+    int channels;
+    audio_biquad_coeffs_t coeffs[AUDIO_BIQUAD_MAX_STAGES]; //浮点系数，用于计算频响
+    int32_t b0[AUDIO_BIQUAD_MAX_STAGES];
+    int32_t b1[AUDIO_BIQUAD_MAX_STAGES];
+    int32_t b2[AUDIO_BIQUAD_MAX_STAGES];
+    int32_t a1[AUDIO_BIQUAD_MAX_STAGES];
+    int32_t a2[AUDIO_BIQUAD_MAX_STAGES];
+    int32_t x1[AUDIO_BIQUAD_MAX_CHANNELS][AUDIO_BIQUAD_MAX_STAGES];
+    int32_t x2[AUDIO_BIQUAD_MAX_CHANNELS][AUDIO_BIQUAD_MAX_STAGES];
+    int32_t y1[AUDIO_BIQUAD_MAX_CHANNELS][AUDIO_BIQUAD_MAX_STAGES];
+    int32_t y2[AUDIO_BIQUAD_MAX_CHANNELS][AUDIO_BIQUAD_MAX_STAGES];
+    int32_t err[AUDIO_BIQUAD_MAX_CHANNELS][AUDIO_BIQUAD_MAX_STAGES];
+} audio_biquad_t;
+
+//系数设计，f为截止或中心频率（Hz），q为品质因数，gain_db为峰值/搁架的增益
+audio_biquad_coeffs_t audio_biquad_dc_blocker(uint32_t sample_rate, float fc);
+audio_biquad_coeffs_t audio_biquad_highpass(uint32_t sample_rate, float fc, float q);
+audio_biquad_coeffs_t audio_biquad_lowpass(uint32_t sample_rate, float fc, float q);
+audio_biquad_coeffs_t audio_biquad_peaking(uint32_t sample_rate, float fc, float q, float gain_db);
+audio_biquad_coeffs_t audio_biquad_highshelf(uint32_t sample_rate, float fc, float gain_db);
+
+void audio_biquad_init(audio_biquad_t *bq, int channels);
+esp_err_t audio_biquad_add(audio_biquad_t *bq, const audio_biquad_coeffs_t *coeffs);
+void audio_biquad_reset(audio_biquad_t *bq);
+float audio_biquad_response_db(const audio_biquad_t *bq, uint32_t sample_rate, float freq);
+
+//原地滤波，count为样本总数，多声道时交织存放
+void audio_biquad_process_s16(audio_biquad_t *bq, int16_t *samples, size_t count);
+//32位样本按INMP441的24位有效数据处理，低8位丢弃
+void audio_biquad_process_s32(audio_biquad_t *bq, int32_t *samples, size_t count);
+
+#endif
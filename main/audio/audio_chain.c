@@ -0,0 +1,158 @@
+#include "audio_chain.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <stdio.h>
+
+#define TAG "CHAIN"
+
+typedef struct {
+    audio_stage_t stage;
+    audio_stage_stats_t stats;
+    int64_t since_us;   //注册时刻，按这之后的时间算CPU占用
+} chain_slot_t;
+
+static chain_slot_t slots[AUDIO_CHAIN_MAX_STAGES];
+static int stage_count = 0;
+static SemaphoreHandle_t chain_lock = NULL;
+static StaticSemaphore_t chain_lock_buf;
+
+//初始化处理链
+esp_err_t audio_chain_init(void)
+{
+    if (chain_lock == NULL) {
+        chain_lock = xSemaphoreCreateMutexStatic(&chain_lock_buf);
+    }
+    stage_count = 0;
+
+    return ESP_OK;
+}
+
+//注册处理级，position为插入位置，小于0或超出范围时追加到末尾。
+//采集任务不需要停下来，最多等当前这一帧处理完
+esp_err_t audio_chain_register(const audio_stage_t *stage, int position)
+{
+    if (stage == NULL || stage->name == NULL || stage->process == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(chain_lock, portMAX_DELAY);
+
+    if (stage_count >= AUDIO_CHAIN_MAX_STAGES) {
+        xSemaphoreGive(chain_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    if (position < 0 || position > stage_count) {
+        position = stage_count;
+    }
+
+    memmove(&slots[position + 1], &slots[position], (stage_count - position) * sizeof(chain_slot_t));
+    memset(&slots[position], 0, sizeof(chain_slot_t));
+    slots[position].stage = *stage;
+    slots[position].stats.name = stage->name;
+    slots[position].since_us = esp_timer_get_time();
+    stage_count++;
+
+    xSemaphoreGive(chain_lock);
+
+    ESP_LOGI(TAG, "注册处理级 %s，位置 %d", stage->name, position);
+    return ESP_OK;
+}
+
+//注销处理级，返回后该处理级不会再被调用，它的ctx可以释放
+esp_err_t audio_chain_unregister(const char *name)
+{
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    xSemaphoreTake(chain_lock, portMAX_DELAY);
+
+    for (int i = 0; i < stage_count; i++) {
+        if (strcmp(slots[i].stage.name, name) == 0) {
+            memmove(&slots[i], &slots[i + 1], (stage_count - i - 1) * sizeof(chain_slot_t));
+            stage_count--;
+            ret = ESP_OK;
+            break;
+        }
+    }
+
+    xSemaphoreGive(chain_lock);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "注销处理级 %s", name);
+    }
+    return ret;
+}
+
+//按顺序执行各处理级并统计CPU周期，某一级出错时跳过后面的处理级
+esp_err_t audio_chain_process(audio_frame_t *frame)
+{
+    esp_err_t ret = ESP_OK;
+
+    xSemaphoreTake(chain_lock, portMAX_DELAY);
+
+    for (int i = 0; i < stage_count; i++) {
+        chain_slot_t *slot = &slots[i];
+
+        uint32_t start = esp_cpu_get_cycle_count();
+        ret = slot->stage.process(slot->stage.ctx, frame);
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+
+        slot->stats.calls++;
+        slot->stats.cycles += cycles;
+        slot->stats.last_cycles = cycles;
+        if (cycles > slot->stats.max_cycles) {
+            slot->stats.max_cycles = cycles;
+        }
+
+        if (ret != ESP_OK) {
+            ESP_LOGD(TAG, "处理级 %s 出错：%s", slot->stage.name, esp_err_to_name(ret));
+            break;
+        }
+    }
+
+    xSemaphoreGive(chain_lock);
+
+    return ret;
+}
+
+//获取各处理级的统计，返回处理级个数
+int audio_chain_get_stats(audio_stage_stats_t *stats, int max)
+{
+    xSemaphoreTake(chain_lock, portMAX_DELAY);
+
+    int count = stage_count < max ? stage_count : max;
+    for (int i = 0; i < count; i++) {
+        stats[i] = slots[i].stats;
+    }
+
+    xSemaphoreGive(chain_lock);
+
+    return count;
+}
+
+//各处理级的统计格式化成一行JSON，返回写入的长度（不含结尾的0），空间不够时截断
+//pct是注册以来占一个核的百分比，按CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ换算
+int audio_chain_format_stats(char *buf, size_t size)
+{
+    int64_t now = esp_timer_get_time();
+    size_t len = 0;
+
+    len += snprintf(buf + len, size > len ? size - len : 0, "{\"type\":\"chain\",\"stages\":[");
+
+    xSemaphoreTake(chain_lock, portMAX_DELAY);
+    for (int i = 0; i < stage_count; i++) {
+        const audio_stage_stats_t *s = &slots[i].stats;
+        double budget = (double)(now - slots[i].since_us) * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+        len += snprintf(buf + len, size > len ? size - len : 0,
+                        "%s{\"name\":\"%s\",\"calls\":%lu,\"avg_cycles\":%lu,\"last_cycles\":%lu,\"max_cycles\":%lu,"
+                        "\"pct\":%.2f}",
+                        i == 0 ? "" : ",", s->name, (unsigned long)s->calls,
+                        (unsigned long)(s->calls > 0 ? s->cycles / s->calls : 0), (unsigned long)s->last_cycles,
+                        (unsigned long)s->max_cycles, budget > 0 ? s->cycles * 100.0 / budget : 0.0);
+    }
+    xSemaphoreGive(chain_lock);
+
+    len += snprintf(buf + len, size > len ? size - len : 0, "]}");
+    return len < size ? (int)len : (int)size - 1;
+}
@@ -0,0 +1,36 @@
+#ifndef __AUDIO_CHAIN_H_
+#define __AUDIO_CHAIN_H_
+
+#include "audio_pipeline.h"
+#include "freertos/semphr.h"
+
+//处理链最多容纳的处理级数
+#define AUDIO_CHAIN_MAX_STAGES 16
+
+//处理级回调，原地处理一帧，可以修改frame->size
+typedef esp_err_t (*audio_stage_process_t)(void *ctx, audio_frame_t *frame);
+
+//处理级描述
+typedef struct {
+    const char *name;              //名称，注销时用来查找
+    audio_stage_process_t process; //处理函数
+    void *ctx;                     //传给处理函数的参数
+} audio_stage_t;
+
+//处理级统计
+typedef struct {
+    const char *name;
+    uint32_t calls;       //调用次数
+    uint64_t cycles;      //累计CPU周期
+    uint32_t last_cycles; //最近一次的周期数
+    uint32_t max_cycles;  //最大周期数
+} audio_stage_stats_t;
+
+esp_err_t audio_chain_init(void);
+esp_err_t audio_chain_register(const audio_stage_t *stage, int position);
+esp_err_t audio_chain_unregister(const char *name);
+esp_err_t audio_chain_process(audio_frame_t *frame);
+int audio_chain_get_stats(audio_stage_stats_t *stats, int max);
+int audio_chain_format_stats(char *buf, size_t size);
+
+#endif
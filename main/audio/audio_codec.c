@@ -0,0 +1,165 @@
+#include "audio_codec.h"
+
+//IMA ADPCM步长表
+static const int16_t step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+//码字对步长索引的调整
+static const int8_t index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+void audio_adpcm_reset(audio_adpcm_state_t *state)
+{
+    state->predictor = 0;
+    state->index = 0;
+}
+
+//samples个样本编码后的字节数，含状态头
+size_t audio_adpcm_encoded_size(size_t samples)
+{
+    return AUDIO_ADPCM_HEADER_SIZE + (samples + 1) / 2;
+}
+
+//编码一个样本，返回4位码字并更新状态，与解码端的重建完全一致
+static uint8_t adpcm_encode_sample(audio_adpcm_state_t *state, int16_t sample)
+{
+    int step = step_table[state->index];
+    int diff = sample - state->predictor;
+    uint8_t code = 0;
+
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+
+    //逐位逼近，vpdiff是解码端会重建出的差值
+    int vpdiff = step >> 3;
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        vpdiff += step;
+    }
+
+    int predictor = state->predictor + ((code & 8) ? -vpdiff : vpdiff);
+    if (predictor > INT16_MAX) {
+        predictor = INT16_MAX;
+    } else if (predictor < INT16_MIN) {
+        predictor = INT16_MIN;
+    }
+    state->predictor = (int16_t)predictor;
+
+    int index = state->index + index_table[code];
+    state->index = (uint8_t)(index < 0 ? 0 : (index > 88 ? 88 : index));
+
+    return code;
+}
+
+//编码一包：4字节状态头（预测值小端、步长索引、样本数为奇数时为1）加每字节两个码字，先低4位
+//返回写入out的字节数
+size_t audio_adpcm_encode(audio_adpcm_state_t *state, const int16_t *pcm, size_t samples, uint8_t *out)
+{
+    out[0] = (uint8_t)(state->predictor & 0xFF);
+    out[1] = (uint8_t)((uint16_t)state->predictor >> 8);
+    out[2] = state->index;
+    out[3] = (uint8_t)(samples & 1);
+
+    uint8_t *p = out + AUDIO_ADPCM_HEADER_SIZE;
+    size_t i = 0;
+    for (; i + 1 < samples; i += 2) {
+        uint8_t lo = adpcm_encode_sample(state, pcm[i]);
+        uint8_t hi = adpcm_encode_sample(state, pcm[i + 1]);
+        *p++ = (uint8_t)(lo | (hi << 4));
+    }
+    if (i < samples) {
+        *p++ = adpcm_encode_sample(state, pcm[i]);
+    }
+
+    return (size_t)(p - out);
+}
+
+//一包编码数据解码后的样本数，格式不对时返回0
+size_t audio_adpcm_decoded_samples(const uint8_t *in, size_t len)
+{
+    if (len <= AUDIO_ADPCM_HEADER_SIZE || in[2] > 88 || in[3] > 1) {
+        return 0;
+    }
+    return (len - AUDIO_ADPCM_HEADER_SIZE) * 2 - in[3];
+}
+
+//解码一个码字，与编码端的重建相同
+static int16_t adpcm_decode_sample(audio_adpcm_state_t *state, uint8_t code)
+{
+    int step = step_table[state->index];
+    int vpdiff = step >> 3;
+
+    if (code & 4) {
+        vpdiff += step;
+    }
+    if (code & 2) {
+        vpdiff += step >> 1;
+    }
+    if (code & 1) {
+        vpdiff += step >> 2;
+    }
+
+    int predictor = state->predictor + ((code & 8) ? -vpdiff : vpdiff);
+    if (predictor > INT16_MAX) {
+        predictor = INT16_MAX;
+    } else if (predictor < INT16_MIN) {
+        predictor = INT16_MIN;
+    }
+    state->predictor = (int16_t)predictor;
+
+    int index = state->index + index_table[code];
+    state->index = (uint8_t)(index < 0 ? 0 : (index > 88 ? 88 : index));
+
+    return state->predictor;
+}
+
+//解码一包，状态从包头恢复，包之间互不依赖。out至少能放audio_adpcm_decoded_samples个样本
+//返回解码的样本数
+size_t audio_adpcm_decode(const uint8_t *in, size_t len, int16_t *out)
+{
+    size_t samples = audio_adpcm_decoded_samples(in, len);
+    audio_adpcm_state_t state = {
+        .predictor = (int16_t)(in[0] | (in[1] << 8)),
+        .index = in[2],
+    };
+
+    if (samples == 0) {
+        return 0;
+    }
+
+    const uint8_t *p = in + AUDIO_ADPCM_HEADER_SIZE;
+    for (size_t i = 0; i < samples; i += 2) {
+        out[i] = adpcm_decode_sample(&state, *p & 0x0F);
+        if (i + 1 < samples) {
+            out[i + 1] = adpcm_decode_sample(&state, *p >> 4);
+        }
+        p++;
+    }
+
+    return samples;
+}
@@ -0,0 +1,30 @@
+#ifndef __AUDIO_CODEC_H_
+#define __AUDIO_CODEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+//只依赖C库，可以在主机上单独编译测试
+
+//音频帧头codec字段的取值
+typedef enum {
+    AUDIO_CODEC_PCM = 0,        //原始PCM，格式见帧头的channels和bits
+    AUDIO_CODEC_IMA_ADPCM = 1,  //IMA ADPCM，16位单声道压缩到4位
+} audio_codec_t;
+
+//IMA ADPCM每包开头的状态头，解码端从任意一包都能开始解码
+#define AUDIO_ADPCM_HEADER_SIZE 4
+
+//IMA ADPCM编码器状态，跨包连续
+typedef struct {
+    int16_t predictor;  //上一个重建样本
+    uint8_t index;      //步长表索引
+} audio_adpcm_state_t;
+
+void audio_adpcm_reset(audio_adpcm_state_t *state);
+size_t audio_adpcm_encoded_size(size_t samples);
+size_t audio_adpcm_encode(audio_adpcm_state_t *state, const int16_t *pcm, size_t samples, uint8_t *out);
+size_t audio_adpcm_decoded_samples(const uint8_t *in, size_t len);
+size_t audio_adpcm_decode(const uint8_t *in, size_t len, int16_t *out);
+
+#endif
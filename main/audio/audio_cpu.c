@@ -0,0 +1,66 @@
+#include "audio_cpu.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+//上次调用时各任务的累计运行时间，按任务句柄对应
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t run_time;
+} cpu_sample_t;
+
+static TaskStatus_t tasks[AUDIO_CPU_MAX_TASKS];
+static cpu_sample_t prev[AUDIO_CPU_MAX_TASKS];
+static int prev_count = 0;
+static uint32_t prev_total = 0;
+
+//上次调用时的累计运行时间，新建的任务从0算起
+static uint32_t cpu_prev_run_time(TaskHandle_t handle)
+{
+    for (int i = 0; i < prev_count; i++) {
+        if (prev[i].handle == handle) {
+            return prev[i].run_time;
+        }
+    }
+    return 0;
+}
+
+//不可重入，只在一个任务里调用
+int audio_cpu_format(char *buf, size_t size)
+{
+    uint32_t total = 0;
+    int count = uxTaskGetSystemState(tasks, AUDIO_CPU_MAX_TASKS, &total);
+    //运行时间计数是32位的，差值跨过一次回绕也是对的
+    uint32_t window = total - prev_total;
+    size_t len = 0;
+
+    len += snprintf(buf + len, size > len ? size - len : 0, "{\"type\":\"cpu\",\"window_us\":%lu,\"tasks\":[",
+                    (unsigned long)window);
+    for (int i = 0; i < count; i++) {
+        const TaskStatus_t *t = &tasks[i];
+        uint32_t used = t->ulRunTimeCounter - cpu_prev_run_time(t->xHandle);
+        BaseType_t core = xTaskGetCoreID(t->xHandle);
+        len += snprintf(buf + len, size > len ? size - len : 0,
+                        "%s{\"name\":\"%s\",\"core\":%d,\"prio\":%u,\"pct\":%.1f}", i == 0 ? "" : ",",
+                        t->pcTaskName, core == tskNO_AFFINITY ? -1 : (int)core, (unsigned)t->uxCurrentPriority,
+                        window > 0 ? used * 100.0 / window : 0.0);
+    }
+    len += snprintf(buf + len, size > len ? size - len : 0, "]}");
+
+    for (int i = 0; i < count; i++) {
+        prev[i].handle = tasks[i].xHandle;
+        prev[i].run_time = tasks[i].ulRunTimeCounter;
+    }
+    prev_count = count;
+    prev_total = total;
+
+    return len < size ? (int)len : (int)size - 1;
+}
+#else
+int audio_cpu_format(char *buf, size_t size)
+{
+    return snprintf(buf, size, "{\"type\":\"cpu\",\"error\":\"run time stats disabled\"}");
+}
+#endif
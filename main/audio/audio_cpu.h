@@ -0,0 +1,14 @@
+#ifndef __AUDIO_CPU_H_
+#define __AUDIO_CPU_H_
+
+#include <stddef.h>
+
+//最多统计的任务数，超出的任务不计入
+#define AUDIO_CPU_MAX_TASKS 32
+
+//各任务从上次调用到现在占用CPU的比例，格式化成一行JSON，返回写入的长度（不含结尾的0）
+//百分比按单个核计算，固定在某个核上的任务最多100%
+//需要打开CONFIG_FREERTOS_USE_TRACE_FACILITY和CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+int audio_cpu_format(char *buf, size_t size);
+
+#endif
@@ -0,0 +1,205 @@
+#include "audio_fft.h"
+#include "esp_heap_caps.h"
+#include <math.h>
+#include <string.h>
+
+//n为2的幂，最大65536
+esp_err_t audio_fft_init(audio_fft_t *fft, size_t n)
+{
+    memset(fft, 0, sizeof(*fft));
+    if (n < 2 || (n & (n - 1)) != 0 || n > 65536) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fft->n = n;
+    fft->twiddle = heap_caps_malloc(n * sizeof(float), MALLOC_CAP_INTERNAL);
+    fft->bitrev = heap_caps_malloc(n * sizeof(uint16_t), MALLOC_CAP_INTERNAL);
+    if (fft->twiddle == NULL || fft->bitrev == NULL) {
+        audio_fft_deinit(fft);
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (size_t k = 0; k < n / 2; k++) {
+        double w = 2.0 * M_PI * k / n;
+        fft->twiddle[2 * k] = (float)cos(w);
+        fft->twiddle[2 * k + 1] = (float)-sin(w);
+    }
+
+    size_t bits = 0;
+    while (((size_t)1 << bits) < n) {
+        bits++;
+    }
+    for (size_t i = 0; i < n; i++) {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; b++) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        fft->bitrev[i] = (uint16_t)r;
+    }
+
+    return ESP_OK;
+}
+
+void audio_fft_deinit(audio_fft_t *fft)
+{
+    heap_caps_free(fft->twiddle);
+    heap_caps_free(fft->bitrev);
+    fft->twiddle = NULL;
+    fft->bitrev = NULL;
+}
+
+//时间抽取蝶形运算，sign为-1时是正变换，+1时是逆变换（不缩放）
+static void fft_radix2(const audio_fft_t *fft, float *data, float sign)
+{
+    size_t n = fft->n;
+
+    for (size_t i = 0; i < n; i++) {
+        size_t j = fft->bitrev[i];
+        if (j > i) {
+            float re = data[2 * i];
+            float im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+    }
+
+    for (size_t len = 2; len <= n; len <<= 1) {
+        size_t half = len / 2;
+        size_t step = n / len;
+        for (size_t start = 0; start < n; start += len) {
+            for (size_t k = 0; k < half; k++) {
+                float wr = fft->twiddle[2 * k * step];
+                float wi = -sign * fft->twiddle[2 * k * step + 1];
+                float *a = &data[2 * (start + k)];
+                float *b = &data[2 * (start + k + half)];
+                float tr = b[0] * wr - b[1] * wi;
+                float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+//正变换 X[k] = sum x[n] e^(-j2πkn/N)
+void audio_fft_forward(const audio_fft_t *fft, float *data)
+{
+    fft_radix2(fft, data, -1.0f);
+}
+
+//逆变换，结果已除以N
+void audio_fft_inverse(const audio_fft_t *fft, float *data)
+{
+    fft_radix2(fft, data, 1.0f);
+
+    float scale = 1.0f / fft->n;
+    for (size_t i = 0; i < 2 * fft->n; i++) {
+        data[i] *= scale;
+    }
+}
+
+//n为2的幂，至少4点
+esp_err_t audio_fft_real_init(audio_fft_real_t *fft, size_t n)
+{
+    memset(fft, 0, sizeof(*fft));
+    if (n < 4 || (n & (n - 1)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = audio_fft_init(&fft->half, n / 2);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    fft->n = n;
+    fft->twiddle = heap_caps_malloc((n / 4 + 1) * 2 * sizeof(float), MALLOC_CAP_INTERNAL);
+    if (fft->twiddle == NULL) {
+        audio_fft_real_deinit(fft);
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (size_t k = 0; k <= n / 4; k++) {
+        double w = 2.0 * M_PI * k / n;
+        fft->twiddle[2 * k] = (float)cos(w);
+        fft->twiddle[2 * k + 1] = (float)-sin(w);
+    }
+
+    return ESP_OK;
+}
+
+void audio_fft_real_deinit(audio_fft_real_t *fft)
+{
+    audio_fft_deinit(&fft->half);
+    heap_caps_free(fft->twiddle);
+    fft->twiddle = NULL;
+}
+
+//正变换：data[0..n-1]为实数输入，输出data[0..n+1]为频点0..n/2
+//把偶数点、奇数点当作实部、虚部做n/2点复数FFT，再用共轭对称把两部分拆开：
+//X[k] = Fe[k] + W^k * Fo[k]，X[m-k] = conj(Fe[k] - W^k * Fo[k])，m = n/2
+void audio_fft_real_forward(const audio_fft_real_t *fft, float *data)
+{
+    size_t m = fft->n / 2;
+
+    audio_fft_forward(&fft->half, data);
+
+    float z0r = data[0];
+    float z0i = data[1];
+    data[0] = z0r + z0i;
+    data[1] = 0.0f;
+    data[2 * m] = z0r - z0i;
+    data[2 * m + 1] = 0.0f;
+
+    for (size_t k = 1; k <= m / 2; k++) {
+        float *a = &data[2 * k];
+        float *b = &data[2 * (m - k)];
+        //Fe = (Z[k] + conj(Z[m-k])) / 2，Fo = (Z[k] - conj(Z[m-k])) / 2j
+        float fer = 0.5f * (a[0] + b[0]);
+        float fei = 0.5f * (a[1] - b[1]);
+        float for_ = 0.5f * (a[1] + b[1]);
+        float foi = -0.5f * (a[0] - b[0]);
+        float wr = fft->twiddle[2 * k];
+        float wi = fft->twiddle[2 * k + 1];
+        float tr = wr * for_ - wi * foi;
+        float ti = wr * foi + wi * for_;
+        a[0] = fer + tr;
+        a[1] = fei + ti;
+        b[0] = fer - tr;
+        b[1] = -(fei - ti);
+    }
+}
+
+//逆变换：data[0..n+1]为频点0..n/2，输出data[0..n-1]为实数序列，已除以n
+void audio_fft_real_inverse(const audio_fft_real_t *fft, float *data)
+{
+    size_t m = fft->n / 2;
+
+    float x0 = data[0];
+    float xm = data[2 * m];
+    data[0] = 0.5f * (x0 + xm);
+    data[1] = 0.5f * (x0 - xm);
+
+    for (size_t k = 1; k <= m / 2; k++) {
+        float *a = &data[2 * k];
+        float *b = &data[2 * (m - k)];
+        //Fe = (X[k] + conj(X[m-k])) / 2，Fo = (X[k] - conj(X[m-k])) / 2 * conj(W^k)，Z[k] = Fe + j*Fo
+        float fer = 0.5f * (a[0] + b[0]);
+        float fei = 0.5f * (a[1] - b[1]);
+        float dr = 0.5f * (a[0] - b[0]);
+        float di = 0.5f * (a[1] + b[1]);
+        float wr = fft->twiddle[2 * k];
+        float wi = -fft->twiddle[2 * k + 1];
+        float for_ = dr * wr - di * wi;
+        float foi = dr * wi + di * wr;
+        a[0] = fer - foi;
+        a[1] = fei + for_;
+        b[0] = fer + foi;
+        b[1] = -fei + for_;
+    }
+
+    audio_fft_inverse(&fft->half, data);
+}
@@ -0,0 +1,34 @@
+#ifndef __AUDIO_FFT_H_
+#define __AUDIO_FFT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+//基2复数FFT，float，数据按实部、虚部交织原地变换
+//旋转因子和位反转表在初始化时一次算好，变换过程中不分配内存
+typedef struct {
+    size_t n;           //点数，2的幂
+    float *twiddle;     //n/2个旋转因子，cos、-sin交织
+    uint16_t *bitrev;   //位反转下标
+} audio_fft_t;
+
+//实数FFT，n点实数序列用n/2点复数FFT加一次拆分完成
+//频谱只存0..n/2共n/2+1个频点，实部、虚部交织，数据缓冲至少n+2个float
+typedef struct {
+    size_t n;           //实数点数，2的幂
+    audio_fft_t half;   //n/2点复数FFT
+    float *twiddle;     //拆分用的n/4+1个旋转因子e^(-j2πk/n)，cos、-sin交织
+} audio_fft_real_t;
+
+esp_err_t audio_fft_init(audio_fft_t *fft, size_t n);
+void audio_fft_deinit(audio_fft_t *fft);
+void audio_fft_forward(const audio_fft_t *fft, float *data);
+void audio_fft_inverse(const audio_fft_t *fft, float *data);
+
+esp_err_t audio_fft_real_init(audio_fft_real_t *fft, size_t n);
+void audio_fft_real_deinit(audio_fft_real_t *fft);
+void audio_fft_real_forward(const audio_fft_real_t *fft, float *data);
+void audio_fft_real_inverse(const audio_fft_real_t *fft, float *data);
+
+#endif
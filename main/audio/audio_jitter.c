@@ -0,0 +1,402 @@
+#include "audio_jitter.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include <string.h>
+#include <math.h>
+
+//目标深度 = 最小深度 + JITTER_DEPTH_FACTOR倍抖动
+#define JITTER_DEPTH_FACTOR 3
+
+//补偿：在2.5ms ~ 15ms（400Hz ~ 66Hz）之间找基音周期，连续补偿PLC_FADE_FRAMES帧后衰减到静音
+#define PLC_MIN_PITCH_HZ 400
+#define PLC_MAX_PITCH_HZ 66
+#define PLC_FADE_FRAMES  2
+
+//降延迟丢包时接缝处交叉淡化的时长
+#define SPLICE_MS 5
+
+//序号比较，允许回绕
+static inline bool seq_before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+static uint32_t frame_ms(const audio_jitter_t *jb)
+{
+    return (uint32_t)(jb->frame_samples * 1000 / jb->sample_rate);
+}
+
+//初始化抖动缓冲，所有包缓冲在这里一次分配
+esp_err_t audio_jitter_init(audio_jitter_t *jb, uint32_t sample_rate, size_t max_samples, uint32_t min_ms, uint32_t max_ms)
+{
+    memset(jb, 0, sizeof(*jb));
+    jb->sample_rate = sample_rate;
+    jb->max_samples = max_samples;
+    jb->min_ms = min_ms;
+    jb->max_ms = max_ms;
+    jb->frame_samples = sample_rate / 50;//收到第一个包之前按20ms一帧
+    jb->stats.target_ms = min_ms;
+
+    jb->lock = xSemaphoreCreateMutex();
+    jb->last_pcm = heap_caps_malloc(max_samples * sizeof(int16_t), MALLOC_CAP_8BIT);
+    jb->splice_pcm = heap_caps_malloc(sample_rate * SPLICE_MS / 1000 * sizeof(int16_t), MALLOC_CAP_8BIT);
+    if (jb->lock == NULL || jb->last_pcm == NULL || jb->splice_pcm == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < AUDIO_JITTER_SLOTS; i++) {
+        //PCM是最大的编码形式
+        jb->slots[i].data = heap_caps_malloc(max_samples * sizeof(int16_t), MALLOC_CAP_8BIT);
+        if (jb->slots[i].data == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    return ESP_OK;
+}
+
+//清空缓冲，重新从seq开始
+static void jitter_flush(audio_jitter_t *jb, uint32_t seq)
+{
+    for (int i = 0; i < AUDIO_JITTER_SLOTS; i++) {
+        jb->slots[i].used = false;
+    }
+    jb->buffered = 0;
+    jb->next_seq = seq;
+    jb->playing = false;
+    jb->splice_len = 0;
+}
+
+//根据到达间隔和序号间隔估计抖动，并更新目标深度
+static void jitter_update(audio_jitter_t *jb, uint32_t seq)
+{
+    int64_t now = esp_timer_get_time();
+
+    //超过1秒没收到包是断线而不是抖动，不计入估计，否则目标深度会被长时间撑大
+    if (jb->last_arrival_us != 0 && now - jb->last_arrival_us < 1000000) {
+        int64_t frame_us = (int64_t)jb->frame_samples * 1000000 / jb->sample_rate;
+        int64_t expected = (int64_t)(int32_t)(seq - jb->last_seq) * frame_us;
+        float d = (float)((now - jb->last_arrival_us) - expected);
+
+        d = d < 0 ? -d : d;
+        jb->jitter_us += (d - jb->jitter_us) / 16.0f;
+    }
+    jb->last_arrival_us = now;
+    jb->last_seq = seq;
+
+    //目标深度还要留两个槽给提前到达的包，否则永远攒不够
+    uint32_t max_ms = (AUDIO_JITTER_SLOTS - 2) * frame_ms(jb);
+    max_ms = max_ms < jb->max_ms ? max_ms : jb->max_ms;
+
+    uint32_t target = jb->min_ms + JITTER_DEPTH_FACTOR * (uint32_t)(jb->jitter_us / 1000.0f);
+    jb->stats.target_ms = target > max_ms ? max_ms : target;
+}
+
+//一包解码后的样本数，格式不对时返回0
+static size_t packet_samples(audio_codec_t codec, const uint8_t *data, size_t len)
+{
+    switch (codec) {
+    case AUDIO_CODEC_PCM:
+        return len % sizeof(int16_t) == 0 ? len / sizeof(int16_t) : 0;
+    case AUDIO_CODEC_IMA_ADPCM:
+        return audio_adpcm_decoded_samples(data, len);
+    default:
+        return 0;
+    }
+}
+
+//放入一个未解码的包，在网络任务中调用
+esp_err_t audio_jitter_push(audio_jitter_t *jb, uint32_t seq, audio_codec_t codec, const uint8_t *data, size_t len)
+{
+    size_t samples = packet_samples(codec, data, len);
+    if (samples == 0 || samples > jb->max_samples || len > jb->max_samples * sizeof(int16_t)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreTake(jb->lock, portMAX_DELAY);
+
+    jb->stats.received++;
+    jb->frame_samples = samples;
+    jitter_update(jb, seq);
+
+    if (!jb->started) {
+        jb->started = true;
+        jitter_flush(jb, seq);
+    } else if (seq_before(seq, jb->next_seq) && jb->next_seq - seq < AUDIO_JITTER_SLOTS) {
+        jb->stats.late++;
+        xSemaphoreGive(jb->lock);
+        return ESP_ERR_TIMEOUT;
+    } else if (seq_before(seq, jb->next_seq) || seq - jb->next_seq >= AUDIO_JITTER_SLOTS) {
+        //序号倒退或者跳得太远（服务器重新开始、断线重连），从这个包重新缓冲
+        jb->stats.restarted++;
+        jitter_flush(jb, seq);
+    }
+
+    audio_jitter_slot_t *slot = &jb->slots[seq % AUDIO_JITTER_SLOTS];
+    if (slot->used && slot->seq == seq) {
+        jb->stats.duplicate++;
+    } else {
+        memcpy(slot->data, data, len);
+        slot->len = len;
+        slot->codec = codec;
+        slot->samples = samples;
+        slot->seq = seq;
+        slot->used = true;
+        jb->buffered++;
+    }
+
+    xSemaphoreGive(jb->lock);
+    return ESP_OK;
+}
+
+//解码一包到last_pcm，记录解码耗时
+static size_t jitter_decode(audio_jitter_t *jb, const audio_jitter_slot_t *slot)
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+    size_t samples;
+
+    if (slot->codec == AUDIO_CODEC_IMA_ADPCM) {
+        samples = audio_adpcm_decode(slot->data, slot->len, jb->last_pcm);
+    } else {
+        samples = slot->samples;
+        memcpy(jb->last_pcm, slot->data, samples * sizeof(int16_t));
+    }
+
+    jb->stats.decode_cycles = esp_cpu_get_cycle_count() - start;
+    if (jb->stats.decode_cycles > jb->stats.decode_cycles_max) {
+        jb->stats.decode_cycles_max = jb->stats.decode_cycles;
+    }
+    return samples;
+}
+
+//在上一包末尾按归一化自相关找基音周期，清音或包太短时返回0
+static size_t plc_find_period(const int16_t *pcm, size_t samples, uint32_t sample_rate)
+{
+    size_t min_lag = sample_rate / PLC_MIN_PITCH_HZ;
+    size_t max_lag = sample_rate / PLC_MAX_PITCH_HZ;
+    if (max_lag * 2 > samples) {
+        max_lag = samples / 2;
+    }
+    if (min_lag >= max_lag) {
+        return 0;
+    }
+
+    //用最后max_lag个样本与往前lag个样本的那一段比较
+    const int16_t *tail = pcm + samples - max_lag;
+    int64_t energy = 0;
+    for (size_t i = 0; i < max_lag; i++) {
+        energy += (int32_t)tail[i] * tail[i];
+    }
+    if (energy == 0) {
+        return 0;
+    }
+
+    size_t best_lag = 0;
+    float best = 0.0f;
+    for (size_t lag = min_lag; lag <= max_lag; lag++) {
+        const int16_t *past = tail - lag;
+        int64_t corr = 0;
+        int64_t lag_energy = 0;
+        for (size_t i = 0; i < max_lag; i++) {
+            corr += (int32_t)tail[i] * past[i];
+            lag_energy += (int32_t)past[i] * past[i];
+        }
+        if (corr <= 0 || lag_energy == 0) {
+            continue;
+        }
+        float score = (float)corr / sqrtf((float)energy * (float)lag_energy);
+        if (score > best) {
+            best = score;
+            best_lag = lag;
+        }
+    }
+
+    //相关性太弱说明是清音，重复一个周期反而会有蜂鸣声
+    return best > 0.5f ? best_lag : 0;
+}
+
+//补偿帧：浊音重复上一包的最后一个基音周期，清音重复上一包，逐帧衰减到静音，避免咔哒声和突然静音
+//补偿帧和一包一样长，一次取不完时从conceal_pos接着输出，衰减按整帧的位置计算
+static size_t jitter_conceal(audio_jitter_t *jb, int16_t *out, size_t max_samples)
+{
+    if (jb->conceal_pos == 0) {
+        if (jb->conceal_count == 0) {
+            jb->plc_period = plc_find_period(jb->last_pcm, jb->last_samples, jb->sample_rate);
+            if (jb->plc_period == 0) {
+                jb->plc_period = jb->last_samples;
+            }
+            jb->plc_pos = 0;
+        }
+        jb->conceal_samples = jb->frame_samples;
+        jb->stats.concealed++;
+        jb->splice_len = 0;//补偿之后的包淡入，不再接缝
+    }
+
+    size_t remain = jb->conceal_samples - jb->conceal_pos;
+    size_t samples = remain < max_samples ? remain : max_samples;
+
+    if (jb->conceal_count >= PLC_FADE_FRAMES || jb->plc_period == 0) {
+        memset(out, 0, samples * sizeof(int16_t));
+    } else {
+        const int16_t *period = jb->last_pcm + jb->last_samples - jb->plc_period;
+        int32_t fade_len = (int32_t)(PLC_FADE_FRAMES * jb->conceal_samples);
+        int32_t faded = (int32_t)(jb->conceal_count * jb->conceal_samples + jb->conceal_pos);
+
+        for (size_t i = 0; i < samples; i++) {
+            int32_t gain = fade_len - faded - (int32_t)i;
+            out[i] = (int16_t)((int32_t)period[(jb->plc_pos + i) % jb->plc_period] * gain / fade_len);
+        }
+        jb->plc_pos += samples;
+    }
+
+    jb->conceal_pos += samples;
+    if (jb->conceal_pos >= jb->conceal_samples) {
+        jb->conceal_pos = 0;
+        jb->conceal_count++;
+    }
+    return samples;
+}
+
+//降延迟丢掉一包时准备接缝的淡出一侧：丢掉的包在的话解码出来取开头一段，它和已经播放的上一包是连续的，
+//解码结果留在last_pcm里，下一包没到时补偿从它接着做；不在的话用上一包最后一个基音周期续上
+static void jitter_splice_prepare(audio_jitter_t *jb, const audio_jitter_slot_t *old)
+{
+    size_t len = jb->sample_rate * SPLICE_MS / 1000;
+
+    if (old != NULL) {
+        jb->last_samples = jitter_decode(jb, old);
+        jb->last_pos = jb->last_samples;
+        len = len < jb->last_samples ? len : jb->last_samples;
+        memcpy(jb->splice_pcm, jb->last_pcm, len * sizeof(int16_t));
+    } else if (jb->last_samples > 0) {
+        size_t period = plc_find_period(jb->last_pcm, jb->last_samples, jb->sample_rate);
+        period = period > 0 ? period : jb->last_samples;
+        const int16_t *tail = jb->last_pcm + jb->last_samples - period;
+        for (size_t i = 0; i < len; i++) {
+            jb->splice_pcm[i] = tail[i % period];
+        }
+    } else {
+        len = 0;
+    }
+    jb->splice_len = len;
+}
+
+//新解码的一包开头和接缝的淡出一侧线性交叉淡化
+static void jitter_splice_apply(audio_jitter_t *jb)
+{
+    size_t len = jb->splice_len < jb->last_samples ? jb->splice_len : jb->last_samples;
+
+    for (size_t i = 0; i < len; i++) {
+        int32_t in = (int32_t)i + 1;
+        int32_t out = (int32_t)len - (int32_t)i;
+        jb->last_pcm[i] = (int16_t)(((int32_t)jb->splice_pcm[i] * out + (int32_t)jb->last_pcm[i] * in) /
+                                    (int32_t)(len + 1));
+    }
+    jb->splice_len = 0;
+}
+
+//输出last_pcm中还没输出的部分
+static size_t jitter_drain(audio_jitter_t *jb, int16_t *out, size_t max_samples)
+{
+    size_t remain = jb->last_samples - jb->last_pos;
+    size_t samples = remain < max_samples ? remain : max_samples;
+
+    memcpy(out, jb->last_pcm + jb->last_pos, samples * sizeof(int16_t));
+    jb->last_pos += samples;
+    return samples;
+}
+
+//取出下一帧，在播放任务中调用，总是返回一帧（正常数据、补偿帧或缓冲中的静音）
+size_t audio_jitter_pop(audio_jitter_t *jb, int16_t *out, size_t max_samples)
+{
+    size_t samples = 0;
+
+    xSemaphoreTake(jb->lock, portMAX_DELAY);
+
+    uint32_t depth_ms = jb->buffered * frame_ms(jb);
+    jb->stats.depth_ms = depth_ms;
+    jb->stats.jitter_us = (uint32_t)jb->jitter_us;
+
+    //上一包或补偿帧还没输出完，先输出剩下的部分再取下一包
+    if (jb->last_pos < jb->last_samples) {
+        samples = jitter_drain(jb, out, max_samples);
+        xSemaphoreGive(jb->lock);
+        return samples;
+    }
+    if (jb->conceal_pos > 0) {
+        samples = jitter_conceal(jb, out, max_samples);
+        xSemaphoreGive(jb->lock);
+        return samples;
+    }
+
+    //缓冲阶段：攒够目标深度再开始播放
+    if (!jb->playing) {
+        if (jb->buffered == 0 || depth_ms < jb->stats.target_ms) {
+            samples = jb->frame_samples < max_samples ? jb->frame_samples : max_samples;
+            memset(out, 0, samples * sizeof(int16_t));
+            xSemaphoreGive(jb->lock);
+            return samples;
+        }
+        jb->playing = true;
+    }
+
+    //缓冲比目标深两帧以上说明网络变好了，丢掉最旧的一包降低延迟
+    //接缝处交叉淡化，避免波形跳变的咔哒声；补偿之后的包本来就淡入，不需要
+    if (depth_ms > jb->stats.target_ms + 2 * frame_ms(jb)) {
+        audio_jitter_slot_t *old = &jb->slots[jb->next_seq % AUDIO_JITTER_SLOTS];
+        bool present = old->used && old->seq == jb->next_seq;
+        if (jb->conceal_count == 0) {
+            jitter_splice_prepare(jb, present ? old : NULL);
+        }
+        if (present) {
+            old->used = false;
+            jb->buffered--;
+            jb->stats.trimmed++;
+        }
+        jb->next_seq++;
+    }
+
+    audio_jitter_slot_t *slot = &jb->slots[jb->next_seq % AUDIO_JITTER_SLOTS];
+    if (slot->used && slot->seq == jb->next_seq) {
+        jb->last_samples = jitter_decode(jb, slot);
+        jb->last_pos = 0;
+        if (jb->splice_len > 0) {
+            jitter_splice_apply(jb);
+        }
+        samples = jitter_drain(jb, out, max_samples);
+        slot->used = false;
+        jb->buffered--;
+        jb->next_seq++;
+        jb->stats.played++;
+
+        //补偿之后恢复正常数据，淡入
+        if (jb->conceal_count > 0) {
+            for (size_t i = 0; i < samples; i++) {
+                out[i] = (int16_t)((int32_t)out[i] * (int32_t)i / (int32_t)samples);
+            }
+            jb->conceal_count = 0;
+        }
+    } else if (jb->buffered == 0) {
+        //播空了，补偿一帧并重新缓冲，目标深度已经随抖动估计增大
+        jb->stats.underrun++;
+        jb->playing = false;
+        samples = jitter_conceal(jb, out, max_samples);
+    } else {
+        //这一包丢了或者还没到，后面的包已经在了，跳过它
+        jb->stats.lost++;
+        jb->next_seq++;
+        samples = jitter_conceal(jb, out, max_samples);
+    }
+
+    xSemaphoreGive(jb->lock);
+    return samples;
+}
+
+//获取统计
+void audio_jitter_get_stats(audio_jitter_t *jb, audio_jitter_stats_t *stats)
+{
+    xSemaphoreTake(jb->lock, portMAX_DELAY);
+    *stats = jb->stats;
+    xSemaphoreGive(jb->lock);
+}
@@ -0,0 +1,80 @@
+#ifndef __AUDIO_JITTER_H_
+#define __AUDIO_JITTER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "audio_codec.h"
+
+//缓冲槽个数，按序号取模存放
+#define AUDIO_JITTER_SLOTS 24
+
+//抖动缓冲统计
+typedef struct {
+    uint32_t received;    //收到的包数
+    uint32_t played;      //正常播放的包数
+    uint32_t late;        //到得太晚（已经错过播放时刻）的包数
+    uint32_t duplicate;   //重复包数
+    uint32_t lost;        //缺失后被跳过的包数
+    uint32_t underrun;    //缓冲播空的次数
+    uint32_t concealed;   //输出补偿帧（基音重复或静音）的次数
+    uint32_t trimmed;     //缓冲超过目标深度时丢弃的包数
+    uint32_t jitter_us;   //当前的网络抖动估计
+    uint32_t target_ms;   //当前的目标缓冲深度
+    uint32_t depth_ms;    //当前的缓冲深度
+    uint32_t restarted;   //序号跳变后重新缓冲的次数（服务器重启、长时间断线）
+    uint32_t decode_cycles;     //最近一包的解码耗时（CPU周期）
+    uint32_t decode_cycles_max; //解码耗时的最大值
+} audio_jitter_stats_t;
+
+typedef struct {
+    bool used;
+    uint32_t seq;
+    audio_codec_t codec;
+    size_t samples;     //解码后的样本数
+    size_t len;         //data中的字节数
+    uint8_t *data;      //未解码的数据，播放时才解码
+} audio_jitter_slot_t;
+
+//自适应抖动缓冲，按包缓存编码数据，取出时解码成16位单声道PCM
+typedef struct {
+    audio_jitter_slot_t slots[AUDIO_JITTER_SLOTS];
+    size_t max_samples;        //单包最大样本数
+    uint32_t sample_rate;
+    uint32_t min_ms;           //最小目标深度
+    uint32_t max_ms;           //最大目标深度
+    SemaphoreHandle_t lock;
+
+    bool started;              //收到过第一个包
+    bool playing;              //false表示正在缓冲，输出静音
+    uint32_t next_seq;         //下一个要播放的序号
+    int buffered;              //缓冲中的包数
+    size_t frame_samples;      //最近一个包的样本数，作为补偿帧的长度
+
+    int64_t last_arrival_us;   //上一个包的到达时刻
+    uint32_t last_seq;         //上一个包的序号
+    float jitter_us;           //平滑后的到达间隔抖动（RFC3550算法）
+
+    int16_t *last_pcm;         //最近播放的一包，丢包时从中取基音周期重复
+    size_t last_samples;
+    size_t last_pos;           //last_pcm已输出的样本数，一次取不完的部分留到下一次
+    int conceal_count;         //连续补偿的帧数，恢复时淡入
+    size_t conceal_samples;    //当前补偿帧的长度
+    size_t conceal_pos;        //当前补偿帧已输出的样本数，0表示没有输出到一半的补偿帧
+    size_t plc_period;         //补偿用的基音周期（样本数）
+    size_t plc_pos;            //补偿已输出的样本数
+    int16_t *splice_pcm;       //降延迟丢包时接缝淡出的一侧，接在已经播放的音频后面
+    size_t splice_len;         //splice_pcm中的样本数，0表示下一包不需要交叉淡化
+
+    audio_jitter_stats_t stats;
+} audio_jitter_t;
+
+esp_err_t audio_jitter_init(audio_jitter_t *jb, uint32_t sample_rate, size_t max_samples, uint32_t min_ms, uint32_t max_ms);
+esp_err_t audio_jitter_push(audio_jitter_t *jb, uint32_t seq, audio_codec_t codec, const uint8_t *data, size_t len);
+//每次最多取max_samples个样本，包比这长时剩下的部分在后面几次取出
+size_t audio_jitter_pop(audio_jitter_t *jb, int16_t *out, size_t max_samples);
+void audio_jitter_get_stats(audio_jitter_t *jb, audio_jitter_stats_t *stats);
+
+#endif
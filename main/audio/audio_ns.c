@@ -0,0 +1,178 @@
+#include "audio_ns.h"
+#include "esp_heap_caps.h"
+#include "esp_cpu.h"
+#include <math.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define INIT_BLOCKS 16      //开始的16帧（约128ms）直接平均作为初始噪声谱
+#define POWER_SMOOTH 0.8f   //跟踪噪声前先把每个频点的功率平滑一下，压住单帧的随机起伏
+#define NOISE_FALL  0.7f    //平滑功率低于噪声估计时快速跟下去
+#define NOISE_RISE  1.005f  //否则每帧最多上升0.02dB，约2.7dB/s，说话时噪声估计基本不动
+#define NOISE_BIAS  1.4f    //跟踪的是最小值，比噪声平均功率偏低，补回来
+#define DD_ALPHA    0.96f   //判决引导的平滑系数，越大残留的"音乐噪声"越少，语音起始越钝
+
+static void *ns_alloc(size_t size)
+{
+    void *p = heap_caps_calloc(1, size, MALLOC_CAP_INTERNAL);
+    if (p == NULL) {
+        p = heap_caps_calloc(1, size, MALLOC_CAP_SPIRAM);
+    }
+    return p;
+}
+
+//max_atten_db为最大衰减，max_frame为audio_ns_process一次最多处理的样本数
+esp_err_t audio_ns_init(audio_ns_t *ns, uint32_t sample_rate, uint32_t max_atten_db, size_t max_frame)
+{
+    memset(ns, 0, sizeof(*ns));
+    ns->sample_rate = sample_rate;
+    ns->gain_floor = powf(10.0f, -(float)max_atten_db / 20.0f);
+
+    esp_err_t ret = audio_fft_real_init(&ns->fft, AUDIO_NS_FFT);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ns->window = ns_alloc(AUDIO_NS_FFT * sizeof(float));
+    ns->work = ns_alloc((AUDIO_NS_FFT + 2) * sizeof(float));
+    ns->noise = ns_alloc(AUDIO_NS_BINS * sizeof(float));
+    ns->power = ns_alloc(AUDIO_NS_BINS * sizeof(float));
+    ns->speech = ns_alloc(AUDIO_NS_BINS * sizeof(float));
+    ns->overlap = ns_alloc(AUDIO_NS_HOP * sizeof(float));
+
+    //输出先垫一个帧移的静音，之后每进一个帧移出一个帧移
+    ns->out_cap = max_frame + 2 * AUDIO_NS_HOP;
+    ns->out_fifo = ns_alloc(ns->out_cap * sizeof(int16_t));
+    ns->out_count = AUDIO_NS_HOP;
+
+    if (ns->window == NULL || ns->work == NULL || ns->noise == NULL || ns->power == NULL || ns->speech == NULL ||
+        ns->overlap == NULL || ns->out_fifo == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    //周期sqrt-Hann窗，分析和合成各乘一次，50%重叠时平方和为1
+    for (size_t i = 0; i < AUDIO_NS_FFT; i++) {
+        ns->window[i] = sqrtf(0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / AUDIO_NS_FFT));
+    }
+
+    return ESP_OK;
+}
+
+//释放初始化时分配的缓冲
+void audio_ns_deinit(audio_ns_t *ns)
+{
+    audio_fft_real_deinit(&ns->fft);
+    heap_caps_free(ns->window);
+    heap_caps_free(ns->work);
+    heap_caps_free(ns->noise);
+    heap_caps_free(ns->power);
+    heap_caps_free(ns->speech);
+    heap_caps_free(ns->overlap);
+    heap_caps_free(ns->out_fifo);
+    memset(ns, 0, sizeof(*ns));
+}
+
+//处理一个帧移：history为最近AUDIO_NS_FFT个样本，输出最早的AUDIO_NS_HOP个样本到out_fifo
+static void ns_block(audio_ns_t *ns)
+{
+    float *work = ns->work;
+
+    for (size_t i = 0; i < AUDIO_NS_FFT; i++) {
+        work[i] = ns->history[i] / 32768.0f * ns->window[i];
+    }
+    audio_fft_real_forward(&ns->fft, work);
+
+    bool init = ns->stats.blocks < INIT_BLOCKS;
+    float noise_sum = 0.0f;
+    float gain_sum = 0.0f;
+    for (size_t k = 0; k < AUDIO_NS_BINS; k++) {
+        float re = work[2 * k];
+        float im = work[2 * k + 1];
+        float p = re * re + im * im;
+
+        float *noise = &ns->noise[k];
+        float smooth = POWER_SMOOTH * ns->power[k] + (1.0f - POWER_SMOOTH) * p;
+        ns->power[k] = smooth;
+        if (init) {
+            *noise += (p - *noise) / (ns->stats.blocks + 1);
+        } else {
+            if (smooth * NOISE_BIAS < *noise) {
+                *noise = NOISE_FALL * *noise + (1.0f - NOISE_FALL) * smooth * NOISE_BIAS;
+            } else {
+                *noise *= NOISE_RISE;
+            }
+        }
+        float n = *noise + 1e-12f;
+        noise_sum += n;
+
+        //判决引导的先验信噪比，维纳增益 G = ξ / (1 + ξ)
+        float gamma = p / n;
+        float prior = ns->speech[k] / n;
+        float xi = DD_ALPHA * prior + (1.0f - DD_ALPHA) * (gamma > 1.0f ? gamma - 1.0f : 0.0f);
+        float g = xi / (1.0f + xi);
+        g = g < ns->gain_floor ? ns->gain_floor : g;
+        ns->speech[k] = g * g * p;
+        gain_sum += g;
+
+        work[2 * k] = re * g;
+        work[2 * k + 1] = im * g;
+    }
+
+    audio_fft_real_inverse(&ns->fft, work);
+
+    //前半帧与上一帧的后半帧相加得到完整的一个帧移，后半帧留给下一帧
+    for (size_t i = 0; i < AUDIO_NS_HOP; i++) {
+        float out = (work[i] * ns->window[i] + ns->overlap[i]) * 32768.0f;
+        ns->overlap[i] = work[AUDIO_NS_HOP + i] * ns->window[AUDIO_NS_HOP + i];
+        out = out > 32767.0f ? 32767.0f : (out < -32768.0f ? -32768.0f : out);
+        ns->out_fifo[(ns->out_read + ns->out_count++) % ns->out_cap] = (int16_t)lrintf(out);
+    }
+
+    //单边谱功率和折算成每样本功率：sum|X|^2 ≈ N * sum(x^2 * w^2) / 2，窗的平方均值为0.5
+    ns->stats.noise_db = 10.0f * log10f(4.0f * noise_sum / ((float)AUDIO_NS_FFT * AUDIO_NS_FFT) + 1e-12f);
+    ns->stats.gain_db = 20.0f * log10f(gain_sum / AUDIO_NS_BINS);
+    ns->stats.blocks++;
+}
+
+//原地降噪一帧，输出比输入晚2 * AUDIO_NS_HOP个样本
+void audio_ns_process(audio_ns_t *ns, int16_t *samples, size_t count)
+{
+    uint32_t start = esp_cpu_get_cycle_count();
+    int blocks = 0;
+    size_t done = 0;
+
+    while (done < count) {
+        size_t m = AUDIO_NS_HOP - ns->block_fill;
+        m = m < count - done ? m : count - done;
+        memcpy(ns->history + AUDIO_NS_HOP + ns->block_fill, samples + done, m * sizeof(int16_t));
+        ns->block_fill += m;
+        done += m;
+
+        if (ns->block_fill == AUDIO_NS_HOP) {
+            ns_block(ns);
+            blocks++;
+            memmove(ns->history, ns->history + AUDIO_NS_HOP, AUDIO_NS_HOP * sizeof(int16_t));
+            ns->block_fill = 0;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = ns->out_fifo[ns->out_read];
+        ns->out_read = (ns->out_read + 1) % ns->out_cap;
+    }
+    ns->out_count -= count;
+
+    if (blocks > 0) {
+        ns->stats.cycles = (esp_cpu_get_cycle_count() - start) / blocks;
+        if (ns->stats.cycles > ns->stats.cycles_max) {
+            ns->stats.cycles_max = ns->stats.cycles;
+        }
+        ns->stats.cycles_per_10ms = (uint32_t)((uint64_t)ns->stats.cycles * ns->sample_rate / (100 * AUDIO_NS_HOP));
+    }
+}
+
+//获取统计
+void audio_ns_get_stats(audio_ns_t *ns, audio_ns_stats_t *stats)
+{
+    *stats = ns->stats;
+}
@@ -0,0 +1,54 @@
+#ifndef __AUDIO_NS_H_
+#define __AUDIO_NS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "audio_fft.h"
+
+//分析帧长与帧移（样本数），50%重叠，16kHz时帧移8ms，也是降噪引入的固定延迟的一半
+#define AUDIO_NS_FFT  256
+#define AUDIO_NS_HOP  (AUDIO_NS_FFT / 2)
+#define AUDIO_NS_BINS (AUDIO_NS_FFT / 2 + 1)
+
+//降噪统计
+typedef struct {
+    uint32_t blocks;            //处理的帧移数
+    float noise_db;             //估计的噪声功率（dBFS，全频带）
+    float gain_db;              //最近一帧的平均增益
+    uint32_t cycles;            //最近一个帧移的耗时（CPU周期）
+    uint32_t cycles_max;        //单个帧移耗时的最大值
+    uint32_t cycles_per_10ms;   //折算到每10ms音频的耗时
+} audio_ns_stats_t;
+
+//频域维纳滤波降噪，16位单声道
+//sqrt-Hann窗加权重叠相加，噪声谱按频点跟踪最小值（下降快、上升慢），增益用判决引导的先验信噪比
+typedef struct {
+    uint32_t sample_rate;
+    float gain_floor;           //最小增益，即最大衰减
+    audio_fft_real_t fft;
+
+    //全部在初始化时分配
+    float *window;              //AUDIO_NS_FFT点sqrt-Hann窗
+    float *work;                //FFT工作区，AUDIO_NS_FFT + 2个float
+    float *noise;               //每个频点的噪声功率
+    float *power;               //每个频点的平滑功率，用于跟踪噪声
+    float *speech;              //上一帧每个频点的语音功率估计，用于判决引导
+    float *overlap;             //上一帧逆变换的后半段，等待和下一帧相加
+
+    //输入攒满一个帧移处理一次，输出比输入晚一个帧移再加上重叠的半帧
+    int16_t history[AUDIO_NS_FFT];
+    size_t block_fill;
+    int16_t *out_fifo;
+    size_t out_cap;
+    size_t out_read;
+    size_t out_count;
+
+    audio_ns_stats_t stats;
+} audio_ns_t;
+
+esp_err_t audio_ns_init(audio_ns_t *ns, uint32_t sample_rate, uint32_t max_atten_db, size_t max_frame);
+void audio_ns_deinit(audio_ns_t *ns);
+void audio_ns_process(audio_ns_t *ns, int16_t *samples, size_t count);
+void audio_ns_get_stats(audio_ns_t *ns, audio_ns_stats_t *stats);
+
+#endif
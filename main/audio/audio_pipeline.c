@@ -0,0 +1,431 @@
+#include "audio_pipeline.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include "Mic_driver.h"
+#include "Speaker_driver.h"
+#include "audio_chain.h"
+#include "audio_trace.h"
+#include "audio_ring.h"
+
+#define TAG "PIPELINE"
+
+// 采集任务
+#define CAPTURE_TASK_DEPTH 4096 // 任务栈深
+#define CAPTURE_TASK_PRI   CONFIG_AUDIO_TASK_PRIORITY // 任务优先级
+
+// 播放任务，比采集低一级
+#define PLAYBACK_TASK_DEPTH 4096 // 任务栈深
+#define PLAYBACK_TASK_PRI   (CONFIG_AUDIO_TASK_PRIORITY - 1) // 任务优先级
+
+// 控制任务，替其他任务执行会阻塞的切换操作
+#define CONTROL_TASK_DEPTH 3072 // 任务栈深
+#define CONTROL_TASK_PRI   5 // 任务优先级
+
+//DMA配置档位，延迟 ≈ 一个RX DMA缓冲 + 处理 + 整个TX DMA队列
+static const audio_dma_profile_t profiles[AUDIO_DMA_PROFILE_NUM] = {
+    [AUDIO_DMA_PROFILE_LOW_LATENCY] = { "low_latency", 128, 8 },
+    [AUDIO_DMA_PROFILE_BALANCED] = { "balanced", 511, 6 },
+    [AUDIO_DMA_PROFILE_LOW_POWER] = { "low_power", I2S_DMA_FRAME_MAX, 3 },
+};
+_Static_assert(511 <= I2S_DMA_FRAME_MAX, "balanced profile exceeds the DMA buffer limit");
+
+static const audio_dma_profile_t *profile = &profiles[AUDIO_DMA_PROFILE_DEFAULT];
+
+//切换档位时采集和播放任务停在各自循环的开头，切换方重建I2S通道后再放行
+//两个任务的阻塞点都有超时，一定会在有限时间内回到循环开头
+static volatile bool reconfig_pending = false;
+static SemaphoreHandle_t reconfig_lock = NULL;
+static SemaphoreHandle_t parked_sem = NULL;
+static SemaphoreHandle_t resume_sem = NULL;
+static int running_tasks = 0;
+//待切换的档位，只保留最新的一个请求
+static QueueHandle_t profile_queue = NULL;
+
+//采集任务到播放任务的帧环，槽里是audio_frame_t，data指向各自固定的DMA缓冲，帧数据不拷贝
+static audio_ring_t frame_ring;
+//环满或者帧不交给播放任务时，采集读到这一帧里
+static audio_frame_t spare_frame;
+static audio_pipeline_stats_t stats;
+
+//播放数据源，为NULL时回环播放采集到的帧
+static audio_playback_source_t playback_source = NULL;
+static void *playback_source_ctx = NULL;
+static uint8_t *playback_buf = NULL;
+
+//播放旁路：每次写入TX后把写出的数据和估计的播放时刻交给它，用作回声消除的参考
+static audio_playback_tap_t playback_tap = NULL;
+static void *playback_tap_ctx = NULL;
+
+//一个DMA缓冲的时长（毫秒），rx按MIC_SAMPLE_RATE，tx按STREAM_SAMPLE_RATE
+static uint32_t frame_period_ms(uint32_t sample_rate)
+{
+    return profile->frame_num * 1000 / sample_rate;
+}
+
+//超过两帧没有等到数据记为一次欠载
+static TickType_t underrun_timeout(uint32_t sample_rate)
+{
+    return pdMS_TO_TICKS(2 * frame_period_ms(sample_rate) + portTICK_PERIOD_MS);
+}
+
+//有切换请求时停下，等切换完成
+static void pipeline_park(void)
+{
+    xSemaphoreGive(parked_sem);
+    xSemaphoreTake(resume_sem, portMAX_DELAY);
+}
+
+//取一个可写的帧：回环播放时从帧环取空槽，环满说明播放跟不上，这一帧照常处理但不播放
+//生产者不能动消费者一侧的槽，所以丢的是最新的帧而不是最旧的待播放帧
+static audio_frame_t *acquire_frame(void)
+{
+    if (playback_source != NULL) {
+        return &spare_frame;
+    }
+
+    audio_frame_t *frame = audio_ring_reserve(&frame_ring);
+    if (frame == NULL) {
+        stats.dropped++;
+        ESP_LOGD(TAG, "播放跟不上，丢弃一帧，累计%lu", (unsigned long)stats.dropped);
+        return &spare_frame;
+    }
+    return frame;
+}
+
+//采集任务：由DMA接收完成中断唤醒，每次读出一个DMA缓冲，经过处理链后在帧环里提交给播放任务
+static void capture_task(void *param)
+{
+    ESP_LOGI(TAG, "采集任务开始");
+    mic_set_notify_task(xTaskGetCurrentTaskHandle());
+
+    while (1) {
+        if (reconfig_pending) {
+            pipeline_park();
+            //新通道的接收从这里重新计起
+            ulTaskNotifyTake(pdTRUE, 0);
+            mic_set_notify_task(xTaskGetCurrentTaskHandle());
+        }
+
+        int64_t timestamp_us = 0;
+        if (mic_wait(underrun_timeout(MIC_SAMPLE_RATE), &timestamp_us) != ESP_OK) {
+            ESP_LOGW(TAG, "等待DMA接收超时");
+            continue;
+        }
+        audio_trace_record(AUDIO_TRACE_WAKEUP, (uint32_t)(esp_timer_get_time() - timestamp_us));
+        uint32_t busy = esp_cpu_get_cycle_count();
+
+        audio_frame_t *frame = acquire_frame();
+        frame->timestamp_us = timestamp_us;
+        frame->sample_rate = MIC_SAMPLE_RATE;
+        frame->channels = AUDIO_CHANNELS;
+        frame->bits = AUDIO_BITS;
+
+        uint32_t start = audio_trace_begin();
+        esp_err_t ret = mic_read(frame->data, mic_frame_bytes(), &frame->size);
+        audio_trace_end(AUDIO_TRACE_CAPTURE, start);
+        if (ret != ESP_OK || frame->size == 0) {
+            ESP_LOGW(TAG, "Mic 读取失败了：%s", esp_err_to_name(ret));
+            continue;//没有提交，槽下次还会被取到
+        }
+
+        stats.captured++;
+        start = audio_trace_begin();
+        audio_chain_process(frame);
+        audio_trace_end(AUDIO_TRACE_PROCESS, start);
+
+        //有其他播放数据源时采集帧只走处理链，不提交
+        if (frame != &spare_frame) {
+            audio_ring_commit(&frame_ring);
+        }
+        stats.capture_cycles += esp_cpu_get_cycle_count() - busy;
+    }
+}
+
+//播放任务：从帧环取出待播放帧写入I2S，写完释放这个槽
+static void playback_task(void *param)
+{
+    ESP_LOGI(TAG, "播放任务开始");
+    while (1) {
+        if (reconfig_pending) {
+            pipeline_park();
+        }
+
+        //回环时帧按采集的节奏到达
+        audio_frame_t *frame = audio_ring_peek_wait(&frame_ring, underrun_timeout(MIC_SAMPLE_RATE));
+        if (frame == NULL) {
+            //TX通道开启了auto_clear，欠载期间DMA自动输出静音
+            stats.underrun++;
+            ESP_LOGD(TAG, "播放欠载，累计%lu", (unsigned long)stats.underrun);
+            continue;
+        }
+
+        int64_t write_us = esp_timer_get_time();
+        esp_err_t ret = spk_write(frame->data, frame->size);
+        audio_trace_record(AUDIO_TRACE_PLAYBACK, (uint32_t)(esp_timer_get_time() - write_us));
+        if (ret == ESP_OK) {
+            stats.played++;
+            if (playback_tap != NULL) {
+                playback_tap(playback_tap_ctx, frame->data, frame->size, spk_play_time_us(frame->size));
+            }
+
+            //之后还要经过TX DMA队列，那部分是固定的dma_desc_num帧
+            stats.latency_us = esp_timer_get_time() - frame->timestamp_us;
+            if (stats.latency_us > stats.latency_max_us) {
+                stats.latency_max_us = stats.latency_us;
+            }
+        }
+        audio_ring_release(&frame_ring);
+    }
+}
+
+//数据源播放任务：每轮从数据源取一帧写入I2S，spk_write阻塞在TX DMA上，由播放时钟控制节奏
+//数据源没有数据时等下一个TX DMA缓冲发送完成再取，同样跟着播放时钟
+static void source_playback_task(void *param)
+{
+    ESP_LOGI(TAG, "数据源播放任务开始");
+    spk_set_notify_task(xTaskGetCurrentTaskHandle());
+    while (1) {
+        if (reconfig_pending) {
+            pipeline_park();
+        }
+
+        //每次取一个TX DMA缓冲的数据
+        uint32_t busy = esp_cpu_get_cycle_count();
+        size_t size = playback_source(playback_source_ctx, playback_buf, spk_frame_bytes());
+        if (size == 0) {
+            //数据源没有数据，TX的auto_clear输出静音，等这一个静音缓冲播完再取
+            stats.underrun++;
+            spk_wait(underrun_timeout(STREAM_SAMPLE_RATE));
+            continue;
+        }
+        stats.playback_cycles += esp_cpu_get_cycle_count() - busy;
+
+        int64_t write_us = esp_timer_get_time();
+        esp_err_t ret = spk_write(playback_buf, size);
+        audio_trace_record(AUDIO_TRACE_PLAYBACK, (uint32_t)(esp_timer_get_time() - write_us));
+        if (ret == ESP_OK) {
+            stats.played++;
+            if (playback_tap != NULL) {
+                busy = esp_cpu_get_cycle_count();
+                playback_tap(playback_tap_ctx, playback_buf, size, spk_play_time_us(size));
+                stats.playback_cycles += esp_cpu_get_cycle_count() - busy;
+            }
+        }
+    }
+}
+
+//控制任务：取出切换请求并执行，重建I2S通道期间不占用发起请求的任务
+static void control_task(void *param)
+{
+    audio_dma_profile_id_t id;
+    while (1) {
+        xQueueReceive(profile_queue, &id, portMAX_DELAY);
+        esp_err_t ret = audio_pipeline_set_profile(id);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "切换DMA档位失败：%s", esp_err_to_name(ret));
+        }
+    }
+}
+
+//设置播放数据源，需要在audio_pipeline_start之前调用
+void audio_pipeline_set_playback_source(audio_playback_source_t source, void *ctx)
+{
+    playback_source = source;
+    playback_source_ctx = ctx;
+}
+
+//设置播放旁路，需要在audio_pipeline_start之前调用
+void audio_pipeline_set_playback_tap(audio_playback_tap_t tap, void *ctx)
+{
+    playback_tap = tap;
+    playback_tap_ctx = ctx;
+}
+
+//分配帧缓冲：每个帧环的槽和备用帧各有一个DMA缓冲
+esp_err_t audio_pipeline_init(void)
+{
+    reconfig_lock = xSemaphoreCreateMutex();
+    parked_sem = xSemaphoreCreateCounting(2, 0);
+    resume_sem = xSemaphoreCreateCounting(2, 0);
+    profile_queue = xQueueCreate(1, sizeof(audio_dma_profile_id_t));
+    if (reconfig_lock == NULL || parked_sem == NULL || resume_sem == NULL || profile_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(control_task, "audio control", CONTROL_TASK_DEPTH, NULL, CONTROL_TASK_PRI, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = audio_ring_init(&frame_ring, sizeof(audio_frame_t), AUDIO_FRAME_NUM, MALLOC_CAP_INTERNAL);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    for (int i = 0; i <= AUDIO_FRAME_NUM; i++) {
+        audio_frame_t *frame = i < AUDIO_FRAME_NUM ? audio_ring_slot(&frame_ring, i) : &spare_frame;
+        //放在内部RAM并且可被DMA访问，16字节对齐以便向量指令直接处理
+        frame->data = heap_caps_aligned_calloc(16, 1, BUF_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (frame->data == NULL) {
+            ESP_LOGE(TAG, "帧缓冲分配失败");
+            return ESP_ERR_NO_MEM;
+        }
+        frame->size = 0;
+    }
+
+    return ESP_OK;
+}
+
+//启动采集与播放任务
+esp_err_t audio_pipeline_start(void)
+{
+    if (xTaskCreatePinnedToCore(capture_task, "audio capture", CAPTURE_TASK_DEPTH, NULL, CAPTURE_TASK_PRI, NULL,
+                                AUDIO_TASK_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    running_tasks++;
+
+    if (playback_source != NULL) {
+        playback_buf = heap_caps_aligned_calloc(16, 1, BUF_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (playback_buf == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        if (xTaskCreatePinnedToCore(source_playback_task, "audio playback", PLAYBACK_TASK_DEPTH, NULL, PLAYBACK_TASK_PRI,
+                                    NULL, AUDIO_TASK_CORE) != pdPASS) {
+            return ESP_ERR_NO_MEM;
+        }
+    } else if (xTaskCreatePinnedToCore(playback_task, "audio playback", PLAYBACK_TASK_DEPTH, NULL, PLAYBACK_TASK_PRI,
+                                       NULL, AUDIO_TASK_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    running_tasks++;
+
+    return ESP_OK;
+}
+
+//按档位重建rx和tx通道，失败时退回原来的档位
+static esp_err_t pipeline_apply_profile(const audio_dma_profile_t *next)
+{
+    mic_set_notify_task(NULL);
+    i2s_rx_deinit();
+    i2s_tx_deinit();
+
+    esp_err_t ret = i2s_tx_init(next);
+    if (ret == ESP_OK) {
+        ret = i2s_rx_init(next);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "切换到%s失败：%s", next->name, esp_err_to_name(ret));
+        i2s_rx_deinit();
+        i2s_tx_deinit();
+        esp_err_t restore = i2s_tx_init(profile);
+        if (restore == ESP_OK) {
+            restore = i2s_rx_init(profile);
+        }
+        if (restore != ESP_OK) {
+            ESP_LOGE(TAG, "恢复到%s也失败了：%s", profile->name, esp_err_to_name(restore));
+        }
+        return ret;
+    }
+
+    profile = next;
+    return ESP_OK;
+}
+
+//切换DMA档位，rx和tx一起重建，运行中调用时采集和播放会中断几个DMA缓冲的时间
+//不能在采集或播放任务里调用
+esp_err_t audio_pipeline_set_profile(audio_dma_profile_id_t id)
+{
+    if (id < 0 || id >= AUDIO_DMA_PROFILE_NUM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (reconfig_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(reconfig_lock, portMAX_DELAY);
+    const audio_dma_profile_t *next = &profiles[id];
+    esp_err_t ret = ESP_OK;
+    if (next != profile) {
+        reconfig_pending = true;
+        for (int i = 0; i < running_tasks; i++) {
+            xSemaphoreTake(parked_sem, portMAX_DELAY);
+        }
+
+        ret = pipeline_apply_profile(next);
+
+        reconfig_pending = false;
+        for (int i = 0; i < running_tasks; i++) {
+            xSemaphoreGive(resume_sem);
+        }
+        ESP_LOGI(TAG, "DMA档位：%s，%lu帧x%lu个缓冲", profile->name, (unsigned long)profile->frame_num,
+                 (unsigned long)profile->desc_num);
+    }
+    xSemaphoreGive(reconfig_lock);
+
+    return ret;
+}
+
+//请求切换DMA档位，由控制任务异步执行，立即返回，结果看日志和stats里的profile
+//可以在事件回调等不能长时间阻塞的地方调用，连续请求时只执行最新的一个
+esp_err_t audio_pipeline_request_profile(audio_dma_profile_id_t id)
+{
+    if (id < 0 || id >= AUDIO_DMA_PROFILE_NUM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (profile_queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xQueueOverwrite(profile_queue, &id);
+    return ESP_OK;
+}
+
+//当前的DMA档位，初始化I2S通道前也可以调用
+const audio_dma_profile_t *audio_pipeline_get_profile(void)
+{
+    return profile;
+}
+
+//按名字查找档位，找不到返回-1
+int audio_pipeline_find_profile(const char *name, size_t len)
+{
+    for (int i = 0; i < AUDIO_DMA_PROFILE_NUM; i++) {
+        if (strlen(profiles[i].name) == len && memcmp(profiles[i].name, name, len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+//获取流水线统计
+void audio_pipeline_get_stats(audio_pipeline_stats_t *out)
+{
+    *out = stats;
+    mic_get_stats(&out->rx);
+    spk_get_stats(&out->tx);
+}
+
+//统计格式化成一行JSON，返回写入的长度（不含结尾的0），空间不够时截断
+//对比两次快照的计数差和uptime差即可得到单位时间的丢帧率
+int audio_pipeline_format_stats(char *buf, size_t size)
+{
+    audio_pipeline_stats_t s;
+    audio_pipeline_get_stats(&s);
+
+    int len = snprintf(buf, size,
+                       "{\"type\":\"stats\",\"uptime_us\":%lld,\"profile\":\"%s\",\"captured\":%lu,\"played\":%lu,\"dropped\":%lu,"
+                       "\"underrun\":%lu,\"latency_max_us\":%lld,"
+                       "\"rx\":{\"reads\":%lu,\"errors\":%lu,\"short\":%lu,\"short_bytes\":%lu,\"overflow\":%lu,\"overflow_last_us\":%lld},"
+                       "\"tx\":{\"writes\":%lu,\"errors\":%lu,\"short\":%lu,\"short_bytes\":%lu,\"underflow\":%lu,\"underflow_last_us\":%lld}}",
+                       (long long)esp_timer_get_time(), profile->name, (unsigned long)s.captured, (unsigned long)s.played,
+                       (unsigned long)s.dropped, (unsigned long)s.underrun, (long long)s.latency_max_us,
+                       (unsigned long)s.rx.reads, (unsigned long)s.rx.read_errors, (unsigned long)s.rx.short_reads,
+                       (unsigned long)s.rx.short_bytes, (unsigned long)s.rx.overflow, (long long)s.rx.overflow_last_us,
+                       (unsigned long)s.tx.writes, (unsigned long)s.tx.write_errors, (unsigned long)s.tx.short_writes,
+                       (unsigned long)s.tx.short_bytes, (unsigned long)s.tx.underflow, (long long)s.tx.underflow_last_us);
+
+    return len < (int)size ? len : (int)size - 1;
+}
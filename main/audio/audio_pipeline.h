@@ -0,0 +1,67 @@
+#ifndef __PIPELINE_H_
+#define __PIPELINE_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "Audio_common.h"
+#include "Mic_driver.h"
+#include "Speaker_driver.h"
+
+//任务布局：I2S采集、播放固定在AUDIO_TASK_CORE，网络收发和上行编码固定在另一个核（Wi-Fi所在的核）
+//两边只通过有界队列交换数据：上行发送队列满了丢最旧的帧，下行抖动缓冲满了丢最旧的包
+#if CONFIG_AUDIO_TASK_PINNING
+#define AUDIO_TASK_PINNED 1
+#define AUDIO_TASK_CORE CONFIG_AUDIO_TASK_CORE
+#define NET_TASK_CORE   (1 - CONFIG_AUDIO_TASK_CORE)
+#else
+#define AUDIO_TASK_PINNED 0
+#define AUDIO_TASK_CORE tskNO_AFFINITY
+#define NET_TASK_CORE   tskNO_AFFINITY
+#endif
+
+//帧缓冲个数，采集与播放之间流转的DMA缓冲总数
+#define AUDIO_FRAME_NUM CONFIG_AUDIO_FRAME_NUM
+
+//音频帧，只在任务之间传递指针，不拷贝数据
+typedef struct {
+    uint8_t *data;  //DMA缓冲区
+    size_t size;    //有效字节数
+    int64_t timestamp_us; //该帧DMA接收完成的时刻（esp_timer）
+    uint32_t sample_rate; //采样率
+    uint8_t channels;     //交织的声道数
+    uint8_t bits;         //每个样本的位数，16或32
+} audio_frame_t;
+
+//流水线统计
+typedef struct {
+    uint32_t captured;  //采集帧数
+    uint32_t played;    //播放帧数
+    uint32_t dropped;   //丢帧数：帧环满时新采集的帧不交给播放任务
+    uint32_t underrun;  //欠载数：播放任务在一帧时间内没有等到数据
+    int64_t latency_us;     //最近一帧从DMA接收完成到写入TX DMA的延迟
+    int64_t latency_max_us; //上述延迟的最大值
+    uint64_t capture_cycles;  //采集任务处理帧的累计周期数，不含等待DMA
+    uint64_t playback_cycles; //数据源播放任务取数据和旁路的累计周期数，不含写TX的阻塞
+    mic_stats_t rx;     //I2S接收的溢出和短读
+    spk_stats_t tx;     //I2S发送的播空和短写
+} audio_pipeline_stats_t;
+
+//播放数据源：向buf写入最多size字节，返回写入的字节数，返回0表示本轮没有数据
+typedef size_t (*audio_playback_source_t)(void *ctx, uint8_t *buf, size_t size);
+
+//播放旁路：buf为刚写入TX的size字节，play_us为其中第一个样本估计的播放时刻（esp_timer）
+typedef void (*audio_playback_tap_t)(void *ctx, const uint8_t *buf, size_t size, int64_t play_us);
+
+esp_err_t audio_pipeline_init(void);
+void audio_pipeline_set_playback_source(audio_playback_source_t source, void *ctx);
+void audio_pipeline_set_playback_tap(audio_playback_tap_t tap, void *ctx);
+esp_err_t audio_pipeline_start(void);
+esp_err_t audio_pipeline_set_profile(audio_dma_profile_id_t id);
+esp_err_t audio_pipeline_request_profile(audio_dma_profile_id_t id);
+const audio_dma_profile_t *audio_pipeline_get_profile(void);
+int audio_pipeline_find_profile(const char *name, size_t len);
+void audio_pipeline_get_stats(audio_pipeline_stats_t *stats);
+int audio_pipeline_format_stats(char *buf, size_t size);
+
+#endif
@@ -0,0 +1,138 @@
+#include "audio_process.h"
+#include "audio_simd.h"
+#include <math.h>
+
+//软件放大
+void amplify_audio_buffer(void* buffer, size_t bytes, float gain)
+{
+    // 假设是32位数据（24位数据存储在32位容器中）
+    int32_t* samples = (int32_t*)buffer;
+    size_t sample_count = bytes / sizeof(int32_t);
+    
+    for (size_t i = 0; i < sample_count; i++) {
+        // 应用增益，注意防止溢出
+        int64_t amplified = (int64_t)samples[i] * gain;
+        
+        // 限制在32位范围内
+        if (amplified > INT32_MAX) {
+            samples[i] = INT32_MAX;
+        } else if (amplified < INT32_MIN) {
+            samples[i] = INT32_MIN;
+        } else {
+            samples[i] = (int32_t)amplified;
+        }
+    }
+}
+
+//动态范围压缩
+void compress_audio_buffer(void* buffer, size_t bytes, float threshold, float ratio)
+{
+    int32_t* samples = (int32_t*)buffer;
+    size_t sample_count = bytes / sizeof(int32_t);
+    
+    for (size_t i = 0; i < sample_count; i++) {
+        float sample = (float)samples[i];
+        float abs_sample = fabsf(sample);
+        
+        if (abs_sample > threshold) {
+            // 超过阈值的部分按比例压缩
+            float excess = abs_sample - threshold;
+            float compressed_excess = excess / ratio;
+            float compressed_sample = threshold + compressed_excess;
+            
+            samples[i] = (int32_t)(copysignf(compressed_sample, sample));
+        }
+    }
+}
+
+//软件放大，定点版本：增益为Q7.24，乘积取高位后饱和到32位
+void amplify_audio_buffer_q31(void* buffer, size_t bytes, int32_t gain_q24)
+{
+    int32_t* samples = (int32_t*)buffer;
+    size_t sample_count = bytes / sizeof(int32_t);
+
+    for (size_t i = 0; i < sample_count; i++) {
+        //32x32位乘法在Xtensa上是mull+mulsh两条指令，不需要整数转浮点
+        int64_t amplified = ((int64_t)samples[i] * gain_q24) >> GAIN_Q_FRAC_BITS;
+
+        if (amplified > INT32_MAX) {
+            samples[i] = INT32_MAX;
+        } else if (amplified < INT32_MIN) {
+            samples[i] = INT32_MIN;
+        } else {
+            samples[i] = (int32_t)amplified;
+        }
+    }
+}
+
+//动态范围压缩，定点版本：超出阈值的部分乘以Q31格式的1/ratio
+void compress_audio_buffer_q31(void* buffer, size_t bytes, int32_t threshold, int32_t inv_ratio_q31)
+{
+    int32_t* samples = (int32_t*)buffer;
+    size_t sample_count = bytes / sizeof(int32_t);
+
+    for (size_t i = 0; i < sample_count; i++) {
+        int32_t sample = samples[i];
+        //用无符号数取绝对值，INT32_MIN也不会溢出
+        uint32_t abs_sample = sample < 0 ? 0u - (uint32_t)sample : (uint32_t)sample;
+
+        if (abs_sample > (uint32_t)threshold) {
+            uint32_t excess = abs_sample - (uint32_t)threshold;
+            uint32_t compressed_excess = (uint32_t)(((uint64_t)excess * (uint32_t)inv_ratio_q31) >> 31);
+            uint32_t compressed_sample = (uint32_t)threshold + compressed_excess;
+
+            if (sample < 0) {
+                samples[i] = (int32_t)(0 - (int64_t)compressed_sample);
+            } else {
+                samples[i] = compressed_sample > INT32_MAX ? INT32_MAX : (int32_t)compressed_sample;
+            }
+        }
+    }
+}
+
+//根据浮点参数重新计算定点参数，运行时修改gain等参数后调用
+void audio_processor_update(audio_processor_t* proc)
+{
+    //Q7.24能表示的范围有限，超出时饱和
+    float gain = proc->gain;
+    if (gain > 127.0f) {
+        gain = 127.0f;
+    } else if (gain < -127.0f) {
+        gain = -127.0f;
+    }
+    proc->gain_q24 = GAIN_TO_Q24(gain);
+
+    float threshold = proc->compression_threshold;
+    proc->compression_threshold_q31 = threshold >= 2147483647.0f ? INT32_MAX : (int32_t)threshold;
+
+    float ratio = proc->compression_ratio < 1.0f ? 1.0f : proc->compression_ratio;
+    proc->inv_ratio_q31 = INV_RATIO_TO_Q31(ratio);
+}
+
+//音频处理：启用AGC时由包络跟随的自动增益决定电平，否则使用固定增益，
+//use_fixed_point在运行时切换浮点与定点内核
+void process_audio_buffer(void* buffer, size_t bytes, audio_processor_t* proc)
+{
+    if (proc->enable_agc) {
+        audio_agc_process(&proc->agc, (int32_t*)buffer, bytes / sizeof(int32_t));
+        return;
+    }
+
+    if (proc->use_fixed_point) {
+        audio_gain_limit((int32_t*)buffer, bytes / sizeof(int32_t), proc->gain_q24, proc->limit);
+        return;
+    }
+
+    amplify_audio_buffer(buffer, bytes, proc->gain);
+}
+
+//音频处理，16位单声道版本：AGC或固定增益，都走定点内核
+void process_audio_buffer_s16(int16_t* samples, size_t count, audio_processor_t* proc)
+{
+    if (proc->enable_agc) {
+        audio_agc_process_s16(&proc->agc, samples, count);
+        return;
+    }
+
+    audio_gain_limit_s16(samples, count, proc->gain_q24);
+}
@@ -0,0 +1,36 @@
+#ifndef __AUDIO_PROCESS_H_
+#define __AUDIO_PROCESS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "audio_agc.h"
+
+//定点增益的小数位数，Q7.24可以表示±128倍
+#define GAIN_Q_FRAC_BITS 24
+#define GAIN_TO_Q24(g) ((int32_t)((g) * (float)(1 << GAIN_Q_FRAC_BITS)))
+//压缩比的倒数用Q31表示，比例不小于1时落在[0, 1]
+#define INV_RATIO_TO_Q31(r) ((int32_t)((1.0 / (r)) * 2147483647.0))
+
+typedef struct {
+    float gain;           // 增益倍数
+    float compression_threshold; // 压缩阈值
+    float compression_ratio;     // 压缩比例
+    bool enable_agc;      // 是否启用自动增益，启用时由agc代替静态压缩和固定增益
+    bool use_fixed_point; // 使用Q31定点内核，false时使用浮点内核
+    int32_t gain_q24;     // 定点增益，由audio_processor_update根据gain计算
+    int32_t compression_threshold_q31; // 定点压缩阈值
+    int32_t inv_ratio_q31;             // 定点压缩比例的倒数
+    int32_t limit;        // 定点路径放大后的硬限幅，正数
+    audio_agc_t agc;      // 自动增益状态
+} audio_processor_t;
+
+void amplify_audio_buffer(void* buffer, size_t bytes, float gain);
+void compress_audio_buffer(void* buffer, size_t bytes, float threshold, float ratio);
+void amplify_audio_buffer_q31(void* buffer, size_t bytes, int32_t gain_q24);
+void compress_audio_buffer_q31(void* buffer, size_t bytes, int32_t threshold, int32_t inv_ratio_q31);
+void audio_processor_update(audio_processor_t* proc);
+void process_audio_buffer(void* buffer, size_t bytes, audio_processor_t* proc);
+void process_audio_buffer_s16(int16_t* samples, size_t count, audio_processor_t* proc);
+
+#endif
@@ -0,0 +1,176 @@
+#include "audio_resampler.h"
+#include "esp_heap_caps.h"
+#include <math.h>
+#include <string.h>
+
+#define KAISER_BETA 7.0f //Kaiser窗参数，约70dB阻带衰减
+#define CUTOFF_SCALE 0.85f //截止频率相对于较低奈奎斯特频率的比例，留出过渡带
+
+static uint32_t gcd_u32(uint32_t a, uint32_t b)
+{
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+//零阶修正贝塞尔函数，级数展开
+static float bessel_i0(float x)
+{
+    float sum = 1.0f;
+    float term = 1.0f;
+    float half = x * 0.5f;
+
+    for (int k = 1; k < 32; k++) {
+        term *= (half / k) * (half / k);
+        sum += term;
+        if (term < sum * 1e-9f) {
+            break;
+        }
+    }
+    return sum;
+}
+
+//设计原型低通滤波器并拆成up组子滤波器，转成Q15
+static void resampler_design(audio_resampler_t *rs)
+{
+    const uint32_t length = rs->up * rs->taps;
+    const float center = (float)(length - 1) * 0.5f;
+    const float ratio = rs->up > rs->down ? 1.0f : (float)rs->up / (float)rs->down;
+    //截止频率，以插值后的采样率归一化（周期/样本）
+    const float fc = 0.5f * ratio * CUTOFF_SCALE / (float)rs->up;
+    const float i0_beta = bessel_i0(KAISER_BETA);
+
+    float max_sum = 0.0f;
+    for (uint32_t p = 0; p < rs->up; p++) {
+        float sum = 0.0f;
+        for (uint32_t k = 0; k < rs->taps; k++) {
+            float n = (float)(p + k * rs->up) - center;
+            float sinc = n == 0.0f ? 2.0f * fc : sinf(2.0f * (float)M_PI * fc * n) / ((float)M_PI * n);
+            float w = n / center;
+            float window = bessel_i0(KAISER_BETA * sqrtf(fmaxf(0.0f, 1.0f - w * w))) / i0_beta;
+            sum += fabsf(sinc * window * rs->up);
+        }
+        max_sum = fmaxf(max_sum, sum);
+    }
+
+    //点积用32位累加，保证每组系数绝对值之和小于2，累加不会溢出
+    float scale = max_sum >= 1.99f ? 1.99f / max_sum : 1.0f;
+
+    for (uint32_t p = 0; p < rs->up; p++) {
+        int16_t *h = rs->coeffs + p * rs->taps;
+        for (uint32_t k = 0; k < rs->taps; k++) {
+            float n = (float)(p + k * rs->up) - center;
+            float sinc = n == 0.0f ? 2.0f * fc : sinf(2.0f * (float)M_PI * fc * n) / ((float)M_PI * n);
+            float w = n / center;
+            float window = bessel_i0(KAISER_BETA * sqrtf(fmaxf(0.0f, 1.0f - w * w))) / i0_beta;
+            float value = sinc * window * rs->up * scale * 32768.0f;
+
+            value = fminf(fmaxf(value, -32768.0f), 32767.0f);
+            //倒序存放，点积时系数和输入都按地址递增访问
+            h[rs->taps - 1 - k] = (int16_t)lrintf(value);
+        }
+    }
+}
+
+//初始化重采样器，所有缓冲在这里一次分配，处理过程中不再分配内存
+esp_err_t audio_resampler_init(audio_resampler_t *rs, uint32_t in_rate, uint32_t out_rate, size_t max_in)
+{
+    if (in_rate == 0 || out_rate == 0 || max_in == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(rs, 0, sizeof(*rs));
+    uint32_t g = gcd_u32(in_rate, out_rate);
+    rs->in_rate = in_rate;
+    rs->out_rate = out_rate;
+    rs->up = out_rate / g;
+    rs->down = in_rate / g;
+    rs->taps = AUDIO_RESAMPLER_TAPS;
+    rs->max_in = max_in;
+
+    rs->coeffs = heap_caps_malloc(rs->up * rs->taps * sizeof(int16_t), MALLOC_CAP_INTERNAL);
+    rs->buf = heap_caps_malloc((rs->taps - 1 + max_in) * sizeof(int16_t), MALLOC_CAP_INTERNAL);
+    if (rs->coeffs == NULL || rs->buf == NULL) {
+        audio_resampler_deinit(rs);
+        return ESP_ERR_NO_MEM;
+    }
+
+    resampler_design(rs);
+    audio_resampler_reset(rs);
+
+    return ESP_OK;
+}
+
+void audio_resampler_deinit(audio_resampler_t *rs)
+{
+    heap_caps_free(rs->coeffs);
+    heap_caps_free(rs->buf);
+    rs->coeffs = NULL;
+    rs->buf = NULL;
+}
+
+//清空历史样本
+void audio_resampler_reset(audio_resampler_t *rs)
+{
+    memset(rs->buf, 0, (rs->taps - 1) * sizeof(int16_t));
+    rs->phase = 0;
+    rs->pos = rs->taps - 1;
+}
+
+//max_in个输入样本最多产生的输出样本数
+size_t audio_resampler_max_out(const audio_resampler_t *rs)
+{
+    return ((uint64_t)rs->max_in * rs->up + rs->down - 1) / rs->down + 1;
+}
+
+//处理一块输入，输出样本数写到produced。输入先拷进内部缓冲，所以out可以和in是同一块内存，
+//只要它能放下audio_resampler_max_out个样本
+//count超过max_in时不处理、不改状态，计入rejected并返回ESP_ERR_INVALID_SIZE：
+//分块处理在原地升采样时会覆盖还没读的输入，输出也放不进max_out
+esp_err_t audio_resampler_process(audio_resampler_t *rs, const int16_t *in, size_t count, int16_t *out,
+                                  size_t *produced)
+{
+    const uint32_t taps = rs->taps;
+    size_t n = 0;
+
+    *produced = 0;
+    if (count > rs->max_in) {
+        rs->rejected += count;
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(rs->buf + taps - 1, in, count * sizeof(int16_t));
+
+    const size_t end = taps - 1 + count;
+    size_t pos = rs->pos;
+    uint32_t phase = rs->phase;
+
+    while (pos < end) {
+        const int16_t *h = rs->coeffs + phase * taps;
+        const int16_t *x = rs->buf + pos - (taps - 1);
+        int32_t acc = 0;
+
+        for (uint32_t k = 0; k < taps; k++) {
+            acc += (int32_t)h[k] * x[k];
+        }
+
+        acc = (acc + (1 << 14)) >> 15;
+        acc = acc > INT16_MAX ? INT16_MAX : acc;
+        acc = acc < INT16_MIN ? INT16_MIN : acc;
+        out[n++] = (int16_t)acc;
+
+        phase += rs->down;
+        pos += phase / rs->up;
+        phase %= rs->up;
+    }
+
+    //保留最后taps-1个样本作为下一块的历史
+    memmove(rs->buf, rs->buf + count, (taps - 1) * sizeof(int16_t));
+    rs->pos = pos - count;
+    rs->phase = phase;
+
+    *produced = n;
+    return ESP_OK;
+}
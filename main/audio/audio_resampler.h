@@ -0,0 +1,33 @@
+#ifndef __AUDIO_RESAMPLER_H_
+#define __AUDIO_RESAMPLER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+//每相的抽头数，越多过渡带越窄、阻带衰减越大。44.1k转16k时系数占160 * 48 * 2 = 15KB
+#define AUDIO_RESAMPLER_TAPS 48
+
+//流式多相FIR重采样器，16位单声道
+typedef struct {
+    uint32_t in_rate;    //输入采样率
+    uint32_t out_rate;   //输出采样率
+    uint32_t up;         //插值倍数L = out_rate / gcd
+    uint32_t down;       //抽取倍数M = in_rate / gcd
+    uint32_t taps;       //每相抽头数
+    size_t max_in;       //每次最多输入的样本数
+    int16_t *coeffs;     //up组子滤波器，Q15，每组倒序连续存放
+    int16_t *buf;        //历史样本 + 本次输入
+    uint32_t phase;      //当前相位，0 ~ up-1
+    size_t pos;          //下一个输出对应的最新输入在buf中的位置
+    uint32_t rejected;   //超过max_in而没有处理的输入样本数
+} audio_resampler_t;
+
+esp_err_t audio_resampler_init(audio_resampler_t *rs, uint32_t in_rate, uint32_t out_rate, size_t max_in);
+void audio_resampler_deinit(audio_resampler_t *rs);
+void audio_resampler_reset(audio_resampler_t *rs);
+size_t audio_resampler_max_out(const audio_resampler_t *rs);
+esp_err_t audio_resampler_process(audio_resampler_t *rs, const int16_t *in, size_t count, int16_t *out,
+                                  size_t *produced);
+
+#endif
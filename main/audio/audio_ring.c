@@ -0,0 +1,157 @@
+#include "audio_ring.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+
+//读写位置在[0, 2*slot_num)里循环，head == tail为空，相差slot_num为满，槽数不必是2的幂
+static inline uint32_t ring_next(const audio_ring_t *ring, uint32_t pos)
+{
+    return pos + 1 == 2 * ring->slot_num ? 0 : pos + 1;
+}
+
+static inline uint32_t ring_used(const audio_ring_t *ring, uint32_t head, uint32_t tail)
+{
+    return head >= tail ? head - tail : head + 2 * ring->slot_num - tail;
+}
+
+static inline void *ring_at(const audio_ring_t *ring, uint32_t pos)
+{
+    uint32_t index = pos >= ring->slot_num ? pos - ring->slot_num : pos;
+    return ring->slots + (size_t)index * ring->slot_size;
+}
+
+//分配slot_num个槽，每个槽至少slot_size字节并按AUDIO_RING_ALIGN对齐，caps为heap_caps的内存能力
+esp_err_t audio_ring_init(audio_ring_t *ring, size_t slot_size, uint32_t slot_num, uint32_t caps)
+{
+    memset(ring, 0, sizeof(*ring));
+    if (slot_size == 0 || slot_num == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ring->slot_size = (slot_size + AUDIO_RING_ALIGN - 1) / AUDIO_RING_ALIGN * AUDIO_RING_ALIGN;
+    ring->slot_num = slot_num;
+    ring->slots = heap_caps_aligned_calloc(AUDIO_RING_ALIGN, slot_num, ring->slot_size, caps);
+    if (ring->slots == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->producer_wait, NULL);
+    atomic_init(&ring->consumer_wait, NULL);
+    return ESP_OK;
+}
+
+void audio_ring_deinit(audio_ring_t *ring)
+{
+    heap_caps_free(ring->slots);
+    ring->slots = NULL;
+}
+
+//按下标直接访问槽，只用于初始化时在每个槽里放好固定的内容
+void *audio_ring_slot(audio_ring_t *ring, uint32_t index)
+{
+    return ring->slots + (size_t)index * ring->slot_size;
+}
+
+//已提交未释放的槽数，另一侧同时在操作时只是近似值
+uint32_t audio_ring_count(audio_ring_t *ring)
+{
+    return ring_used(ring, atomic_load_explicit(&ring->head, memory_order_acquire),
+                     atomic_load_explicit(&ring->tail, memory_order_acquire));
+}
+
+//生产者：取下一个空槽，满时返回NULL。提交前可以重复调用，返回的是同一个槽
+void *audio_ring_reserve(audio_ring_t *ring)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    //acquire：消费者释放之前对这个槽的读已经完成
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (ring_used(ring, head, tail) == ring->slot_num) {
+        return NULL;
+    }
+    return ring_at(ring, head);
+}
+
+//先登记等待者再检查一次条件，和另一侧的“先更新位置再看等待者”配对，通知不会丢
+//两侧都是先写后读不同的变量，中间需要全屏障
+static void *ring_wait(audio_ring_t *ring, _Atomic(TaskHandle_t) *waiter, void *(*poll)(audio_ring_t *),
+                       TickType_t timeout)
+{
+    TickType_t start = xTaskGetTickCount();
+
+    while (1) {
+        void *slot = poll(ring);
+        if (slot != NULL) {
+            return slot;
+        }
+
+        atomic_store_explicit(waiter, xTaskGetCurrentTaskHandle(), memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        slot = poll(ring);
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (slot == NULL && elapsed < timeout) {
+            ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+        }
+        atomic_store_explicit(waiter, NULL, memory_order_relaxed);
+
+        if (slot != NULL) {
+            return slot;
+        }
+        if (xTaskGetTickCount() - start >= timeout) {
+            return poll(ring);
+        }
+    }
+}
+
+//生产者：同audio_ring_reserve，满时最多等timeout
+void *audio_ring_reserve_wait(audio_ring_t *ring, TickType_t timeout)
+{
+    return ring_wait(ring, &ring->producer_wait, audio_ring_reserve, timeout);
+}
+
+//生产者：提交audio_ring_reserve取到的槽，唤醒等数据的消费者
+void audio_ring_commit(audio_ring_t *ring)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    //release：槽里的数据先于新的head对消费者可见
+    atomic_store_explicit(&ring->head, ring_next(ring, head), memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    TaskHandle_t waiter = atomic_load_explicit(&ring->consumer_wait, memory_order_relaxed);
+    if (waiter != NULL) {
+        xTaskNotifyGive(waiter);
+    }
+}
+
+//消费者：取最旧的已提交槽，空时返回NULL。释放前可以重复调用，返回的是同一个槽
+void *audio_ring_peek(audio_ring_t *ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    //acquire：生产者提交之前写入槽的数据已经可见
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail) {
+        return NULL;
+    }
+    return ring_at(ring, tail);
+}
+
+//消费者：同audio_ring_peek，空时最多等timeout
+void *audio_ring_peek_wait(audio_ring_t *ring, TickType_t timeout)
+{
+    return ring_wait(ring, &ring->consumer_wait, audio_ring_peek, timeout);
+}
+
+//消费者：释放audio_ring_peek取到的槽，唤醒等空槽的生产者
+void audio_ring_release(audio_ring_t *ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, ring_next(ring, tail), memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    TaskHandle_t waiter = atomic_load_explicit(&ring->producer_wait, memory_order_relaxed);
+    if (waiter != NULL) {
+        xTaskNotifyGive(waiter);
+    }
+}
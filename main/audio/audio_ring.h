@@ -0,0 +1,46 @@
+#ifndef __AUDIO_RING_H_
+#define __AUDIO_RING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+
+//缓存行对齐：生产者和消费者各自写的字段放在不同的行里，两个核不会来回抢同一行
+#define AUDIO_RING_ALIGN 64
+
+//单生产者单消费者的定长槽环形缓冲，槽就地读写不拷贝
+//生产者：audio_ring_reserve取空槽，写完audio_ring_commit；消费者：audio_ring_peek取最旧的槽，用完audio_ring_release
+//只有一个任务调用生产者一侧、一个任务调用消费者一侧时不需要锁，不能在中断里调用
+//*_wait版本用任务通知阻塞，调用的任务不能同时把默认的任务通知用在别处
+typedef struct {
+    //生产者写
+    _Atomic uint32_t head __attribute__((aligned(AUDIO_RING_ALIGN))); //下一个要写的位置，取值[0, 2*slot_num)
+    _Atomic(TaskHandle_t) producer_wait; //等空槽的生产者
+
+    //消费者写
+    _Atomic uint32_t tail __attribute__((aligned(AUDIO_RING_ALIGN))); //下一个要读的位置
+    _Atomic(TaskHandle_t) consumer_wait; //等数据的消费者
+
+    //初始化后只读
+    uint8_t *slots __attribute__((aligned(AUDIO_RING_ALIGN)));
+    size_t slot_size;   //按AUDIO_RING_ALIGN向上取整
+    uint32_t slot_num;
+} audio_ring_t;
+
+esp_err_t audio_ring_init(audio_ring_t *ring, size_t slot_size, uint32_t slot_num, uint32_t caps);
+void audio_ring_deinit(audio_ring_t *ring);
+void *audio_ring_slot(audio_ring_t *ring, uint32_t index);
+uint32_t audio_ring_count(audio_ring_t *ring);
+
+void *audio_ring_reserve(audio_ring_t *ring);
+void *audio_ring_reserve_wait(audio_ring_t *ring, TickType_t timeout);
+void audio_ring_commit(audio_ring_t *ring);
+
+void *audio_ring_peek(audio_ring_t *ring);
+void *audio_ring_peek_wait(audio_ring_t *ring, TickType_t timeout);
+void audio_ring_release(audio_ring_t *ring);
+
+#endif
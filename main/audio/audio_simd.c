@@ -0,0 +1,115 @@
+#include "audio_simd.h"
+#include "audio_process.h"
+
+//标量增益加限幅
+void audio_gain_limit_scalar(int32_t *restrict samples, size_t count, int32_t gain_q24, int32_t limit)
+{
+    const int64_t upper = limit;
+    const int64_t lower = -(int64_t)limit;
+
+    for (size_t i = 0; i < count; i++) {
+        int64_t value = ((int64_t)samples[i] * gain_q24) >> GAIN_Q_FRAC_BITS;
+
+        value = value > upper ? upper : value;
+        value = value < lower ? lower : value;
+        samples[i] = (int32_t)value;
+    }
+}
+
+//增益加限幅，构建时根据目标选择内核
+void audio_gain_limit(int32_t *samples, size_t count, int32_t gain_q24, int32_t limit)
+{
+#if CONFIG_AUDIO_SIMD_PIE
+    //PIE没有32位乘法，整数增益用饱和加法做移位累加，结果与标量版本逐位一致
+    const uint32_t frac_mask = (1u << GAIN_Q_FRAC_BITS) - 1;
+    bool aligned = ((uintptr_t)samples & 0xF) == 0;
+
+    if (aligned && gain_q24 > 0 && ((uint32_t)gain_q24 & frac_mask) == 0) {
+        const int32_t limits[2] = { limit, -limit };
+        size_t vec_count = count & ~(size_t)(AUDIO_SIMD_LANES - 1);
+
+        audio_gain_limit_pie(samples, vec_count, (uint32_t)gain_q24 >> GAIN_Q_FRAC_BITS, limits);
+        samples += vec_count;
+        count -= vec_count;
+    }
+#endif
+
+    audio_gain_limit_scalar(samples, count, gain_q24, limit);
+}
+
+//16位增益加饱和，标量
+void audio_gain_limit_s16_scalar(int16_t *restrict samples, size_t count, int32_t gain_q24)
+{
+    for (size_t i = 0; i < count; i++) {
+        int32_t value = (int32_t)(((int64_t)samples[i] * gain_q24) >> GAIN_Q_FRAC_BITS);
+
+        value = value > INT16_MAX ? INT16_MAX : value;
+        value = value < INT16_MIN ? INT16_MIN : value;
+        samples[i] = (int16_t)value;
+    }
+}
+
+#if CONFIG_AUDIO_SIMD_PIE
+//把Q24增益写成 gain / 2^shift，gain为16位整数，shift取0~15，写不成时返回false
+//只要Q24的低24-shift位全为0，(x * gain_q24) >> 24 就等于 (x * gain) >> shift
+static bool gain_to_s16(int32_t gain_q24, int16_t *gain, uint32_t *shift)
+{
+    for (int s = 15; s >= 0; s--) {
+        int drop = GAIN_Q_FRAC_BITS - s;
+        if ((gain_q24 & ((1 << drop) - 1)) != 0) {
+            continue;
+        }
+        int32_t g = gain_q24 >> drop;
+        if (g >= INT16_MIN && g <= INT16_MAX) {
+            *gain = (int16_t)g;
+            *shift = (uint32_t)s;
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+//16位增益加饱和，构建时根据目标选择内核
+void audio_gain_limit_s16(int16_t *samples, size_t count, int32_t gain_q24)
+{
+#if CONFIG_AUDIO_SIMD_PIE
+    int16_t gain;
+    uint32_t shift;
+    bool aligned = ((uintptr_t)samples & 0xF) == 0;
+
+    if (aligned && gain_to_s16(gain_q24, &gain, &shift)) {
+        size_t vec_count = count & ~(size_t)(AUDIO_SIMD_LANES_S16 - 1);
+
+        audio_gain_limit_s16_pie(samples, vec_count, &gain, shift);
+        samples += vec_count;
+        count -= vec_count;
+    }
+#endif
+
+    audio_gain_limit_s16_scalar(samples, count, gain_q24);
+}
+
+//声道提取：每次处理4帧，写位置始终落后于读位置，原地提取是安全的
+void audio_extract_mono_s16(const int32_t *in, int16_t *out, size_t frames, int channel)
+{
+    const int32_t *src = in + channel;
+    size_t i = 0;
+
+    for (; i + 4 <= frames; i += 4) {
+        int32_t s0 = src[0];
+        int32_t s1 = src[2];
+        int32_t s2 = src[4];
+        int32_t s3 = src[6];
+
+        out[i] = (int16_t)(s0 >> 16);
+        out[i + 1] = (int16_t)(s1 >> 16);
+        out[i + 2] = (int16_t)(s2 >> 16);
+        out[i + 3] = (int16_t)(s3 >> 16);
+        src += 8;
+    }
+    for (; i < frames; i++) {
+        out[i] = (int16_t)(src[0] >> 16);
+        src += 2;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef __AUDIO_SIMD_H_
+#define __AUDIO_SIMD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+//向量指令一次处理的样本数（128位 / 32位）
+#define AUDIO_SIMD_LANES 4
+//16位样本一次处理的样本数（128位 / 16位）
+#define AUDIO_SIMD_LANES_S16 8
+
+//增益加硬限幅：samples = clamp((samples * gain_q24) >> 24, -limit, limit)
+//ESP32-S3上整数增益且缓冲16字节对齐时走PIE向量内核，其余情况走标量内核
+void audio_gain_limit(int32_t *samples, size_t count, int32_t gain_q24, int32_t limit);
+
+//可移植的标量版本，写成无分支形式便于编译器自动向量化，同时作为参考实现
+void audio_gain_limit_scalar(int32_t *samples, size_t count, int32_t gain_q24, int32_t limit);
+
+//16位版本的增益加饱和
+//ESP32-S3上增益能写成16位整数除以2的幂（包括2.5、0.75这样的小数增益）且缓冲16字节对齐时走PIE向量内核
+void audio_gain_limit_s16(int16_t *samples, size_t count, int32_t gain_q24);
+
+//16位版本的标量内核，作为参考实现
+void audio_gain_limit_s16_scalar(int16_t *samples, size_t count, int32_t gain_q24);
+
+//从交织的32位双声道数据中取出一个声道并截成16位，允许out与in指向同一缓冲区
+void audio_extract_mono_s16(const int32_t *in, int16_t *out, size_t frames, int channel);
+
+#if CONFIG_AUDIO_SIMD_PIE
+//PIE汇编内核：samples 16字节对齐，count为4的倍数，gain为正整数，limits[0]上限、limits[1]下限
+void audio_gain_limit_pie(int32_t *samples, size_t count, uint32_t gain, const int32_t *limits);
+//PIE 16位内核：samples 16字节对齐，count为8的倍数，乘积为(x * *gain) >> shift，饱和到16位
+void audio_gain_limit_s16_pie(int16_t *samples, size_t count, const int16_t *gain, uint32_t shift);
+#endif
+
+#endif
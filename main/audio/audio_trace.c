@@ -0,0 +1,196 @@
+#include "audio_trace.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TRACE_DUMP_SIZE 1280
+
+static const char *const point_names[AUDIO_TRACE_POINT_NUM] = {
+    [AUDIO_TRACE_WAKEUP] = "wakeup",
+    [AUDIO_TRACE_CAPTURE] = "capture",
+    [AUDIO_TRACE_PROCESS] = "process",
+    [AUDIO_TRACE_QUEUE] = "queue",
+    [AUDIO_TRACE_ENCODE] = "encode",
+    [AUDIO_TRACE_SEND] = "send",
+    [AUDIO_TRACE_UPLINK] = "uplink",
+    [AUDIO_TRACE_RECEIVE] = "receive",
+    [AUDIO_TRACE_DECODE] = "decode",
+    [AUDIO_TRACE_PLAYBACK] = "playback",
+};
+
+static const char *const point_units[AUDIO_TRACE_POINT_NUM] = {
+    [AUDIO_TRACE_WAKEUP] = "us",
+    [AUDIO_TRACE_CAPTURE] = "cycles",
+    [AUDIO_TRACE_PROCESS] = "cycles",
+    [AUDIO_TRACE_QUEUE] = "us",
+    [AUDIO_TRACE_ENCODE] = "cycles",
+    [AUDIO_TRACE_SEND] = "us",
+    [AUDIO_TRACE_UPLINK] = "us",
+    [AUDIO_TRACE_RECEIVE] = "cycles",
+    [AUDIO_TRACE_DECODE] = "cycles",
+    [AUDIO_TRACE_PLAYBACK] = "us",
+};
+
+#if CONFIG_AUDIO_TRACE
+typedef struct {
+    uint32_t count;
+    uint32_t max;
+    uint32_t bucket[AUDIO_TRACE_BUCKETS];
+} trace_hist_t;
+
+//每个核一份，只由本核上的任务写，不需要锁也不需要原子操作
+//同一核上两个任务记录同一个点时可能被抢占而丢掉一次计数，对统计没有影响
+static trace_hist_t hists[portNUM_PROCESSORS][AUDIO_TRACE_POINT_NUM];
+
+//值到桶：0~7直接对应，之后按最高位所在的2的幂分组，每组再按次高两位分4个桶
+static inline uint32_t trace_bucket(uint32_t value)
+{
+    if (value < 8) {
+        return value;
+    }
+    uint32_t msb = 31 - __builtin_clz(value);
+    return 8 + (msb - 3) * 4 + ((value >> (msb - 2)) & 3);
+}
+
+//桶的上沿
+static uint32_t trace_bucket_upper(uint32_t index)
+{
+    if (index < 8) {
+        return index;
+    }
+    uint32_t msb = (index - 8) / 4 + 3;
+    uint32_t sub = (index - 8) % 4;
+    return (uint32_t)((((uint64_t)(4 + sub + 1)) << (msb - 2)) - 1);
+}
+
+//记录一次测量，任何任务都可以调用，不能在中断里调用
+void audio_trace_record(audio_trace_point_t point, uint32_t value)
+{
+    trace_hist_t *h = &hists[esp_cpu_get_core_id()][point];
+
+    h->bucket[trace_bucket(value)]++;
+    h->count++;
+    if (value > h->max) {
+        h->max = value;
+    }
+}
+
+//合并各核的直方图，返回第rank个值（从1开始）所在桶的上沿
+static uint32_t trace_rank(const uint32_t *bucket, uint32_t rank)
+{
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < AUDIO_TRACE_BUCKETS; i++) {
+        seen += bucket[i];
+        if (seen >= rank) {
+            return trace_bucket_upper(i);
+        }
+    }
+    return 0;
+}
+#endif
+
+//各测量点的p50/p99/max，读的同时可能有任务在写，结果是近似的快照
+int audio_trace_snapshot(audio_trace_summary_t *out, int max)
+{
+#if CONFIG_AUDIO_TRACE
+    int count = max < AUDIO_TRACE_POINT_NUM ? max : AUDIO_TRACE_POINT_NUM;
+    uint32_t bucket[AUDIO_TRACE_BUCKETS];
+
+    for (int p = 0; p < count; p++) {
+        audio_trace_summary_t *s = &out[p];
+        memset(s, 0, sizeof(*s));
+        memset(bucket, 0, sizeof(bucket));
+        s->name = point_names[p];
+        s->unit = point_units[p];
+
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            const trace_hist_t *h = &hists[core][p];
+            for (int i = 0; i < AUDIO_TRACE_BUCKETS; i++) {
+                bucket[i] += h->bucket[i];
+            }
+            s->max = h->max > s->max ? h->max : s->max;
+        }
+        for (int i = 0; i < AUDIO_TRACE_BUCKETS; i++) {
+            s->count += bucket[i];
+        }
+
+        if (s->count > 0) {
+            s->p50 = trace_rank(bucket, (s->count + 1) / 2);
+            s->p99 = trace_rank(bucket, s->count - s->count / 100);
+            //桶上沿可能超过实际最大值
+            s->p50 = s->p50 < s->max ? s->p50 : s->max;
+            s->p99 = s->p99 < s->max ? s->p99 : s->max;
+        }
+    }
+    return count;
+#else
+    return 0;
+#endif
+}
+
+//快照格式化成一行JSON，返回写入的长度（不含结尾的0），空间不够时截断
+int audio_trace_format(char *buf, size_t size)
+{
+    audio_trace_summary_t summary[AUDIO_TRACE_POINT_NUM];
+    int count = audio_trace_snapshot(summary, AUDIO_TRACE_POINT_NUM);
+    size_t len = 0;
+
+    len += snprintf(buf + len, size > len ? size - len : 0, "{\"type\":\"trace\",\"uptime_us\":%lld,\"points\":[",
+                    (long long)esp_timer_get_time());
+    for (int p = 0; p < count; p++) {
+        const audio_trace_summary_t *s = &summary[p];
+        len += snprintf(buf + len, size > len ? size - len : 0,
+                        "%s{\"name\":\"%s\",\"unit\":\"%s\",\"n\":%lu,\"p50\":%lu,\"p99\":%lu,\"max\":%lu}",
+                        p == 0 ? "" : ",", s->name, s->unit, (unsigned long)s->count, (unsigned long)s->p50,
+                        (unsigned long)s->p99, (unsigned long)s->max);
+    }
+    len += snprintf(buf + len, size > len ? size - len : 0, "]}");
+
+    return len < size ? (int)len : (int)size - 1;
+}
+
+//直接打印到控制台UART，不经过日志系统，日志级别调低时也能看到
+void audio_trace_dump(void)
+{
+    static char text[TRACE_DUMP_SIZE];
+
+    audio_trace_format(text, sizeof(text));
+    printf("%s\n", text);
+}
+
+static void trace_dump_cb(void *arg)
+{
+    audio_trace_dump();
+}
+
+//每隔interval_ms在esp_timer任务里打印一次快照
+esp_err_t audio_trace_start_dump(uint32_t interval_ms)
+{
+#if CONFIG_AUDIO_TRACE
+    static esp_timer_handle_t timer = NULL;
+    if (timer != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const esp_timer_create_args_t args = {
+        .callback = trace_dump_cb,
+        .name = "audio_trace",
+    };
+    esp_err_t ret = esp_timer_create(&args, &timer);
+    if (ret == ESP_OK) {
+        ret = esp_timer_start_periodic(timer, (uint64_t)interval_ms * 1000);
+    }
+    return ret;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+//清空所有直方图，和写入并发时可能残留少量计数
+void audio_trace_reset(void)
+{
+#if CONFIG_AUDIO_TRACE
+    memset(hists, 0, sizeof(hists));
+#endif
+}
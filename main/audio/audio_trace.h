@@ -0,0 +1,64 @@
+#ifndef __AUDIO_TRACE_H_
+#define __AUDIO_TRACE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#include "esp_cpu.h"
+
+//热路径上的测量点，CPU耗时用周期数，包含等待的用微秒
+//延迟突增时看是哪一类变大：DSP（process/encode/decode）、Wi-Fi（send）、调度（wakeup/queue）
+typedef enum {
+    AUDIO_TRACE_WAKEUP,     //DMA接收完成到采集任务开始读数据，微秒
+    AUDIO_TRACE_CAPTURE,    //从DMA缓冲读出一帧，周期
+    AUDIO_TRACE_PROCESS,    //整条处理链，周期
+    AUDIO_TRACE_QUEUE,      //帧进上行队列到发送任务取出，微秒
+    AUDIO_TRACE_ENCODE,     //上行编码一包，周期
+    AUDIO_TRACE_SEND,       //WebSocket发送一包，含TCP阻塞，微秒
+    AUDIO_TRACE_UPLINK,     //DMA接收完成到这一帧发送完成，微秒
+    AUDIO_TRACE_RECEIVE,    //下行一条消息的校验和入抖动缓冲，周期
+    AUDIO_TRACE_DECODE,     //从抖动缓冲取一帧并解码或补偿，周期
+    AUDIO_TRACE_PLAYBACK,   //写入I2S TX的阻塞时间，微秒
+    AUDIO_TRACE_POINT_NUM
+} audio_trace_point_t;
+
+//直方图桶：小于8的值各占一个桶，之后每个2的幂分4个桶，相对误差不超过25%
+#define AUDIO_TRACE_BUCKETS 124
+
+//一个测量点的汇总
+typedef struct {
+    const char *name;
+    const char *unit;   //"cycles"或"us"
+    uint32_t count;
+    uint32_t p50;       //按桶上沿估计
+    uint32_t p99;
+    uint32_t max;
+} audio_trace_summary_t;
+
+#if CONFIG_AUDIO_TRACE
+void audio_trace_record(audio_trace_point_t point, uint32_t value);
+#else
+static inline void audio_trace_record(audio_trace_point_t point, uint32_t value)
+{
+}
+#endif
+
+//CPU耗时的测量：start = audio_trace_begin(); ...; audio_trace_end(point, start);
+static inline uint32_t audio_trace_begin(void)
+{
+    return esp_cpu_get_cycle_count();
+}
+
+static inline void audio_trace_end(audio_trace_point_t point, uint32_t start)
+{
+    audio_trace_record(point, esp_cpu_get_cycle_count() - start);
+}
+
+int audio_trace_snapshot(audio_trace_summary_t *out, int max);
+int audio_trace_format(char *buf, size_t size);
+void audio_trace_dump(void);
+void audio_trace_reset(void);
+esp_err_t audio_trace_start_dump(uint32_t interval_ms);
+
+#endif
@@ -0,0 +1,111 @@
+#include "audio_vad.h"
+#include <math.h>
+
+ESP_EVENT_DEFINE_BASE(AUDIO_VAD_EVENT);
+
+//能量按(x >> 4)^2累加，单个样本最大2048^2 = 2^22，一块4096个样本最大2^34，要用int64累加
+#define VAD_ENERGY_SHIFT 4
+#define VAD_MAX_BLOCK    4096
+
+//噪声底：能量低于噪声底时快速跟随，高于时缓慢上升，以适应环境噪声变化
+#define NOISE_FALL_RATE 0.125f
+#define NOISE_RISE_RATE 0.002f
+#define NOISE_MIN       4.0f //约-84dBFS，防止数字静音时阈值为0
+
+//白噪声每样本约0.5次过零，浊音远低于此，摩擦音较高但能量也高
+#define ZCR_NOISE       0.35f
+#define LOUD_FACTOR     4.0f //能量超过阈值这么多倍时不看过零率
+
+//连续两块判为语音才开始
+#define ONSET_BLOCKS 2
+
+//threshold_db为语音能量高于噪声底的分贝数
+void audio_vad_init(audio_vad_t *vad, float threshold_db, uint32_t hangover_blocks)
+{
+    vad->threshold = powf(10.0f, threshold_db / 10.0f);
+    vad->noise_floor = NOISE_MIN;
+    vad->onset_blocks = ONSET_BLOCKS;
+    vad->hangover_blocks = hangover_blocks;
+    vad->speech_run = 0;
+    vad->hangover = 0;
+    vad->speech = false;
+    vad->energy = 0.0f;
+    vad->zcr = 0.0f;
+}
+
+//平均能量换算成dBFS
+static float energy_to_db(float energy)
+{
+    float full_scale = (float)(32768 >> VAD_ENERGY_SHIFT) * (float)(32768 >> VAD_ENERGY_SHIFT);
+    return 10.0f * log10f(energy / full_scale + 1e-10f);
+}
+
+//处理一块，返回状态变化。一次遍历同时算能量和过零数，每样本只有几条整数指令
+audio_vad_result_t audio_vad_process(audio_vad_t *vad, const int16_t *samples, size_t count)
+{
+    if (count == 0) {
+        return AUDIO_VAD_NONE;
+    }
+    if (count > VAD_MAX_BLOCK) {
+        count = VAD_MAX_BLOCK;
+    }
+
+    int64_t energy_sum = 0;
+    uint32_t crossings = 0;
+    int16_t prev = samples[0];
+    for (size_t i = 0; i < count; i++) {
+        int32_t x = samples[i] >> VAD_ENERGY_SHIFT;
+        energy_sum += x * x;
+        crossings += (uint32_t)((samples[i] ^ prev) < 0);
+        prev = samples[i];
+    }
+
+    float energy = (float)energy_sum / count;
+    vad->zcr = (float)crossings / count;
+
+    float threshold = vad->noise_floor * vad->threshold;
+    bool active = (energy > threshold && vad->zcr < ZCR_NOISE) || energy > threshold * LOUD_FACTOR;
+
+    //只在非语音块上更新噪声底，否则长句会把噪声底抬上去
+    if (!active) {
+        float rate = energy < vad->noise_floor ? NOISE_FALL_RATE : NOISE_RISE_RATE;
+        vad->noise_floor += (energy - vad->noise_floor) * rate;
+        if (vad->noise_floor < NOISE_MIN) {
+            vad->noise_floor = NOISE_MIN;
+        }
+    }
+    vad->energy = energy;
+
+    if (active) {
+        vad->speech_run++;
+        vad->hangover = vad->hangover_blocks;
+        if (!vad->speech && vad->speech_run >= vad->onset_blocks) {
+            vad->speech = true;
+            return AUDIO_VAD_START;
+        }
+        return AUDIO_VAD_NONE;
+    }
+
+    vad->speech_run = 0;
+    if (vad->speech) {
+        if (vad->hangover > 0) {
+            vad->hangover--;
+        } else {
+            vad->speech = false;
+            return AUDIO_VAD_END;
+        }
+    }
+    return AUDIO_VAD_NONE;
+}
+
+//最近一块的能量（dBFS），对数运算放在这里，不占每块的处理时间
+float audio_vad_energy_db(const audio_vad_t *vad)
+{
+    return energy_to_db(vad->energy);
+}
+
+//当前噪声底（dBFS）
+float audio_vad_noise_db(const audio_vad_t *vad)
+{
+    return energy_to_db(vad->noise_floor);
+}
@@ -0,0 +1,49 @@
+#ifndef __AUDIO_VAD_H_
+#define __AUDIO_VAD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_event.h"
+
+//语音起止事件，发到默认事件循环，应用可以据此开关会话
+ESP_EVENT_DECLARE_BASE(AUDIO_VAD_EVENT);
+
+typedef enum {
+    AUDIO_VAD_EVENT_SPEECH_START,   //检测到语音开始
+    AUDIO_VAD_EVENT_SPEECH_END,     //拖尾结束，语音段结束
+} audio_vad_event_t;
+
+//事件数据
+typedef struct {
+    int64_t timestamp_us;   //触发该事件的帧的采集时刻
+    float energy_db;        //该帧能量（dBFS）
+    float noise_db;         //当前噪声底（dBFS）
+} audio_vad_event_data_t;
+
+//单次处理的结果
+typedef enum {
+    AUDIO_VAD_NONE,     //状态没有变化
+    AUDIO_VAD_START,    //进入语音状态
+    AUDIO_VAD_END,      //回到静音状态
+} audio_vad_result_t;
+
+//能量+过零率语音检测，16位单声道
+typedef struct {
+    float threshold;        //能量超过噪声底的倍数判为语音
+    float noise_floor;      //噪声底，按块平均能量
+    uint32_t onset_blocks;  //连续多少块判为语音才算开始，滤掉敲击声
+    uint32_t hangover_blocks; //语音结束后保持的块数，不切掉词尾
+    uint32_t speech_run;    //连续判为语音的块数
+    uint32_t hangover;      //剩余拖尾块数
+    bool speech;            //当前是否在语音状态
+    float energy;           //最近一块的平均能量
+    float zcr;              //最近一块的过零率（每样本）
+} audio_vad_t;
+
+void audio_vad_init(audio_vad_t *vad, float threshold_db, uint32_t hangover_blocks);
+audio_vad_result_t audio_vad_process(audio_vad_t *vad, const int16_t *samples, size_t count);
+float audio_vad_energy_db(const audio_vad_t *vad);
+float audio_vad_noise_db(const audio_vad_t *vad);
+
+#endif
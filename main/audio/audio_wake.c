@@ -0,0 +1,158 @@
+#include "audio_wake.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+#if CONFIG_AUDIO_WAKE
+#include "esp_wn_iface.h"
+#include "esp_wn_models.h"
+#include "model_path.h"
+#endif
+
+#define TAG "WAKE"
+
+ESP_EVENT_DEFINE_BASE(AUDIO_WAKE_EVENT);
+
+//大缓冲优先放PSRAM
+static void *wake_alloc(size_t size)
+{
+    void *p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (p == NULL) {
+        p = heap_caps_malloc(size, MALLOC_CAP_INTERNAL);
+    }
+    return p;
+}
+
+//preroll_samples为唤醒时补发的音频长度，应能覆盖唤醒词本身
+esp_err_t audio_wake_init(audio_wake_t *wake, const audio_wake_backend_t *backend, size_t preroll_samples)
+{
+    audio_wake_stats_t stats = wake->stats;//后端创建时已经记下模型占用
+
+    memset(wake, 0, sizeof(*wake));
+    wake->backend = *backend;
+    wake->stats = stats;
+    wake->ring_len = preroll_samples;
+
+    wake->chunk_buf = wake_alloc(backend->chunk * sizeof(int16_t));
+    wake->ring = wake_alloc(preroll_samples * sizeof(int16_t));
+    if (wake->chunk_buf == NULL || wake->ring == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    wake->stats.ring_bytes = preroll_samples * sizeof(int16_t);
+
+    return ESP_OK;
+}
+
+//写入预录环形缓冲，满了覆盖最旧的样本
+static void ring_write(audio_wake_t *wake, const int16_t *samples, size_t count)
+{
+    if (count > wake->ring_len) {
+        samples += count - wake->ring_len;
+        count = wake->ring_len;
+    }
+
+    size_t first = wake->ring_len - wake->ring_pos;
+    first = first < count ? first : count;
+    memcpy(wake->ring + wake->ring_pos, samples, first * sizeof(int16_t));
+    memcpy(wake->ring, samples + first, (count - first) * sizeof(int16_t));
+
+    wake->ring_pos = (wake->ring_pos + count) % wake->ring_len;
+    wake->ring_count = wake->ring_count + count > wake->ring_len ? wake->ring_len : wake->ring_count + count;
+}
+
+//处理一段样本，检测到唤醒词返回true。不管是否检测到，样本都进预录缓冲
+bool audio_wake_process(audio_wake_t *wake, const int16_t *samples, size_t count)
+{
+    bool detected = false;
+
+    ring_write(wake, samples, count);
+
+    while (count > 0) {
+        size_t n = wake->backend.chunk - wake->chunk_fill;
+        n = n < count ? n : count;
+        memcpy(wake->chunk_buf + wake->chunk_fill, samples, n * sizeof(int16_t));
+        wake->chunk_fill += n;
+        samples += n;
+        count -= n;
+
+        if (wake->chunk_fill == wake->backend.chunk) {
+            uint32_t start = esp_cpu_get_cycle_count();
+            bool hit = wake->backend.detect(wake->backend.model, wake->chunk_buf);
+            wake->stats.cycles = esp_cpu_get_cycle_count() - start;
+            if (wake->stats.cycles > wake->stats.cycles_max) {
+                wake->stats.cycles_max = wake->stats.cycles;
+            }
+            wake->stats.chunks++;
+            wake->chunk_fill = 0;
+
+            if (hit) {
+                wake->stats.detections++;
+                detected = true;
+            }
+        }
+    }
+
+    return detected;
+}
+
+//按时间顺序取出并清空预录缓冲，返回样本数
+size_t audio_wake_read_preroll(audio_wake_t *wake, int16_t *out, size_t max)
+{
+    size_t count = wake->ring_count < max ? wake->ring_count : max;
+    size_t start = (wake->ring_pos + wake->ring_len - count) % wake->ring_len;
+
+    size_t first = wake->ring_len - start;
+    first = first < count ? first : count;
+    memcpy(out, wake->ring + start, first * sizeof(int16_t));
+    memcpy(out + first, wake->ring, (count - first) * sizeof(int16_t));
+
+    wake->ring_count = 0;
+    return count;
+}
+
+#if CONFIG_AUDIO_WAKE
+static const esp_wn_iface_t *wakenet = NULL;
+
+static bool wakenet_detect(void *model, int16_t *samples)
+{
+    return wakenet->detect((model_iface_data_t *)model, samples) == WAKENET_DETECTED;
+}
+
+//从model分区加载第一个WakeNet模型，记录模型占用的内存
+esp_err_t audio_wake_backend_wakenet(audio_wake_backend_t *backend, audio_wake_stats_t *stats)
+{
+    size_t psram_before = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    size_t internal_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+
+    srmodel_list_t *models = esp_srmodel_init("model");
+    char *name = esp_srmodel_filter(models, ESP_WN_PREFIX, NULL);
+    if (name == NULL) {
+        ESP_LOGE(TAG, "model分区里没有WakeNet模型");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    wakenet = esp_wn_handle_from_name(name);
+    model_iface_data_t *model = wakenet->create(name, DET_MODE_95);
+    if (model == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (wakenet->get_samp_rate(model) != 16000) {
+        ESP_LOGE(TAG, "模型采样率%d与流采样率不符", wakenet->get_samp_rate(model));
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    backend->chunk = wakenet->get_samp_chunksize(model);
+    backend->detect = wakenet_detect;
+    backend->model = model;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->model_psram = psram_before - heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    stats->model_internal = internal_before - heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    ESP_LOGI(TAG, "WakeNet %s：每块%u个样本，PSRAM %u字节，内部RAM %u字节", name, (unsigned)backend->chunk,
+             (unsigned)stats->model_psram, (unsigned)stats->model_internal);
+
+    return ESP_OK;
+}
+#endif
@@ -0,0 +1,53 @@
+#ifndef __AUDIO_WAKE_H_
+#define __AUDIO_WAKE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_event.h"
+
+//唤醒事件，发到默认事件循环
+ESP_EVENT_DECLARE_BASE(AUDIO_WAKE_EVENT);
+
+typedef enum {
+    AUDIO_WAKE_EVENT_DETECTED,  //检测到唤醒词，开始上行
+} audio_wake_event_t;
+
+//唤醒词检测后端：每次输入chunk个16位单声道样本，检测到返回true
+//板上用WakeNet，主机上可以换成读WAV样例的实现
+typedef struct {
+    size_t chunk;                                  //每次检测的样本数
+    bool (*detect)(void *model, int16_t *samples); //检测一块
+    void *model;                                   //后端私有数据
+} audio_wake_backend_t;
+
+//唤醒统计
+typedef struct {
+    uint32_t chunks;        //检测的块数
+    uint32_t detections;    //唤醒次数
+    uint32_t cycles;        //最近一块的检测耗时（CPU周期）
+    uint32_t cycles_max;    //检测耗时的最大值
+    size_t model_psram;     //模型占用的PSRAM字节数
+    size_t model_internal;  //模型占用的内部RAM字节数
+    size_t ring_bytes;      //预录环形缓冲的字节数
+} audio_wake_stats_t;
+
+//唤醒词前端：攒块送后端检测，同时在环形缓冲里保留最近一段音频
+typedef struct {
+    audio_wake_backend_t backend;
+    int16_t *chunk_buf;     //攒够一块送检
+    size_t chunk_fill;
+    int16_t *ring;          //预录环形缓冲
+    size_t ring_len;        //容量（样本数）
+    size_t ring_pos;        //下一个写入位置
+    size_t ring_count;      //有效样本数
+    audio_wake_stats_t stats;
+} audio_wake_t;
+
+esp_err_t audio_wake_init(audio_wake_t *wake, const audio_wake_backend_t *backend, size_t preroll_samples);
+esp_err_t audio_wake_backend_wakenet(audio_wake_backend_t *backend, audio_wake_stats_t *stats);
+bool audio_wake_process(audio_wake_t *wake, const int16_t *samples, size_t count);
+size_t audio_wake_read_preroll(audio_wake_t *wake, int16_t *out, size_t max);
+
+#endif
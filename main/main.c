@@ -5,11 +5,17 @@
 #include "app_driver.h"
 #include "wifi_connect.h"
 #include "websocket_client.h"
+#include "audio_bench.h"
+#include "audio_pipeline.h"
 
 void app_main(void){
-    i2s_tx_init();//MAX98357A初始化
+#if CONFIG_AUDIO_BENCH_ON_BOOT
+    audio_bench_run();//DSP内核基准测试
+#endif
+
+    ESP_ERROR_CHECK(i2s_tx_init(audio_pipeline_get_profile()));//MAX98357A初始化，DMA按默认档位配置
  
-    i2s_rx_init();//INMP441初始化
+    ESP_ERROR_CHECK(i2s_rx_init(audio_pipeline_get_profile()));//INMP441初始化
 
     wifi_connect();//wifi连接初始化
 
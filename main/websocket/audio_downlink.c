@@ -0,0 +1,111 @@
+#include "audio_downlink.h"
+#include "Audio_common.h"
+#include "audio_codec.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "audio_trace.h"
+#include <string.h>
+
+#define TAG "DOWNLINK"
+
+//单包解码后最多40ms的STREAM_SAMPLE_RATE单声道16位数据
+#define DOWNLINK_MAX_SAMPLES (STREAM_SAMPLE_RATE * 40 / 1000)
+#define DOWNLINK_MAX_MESSAGE (sizeof(audio_packet_header_t) + DOWNLINK_MAX_SAMPLES * sizeof(int16_t))
+
+static audio_jitter_t jitter;
+static uint8_t *message = NULL; //消息重组缓冲，服务器的消息可能被拆成多个WebSocket帧和多次DATA事件
+static size_t message_len = 0;
+static bool message_drop = false; //当前消息已经判定为丢弃，剩余分片跳过
+static audio_downlink_stats_t stats;
+
+//分配重组缓冲和抖动缓冲
+esp_err_t audio_downlink_init(void)
+{
+    message = heap_caps_malloc(DOWNLINK_MAX_MESSAGE, MALLOC_CAP_INTERNAL);
+    if (message == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    return audio_jitter_init(&jitter, STREAM_SAMPLE_RATE, DOWNLINK_MAX_SAMPLES,
+                             CONFIG_AUDIO_DOWNLINK_JITTER_MIN_MS, CONFIG_AUDIO_DOWNLINK_JITTER_MAX_MS);
+}
+
+//一条完整消息：检查帧头，放进抖动缓冲
+static void downlink_deliver(const uint8_t *msg, size_t len)
+{
+    audio_packet_header_t header;
+
+    stats.messages++;
+    if (len <= sizeof(header)) {
+        stats.bad_format++;
+        return;
+    }
+    memcpy(&header, msg, sizeof(header));
+
+    size_t payload = len - sizeof(header);
+    if ((header.codec != AUDIO_CODEC_PCM && header.codec != AUDIO_CODEC_IMA_ADPCM) ||
+        header.sample_rate != STREAM_SAMPLE_RATE || header.channels != 1 || header.bits != 16) {
+        stats.bad_format++;
+        ESP_LOGD(TAG, "格式不符：%u Hz %u声道 %u位 编码%u", header.sample_rate, header.channels, header.bits, header.codec);
+        return;
+    }
+
+    //抖动缓冲保存未解码的数据，播放任务取出时再解码
+    if (audio_jitter_push(&jitter, header.seq, (audio_codec_t)header.codec, msg + sizeof(header), payload) == ESP_ERR_INVALID_SIZE) {
+        stats.bad_format++;
+    }
+}
+
+//WebSocket DATA事件，在WebSocket客户端任务中调用
+void audio_downlink_on_data(const esp_websocket_event_data_t *data)
+{
+    if (message == NULL) {
+        return;
+    }
+
+    //新消息的第一个帧，文本帧和控制帧不是音频
+    if (data->op_code == WS_TRANSPORT_OPCODES_BINARY && data->payload_offset == 0) {
+        message_len = 0;
+        message_drop = false;
+    } else if (data->op_code != WS_TRANSPORT_OPCODES_CONT && data->op_code != WS_TRANSPORT_OPCODES_BINARY) {
+        return;
+    }
+
+    if (message_drop) {
+        return;
+    }
+
+    if (message_len + data->data_len > DOWNLINK_MAX_MESSAGE) {
+        stats.oversize++;
+        message_drop = true;
+        return;
+    }
+    memcpy(message + message_len, data->data_ptr, data->data_len);
+    message_len += data->data_len;
+
+    //当前帧是否收完，接收缓冲比帧小时同一帧会分多次事件送达
+    bool frame_done = data->payload_offset + data->data_len >= data->payload_len;
+    if (frame_done && data->fin) {
+        uint32_t start = audio_trace_begin();
+        downlink_deliver(message, message_len);
+        audio_trace_end(AUDIO_TRACE_RECEIVE, start);
+        message_len = 0;
+    }
+}
+
+//播放数据源：从抖动缓冲取一帧并解码，缓冲中输出静音，丢包时输出补偿帧
+size_t audio_downlink_read(void *ctx, uint8_t *buf, size_t size)
+{
+    uint32_t start = audio_trace_begin();
+    size_t samples = audio_jitter_pop(&jitter, (int16_t *)buf, size / sizeof(int16_t));
+    audio_trace_end(AUDIO_TRACE_DECODE, start);
+
+    return samples * sizeof(int16_t);
+}
+
+//获取下行统计
+void audio_downlink_get_stats(audio_downlink_stats_t *out)
+{
+    *out = stats;
+    audio_jitter_get_stats(&jitter, &out->jitter);
+}
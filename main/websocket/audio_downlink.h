@@ -0,0 +1,21 @@
+#ifndef __AUDIO_DOWNLINK_H_
+#define __AUDIO_DOWNLINK_H_
+
+#include "esp_websocket_client.h"
+#include "audio_packet.h"
+#include "audio_jitter.h"
+
+//下行统计，抖动缓冲部分见audio_jitter_stats_t
+typedef struct {
+    uint32_t messages;      //收到的完整二进制消息数
+    uint32_t bad_format;    //帧头格式与播放格式不符而丢弃的消息数
+    uint32_t oversize;      //超过重组缓冲而丢弃的消息数
+    audio_jitter_stats_t jitter;
+} audio_downlink_stats_t;
+
+esp_err_t audio_downlink_init(void);
+void audio_downlink_on_data(const esp_websocket_event_data_t *data);
+size_t audio_downlink_read(void *ctx, uint8_t *buf, size_t size);
+void audio_downlink_get_stats(audio_downlink_stats_t *stats);
+
+#endif
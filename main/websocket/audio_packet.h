@@ -0,0 +1,17 @@
+#ifndef __AUDIO_PACKET_H_
+#define __AUDIO_PACKET_H_
+
+#include <stdint.h>
+
+//上行、下行音频二进制帧的帧头，小端，后面紧跟音频数据
+typedef struct __attribute__((packed)) {
+    uint32_t seq;           //序号，接收端从间隔判断丢帧
+    uint64_t timestamp_us;  //采集时刻（设备esp_timer时间）
+    uint16_t sample_rate;   //采样率
+    uint8_t channels;       //声道数
+    uint8_t bits;           //每个样本的位数（编码前）
+    uint8_t codec;          //数据的编码方式，audio_codec_t
+    uint8_t reserved;
+} audio_packet_header_t;
+
+#endif
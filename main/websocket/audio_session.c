@@ -0,0 +1,165 @@
+#include "audio_session.h"
+#include "audio_ring.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <string.h>
+#include <stdatomic.h>
+
+#define TAG "SESSION"
+
+// 唤醒任务：WakeNet一块要几十毫秒，不放在采集任务里，低于上行发送任务，和网络在同一个核
+#define SESSION_TASK_DEPTH 8192 // 任务栈深
+#define SESSION_TASK_PRI   2 // 任务优先级
+
+//采集任务交给唤醒任务的一帧，样本跟在帧描述后面
+typedef struct {
+    audio_frame_t frame;
+    int16_t samples[];
+} session_slot_t;
+
+//唤醒会话：检测到唤醒词时打开上行闸门，超时或语音结束时关上
+//wake、preroll只在唤醒任务中访问
+static audio_ring_t frames;
+static size_t frame_bytes = 0;
+static audio_wake_t *wake = NULL;
+static int16_t *preroll = NULL; //取出预录音频用，发送任务用完之前不能改写
+static int64_t session_max_us = 0;
+static atomic_bool session_open = false; //唤醒任务打开，唤醒任务（超时）或采集任务（语音结束）关闭
+static int64_t session_start_us = 0; //在session_open置位之前写，读的一方先看session_open
+static audio_session_stats_t stats;
+
+//max_us为会话的最长时间，max_frame_bytes为采集帧的最大字节数
+//preroll缓冲按wake的预录长度分配，上行闸门先关上
+esp_err_t audio_session_init(audio_wake_t *w, int64_t max_us, size_t max_frame_bytes)
+{
+    preroll = heap_caps_malloc(w->ring_len * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+    if (preroll == NULL) {
+        preroll = heap_caps_malloc(w->ring_len * sizeof(int16_t), MALLOC_CAP_INTERNAL);
+    }
+    if (preroll == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = audio_ring_init(&frames, sizeof(session_slot_t) + max_frame_bytes, AUDIO_SESSION_QUEUE_FRAMES,
+                                    MALLOC_CAP_INTERNAL);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    wake = w;
+    frame_bytes = max_frame_bytes;
+    session_max_us = max_us;
+    session_open = false;
+    //关着的时候上行保留唤醒任务落后的那几帧，唤醒时接在预录后面
+    audio_uplink_set_gate(false, AUDIO_SESSION_QUEUE_FRAMES);
+    return ESP_OK;
+}
+
+//唤醒：打开上行闸门，把预录的唤醒词和它前面的音频先发出去，到触发帧为止
+//预录整段作为一帧交给上行，不拷贝，只占一个发送槽，不会把紧接着的采集帧挤出队列
+//上行丢掉已经在预录里的帧，之后的帧接着发
+static void session_begin(const audio_frame_t *frame)
+{
+    int64_t frame_samples = frame->size / sizeof(int16_t);
+    size_t count = 0;
+
+    //上一次的预录还没发完时不能改写preroll，这次不补发
+    if (!audio_uplink_ref_busy()) {
+        count = audio_wake_read_preroll(wake, preroll, wake->ring_len);
+    }
+
+    audio_frame_t pre = *frame;
+    pre.data = (uint8_t *)preroll;
+    pre.size = count * sizeof(int16_t);
+    pre.timestamp_us = frame->timestamp_us - ((int64_t)count - frame_samples) * 1000000 / frame->sample_rate;
+    esp_err_t ret = audio_uplink_open_ref(count > 0 ? &pre : NULL, frame->timestamp_us);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG,"预录音频没有放进上行队列：%s", esp_err_to_name(ret));
+        count = 0;
+    }
+
+    session_start_us = frame->timestamp_us;
+    session_open = true;
+    stats.sessions++;
+    esp_event_post(AUDIO_WAKE_EVENT, AUDIO_WAKE_EVENT_DETECTED, &frame->timestamp_us, sizeof(frame->timestamp_us), 0);
+    ESP_LOGI(TAG,"唤醒，补发%u ms预录音频", (unsigned)(count * 1000 / frame->sample_rate));
+}
+
+static void session_end(void)
+{
+    if (atomic_exchange(&session_open, false)) {
+        audio_uplink_set_gate(false, AUDIO_SESSION_QUEUE_FRAMES);
+    }
+}
+
+//会话外检测唤醒词，会话内只检查超时
+static void session_frame(const audio_frame_t *frame)
+{
+    if (!session_open) {
+        if (audio_wake_process(wake, (const int16_t *)frame->data, frame->size / sizeof(int16_t))) {
+            session_begin(frame);
+        }
+    } else if (frame->timestamp_us - session_start_us > session_max_us) {
+        session_end();
+    }
+}
+
+//唤醒任务：按采集顺序取帧检测
+static void session_task(void *param)
+{
+    while (1) {
+        session_slot_t *slot = audio_ring_peek_wait(&frames, portMAX_DELAY);
+        if (slot != NULL) {
+            session_frame(&slot->frame);
+            audio_ring_release(&frames);
+        }
+    }
+}
+
+//启动唤醒任务
+esp_err_t audio_session_start(void)
+{
+    if (xTaskCreatePinnedToCore(session_task, "audio wake", SESSION_TASK_DEPTH, NULL, SESSION_TASK_PRI, NULL,
+                                NET_TASK_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+//处理级：只把帧复制给唤醒任务，不阻塞，唤醒任务跟不上时这一帧不检测，放在语音检测和上行级之前
+esp_err_t audio_session_stage(void *ctx, audio_frame_t *frame)
+{
+    if (frame->size > frame_bytes) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    session_slot_t *slot = audio_ring_reserve(&frames);
+    if (slot == NULL) {
+        stats.dropped++;
+        return ESP_OK;
+    }
+    slot->frame = *frame;
+    slot->frame.data = (uint8_t *)slot->samples;
+    memcpy(slot->samples, frame->data, frame->size);
+    audio_ring_commit(&frames);
+    return ESP_OK;
+}
+
+//语音结束：会话已经超过AUDIO_SESSION_MIN_US时提前结束，在采集任务中调用
+void audio_session_speech_end(int64_t timestamp_us)
+{
+    if (session_open && timestamp_us - session_start_us > AUDIO_SESSION_MIN_US) {
+        session_end();
+    }
+}
+
+bool audio_session_is_open(void)
+{
+    return session_open;
+}
+
+//获取会话统计
+void audio_session_get_stats(audio_session_stats_t *out)
+{
+    *out = stats;
+    out->pending = audio_ring_count(&frames);
+}
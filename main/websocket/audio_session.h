@@ -0,0 +1,27 @@
+#ifndef __AUDIO_SESSION_H_
+#define __AUDIO_SESSION_H_
+
+#include "audio_uplink.h"
+#include "audio_wake.h"
+
+//唤醒后至少听2秒，唤醒词后的停顿不结束会话
+#define AUDIO_SESSION_MIN_US 2000000
+
+//采集任务交给唤醒任务的帧数，唤醒任务落后更多时丢帧不检测
+#define AUDIO_SESSION_QUEUE_FRAMES 16
+
+//会话统计
+typedef struct {
+    uint32_t pending;   //等唤醒任务检测的帧数
+    uint32_t dropped;   //唤醒任务跟不上丢掉的帧数
+    uint32_t sessions;  //唤醒打开的会话数
+} audio_session_stats_t;
+
+esp_err_t audio_session_init(audio_wake_t *wake, int64_t max_us, size_t max_frame_bytes);
+esp_err_t audio_session_start(void);
+esp_err_t audio_session_stage(void *ctx, audio_frame_t *frame);
+void audio_session_speech_end(int64_t timestamp_us);
+bool audio_session_is_open(void);
+void audio_session_get_stats(audio_session_stats_t *stats);
+
+#endif
@@ -0,0 +1,441 @@
+#include "audio_uplink.h"
+#include "websocket_client.h"
+#include "esp_heap_caps.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "audio_trace.h"
+
+#define TAG "UPLINK"
+
+// 上行发送任务
+#define UPLINK_TASK_DEPTH 4096 // 任务栈深
+#define UPLINK_TASK_PRI   3 // 任务优先级
+
+#define UPLINK_SEND_TIMEOUT pdMS_TO_TICKS(200) //单帧发送超时
+
+//发送槽，帧头和数据连续存放，一次发送
+typedef struct {
+    size_t len; //帧头加数据的总字节数
+    int64_t queued_us; //进发送队列的时刻
+    uint8_t *buf;
+    uint8_t *ref; //不为NULL时数据不在buf里而在这里（audio_uplink_push_ref），buf里只有帧头
+} uplink_slot_t;
+
+//比队列长度多一个槽，留给正在发送的那一帧
+static uplink_slot_t slots[AUDIO_UPLINK_QUEUE_LEN + 1];
+static QueueHandle_t free_queue = NULL; //空闲槽
+static QueueHandle_t send_queue = NULL; //待发送槽
+static QueueHandle_t preroll_queue = NULL; //闸门关闭时最近的几帧，闸门打开时先发出去，不切掉语音开头
+static bool gate_open = true;
+static size_t preroll_frames = 0;
+static size_t slot_payload = 0;
+static uint32_t next_seq = 0;
+static volatile bool ref_busy = false; //audio_uplink_push_ref的数据还没处理完
+static int64_t covered_us = INT64_MIN; //采集时刻不晚于此的帧已经随预录发出（audio_uplink_open_ref）
+static SemaphoreHandle_t gate_lock = NULL; //闸门和入队操作可能来自采集任务和唤醒任务
+static StaticSemaphore_t gate_lock_buf;
+static audio_uplink_stats_t stats;
+
+#if CONFIG_AUDIO_UPLINK_CODEC_IMA_ADPCM
+#define PACKET_SAMPLES (STREAM_SAMPLE_RATE * AUDIO_UPLINK_PACKET_MS / 1000)
+
+//编码打包状态，只在发送任务中访问
+static audio_adpcm_state_t encoder;
+static int16_t *packet_pcm = NULL;   //攒够一包的PCM
+static size_t packet_fill = 0;       //packet_pcm中已有的样本数
+static uint8_t *packet_out = NULL;   //编码输出
+static audio_packet_header_t packet_header;
+static uint32_t packet_seq = 0;
+#endif
+
+//分配发送槽，max_payload为单帧音频数据的最大字节数
+esp_err_t audio_uplink_init(size_t max_payload)
+{
+    free_queue = xQueueCreate(AUDIO_UPLINK_QUEUE_LEN + 1, sizeof(uplink_slot_t *));
+    send_queue = xQueueCreate(AUDIO_UPLINK_QUEUE_LEN, sizeof(uplink_slot_t *));
+    preroll_queue = xQueueCreate(AUDIO_UPLINK_QUEUE_LEN, sizeof(uplink_slot_t *));
+    gate_lock = xSemaphoreCreateMutexStatic(&gate_lock_buf);
+    if (free_queue == NULL || send_queue == NULL || preroll_queue == NULL || gate_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+#if CONFIG_AUDIO_UPLINK_CODEC_IMA_ADPCM
+    //编码缓冲优先放PSRAM，只有发送任务顺序访问，对速度不敏感
+    packet_pcm = heap_caps_malloc(PACKET_SAMPLES * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+    if (packet_pcm == NULL) {
+        packet_pcm = heap_caps_malloc(PACKET_SAMPLES * sizeof(int16_t), MALLOC_CAP_INTERNAL);
+    }
+    packet_out = heap_caps_malloc(audio_adpcm_encoded_size(PACKET_SAMPLES), MALLOC_CAP_INTERNAL);
+    if (packet_pcm == NULL || packet_out == NULL) {
+        ESP_LOGE(TAG, "编码缓冲分配失败");
+        return ESP_ERR_NO_MEM;
+    }
+    audio_adpcm_reset(&encoder);
+#endif
+
+    slot_payload = max_payload;
+    for (int i = 0; i < AUDIO_UPLINK_QUEUE_LEN + 1; i++) {
+        slots[i].buf = heap_caps_malloc(sizeof(audio_packet_header_t) + max_payload, MALLOC_CAP_INTERNAL);
+        if (slots[i].buf == NULL) {
+            ESP_LOGE(TAG, "发送槽分配失败");
+            return ESP_ERR_NO_MEM;
+        }
+
+        uplink_slot_t *slot = &slots[i];
+        xQueueSend(free_queue, &slot, 0);
+    }
+
+    return ESP_OK;
+}
+
+//槽里引用的外部数据不再使用，调用者可以改写了
+static void slot_drop_ref(uplink_slot_t *slot)
+{
+    if (slot->ref != NULL) {
+        slot->ref = NULL;
+        ref_busy = false;
+    }
+}
+
+//填写帧头
+static void slot_set_header(uplink_slot_t *slot, const audio_frame_t *frame)
+{
+    audio_packet_header_t header = {
+        .seq = next_seq++,
+        .timestamp_us = (uint64_t)frame->timestamp_us,
+        .sample_rate = (uint16_t)frame->sample_rate,
+        .channels = frame->channels,
+        .bits = frame->bits,
+        .codec = AUDIO_CODEC_PCM,
+    };
+    memcpy(slot->buf, &header, sizeof(header));
+    slot->len = sizeof(header) + frame->size;
+}
+
+//取一个空闲槽：没有时回收最旧的预录帧，再没有就回收最旧的待发送帧
+static uplink_slot_t *acquire_slot(void)
+{
+    uplink_slot_t *slot = NULL;
+
+    if (xQueueReceive(free_queue, &slot, 0) == pdTRUE) {
+        return slot;
+    }
+    if (xQueueReceive(preroll_queue, &slot, 0) == pdTRUE) {
+        stats.gated++;
+        return slot;
+    }
+    if (xQueueReceive(send_queue, &slot, 0) == pdTRUE) {
+        stats.dropped++;
+        slot_drop_ref(slot);
+        return slot;
+    }
+
+    //空闲槽和待发送槽都被发送任务暂时拿着
+    stats.dropped++;
+    return NULL;
+}
+
+//把处理后的一帧放进发送队列，不阻塞：队列满时丢弃最旧的一帧
+//闸门关闭时放进预录队列，只保留最近preroll_frames帧
+static esp_err_t push_locked(const audio_frame_t *frame)
+{
+    if (frame->size > slot_payload) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (frame->timestamp_us <= covered_us) {
+        stats.gated++;//已经在预录里
+        return ESP_OK;
+    }
+
+    uplink_slot_t *slot = acquire_slot();
+    if (slot == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    slot_set_header(slot, frame);
+    memcpy(slot->buf + sizeof(audio_packet_header_t), frame->data, frame->size);
+
+    if (!gate_open) {
+        while (uxQueueMessagesWaiting(preroll_queue) >= preroll_frames) {
+            uplink_slot_t *old = NULL;
+            if (xQueueReceive(preroll_queue, &old, 0) != pdTRUE) {
+                break;
+            }
+            stats.gated++;
+            xQueueSend(free_queue, &old, 0);
+        }
+        if (preroll_frames == 0) {
+            stats.gated++;
+            xQueueSend(free_queue, &slot, 0);
+        } else {
+            xQueueSend(preroll_queue, &slot, 0);
+        }
+        return ESP_OK;
+    }
+
+    stats.queued++;
+    slot->queued_us = esp_timer_get_time();
+    xQueueSend(send_queue, &slot, 0);
+
+    return ESP_OK;
+}
+
+esp_err_t audio_uplink_push(const audio_frame_t *frame)
+{
+    xSemaphoreTake(gate_lock, portMAX_DELAY);
+    esp_err_t ret = push_locked(frame);
+    xSemaphoreGive(gate_lock);
+    return ret;
+}
+
+//把一段数据不拷贝地作为一帧放进发送队列，长度不受发送槽大小限制，只占一个槽
+//用于唤醒时的预录音频，分成很多帧放进去会挤满队列，把紧接着的采集帧挤掉
+//闸门打开时才能调用，frame->data在audio_uplink_ref_busy返回false之前不能改写，PCM发送时会原地加掩码
+static esp_err_t push_ref_locked(const audio_frame_t *frame)
+{
+    if (!gate_open || ref_busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uplink_slot_t *slot = acquire_slot();
+    if (slot == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    slot_set_header(slot, frame);
+    slot->ref = frame->data;
+    slot->queued_us = esp_timer_get_time();
+    ref_busy = true;
+    if (xQueueSend(send_queue, &slot, 0) != pdTRUE) {
+        slot_drop_ref(slot);
+        xQueueSend(free_queue, &slot, 0);
+        return ESP_ERR_NO_MEM;
+    }
+    stats.queued++;
+
+    return ESP_OK;
+}
+
+esp_err_t audio_uplink_push_ref(const audio_frame_t *frame)
+{
+    xSemaphoreTake(gate_lock, portMAX_DELAY);
+    esp_err_t ret = push_ref_locked(frame);
+    xSemaphoreGive(gate_lock);
+    return ret;
+}
+
+//上一次audio_uplink_push_ref的数据是否还在发送
+bool audio_uplink_ref_busy(void)
+{
+    return ref_busy;
+}
+
+//预录队列里的帧按顺序交给发送任务
+static void preroll_release(uplink_slot_t **slots_in, size_t num)
+{
+    for (size_t i = 0; i < num; i++) {
+        uplink_slot_t *slot = slots_in[i];
+        stats.queued++;
+        slot->queued_us = esp_timer_get_time();
+        if (xQueueSend(send_queue, &slot, 0) != pdTRUE) {
+            stats.dropped++;
+            xQueueSend(free_queue, &slot, 0);
+        }
+    }
+}
+
+//开关上行闸门
+//打开时先把预录的帧按顺序交给发送任务；关闭时发一个空帧通知发送任务把没攒满的包发出去
+void audio_uplink_set_gate(bool open, size_t preroll)
+{
+    uplink_slot_t *slot = NULL;
+
+    if (preroll > AUDIO_UPLINK_QUEUE_LEN / 2) {
+        preroll = AUDIO_UPLINK_QUEUE_LEN / 2;//留一半给网络抖动
+    }
+
+    xSemaphoreTake(gate_lock, portMAX_DELAY);
+    preroll_frames = preroll;
+    if (open != gate_open) {
+        gate_open = open;
+        if (open) {
+            while (xQueueReceive(preroll_queue, &slot, 0) == pdTRUE) {
+                preroll_release(&slot, 1);
+            }
+        } else if (xQueueReceive(free_queue, &slot, 0) == pdTRUE) {
+            audio_packet_header_t header = { 0 };
+            memcpy(slot->buf, &header, sizeof(header));
+            slot->len = sizeof(header);
+            xQueueSend(send_queue, &slot, 0);
+        }
+    }
+    xSemaphoreGive(gate_lock);
+}
+
+//打开闸门并先发一段不拷贝的预录，用于在采集任务以外判定打开的情况（唤醒）
+//判定落后于采集，预录队列里和之后送来的帧中，采集时刻不晚于until_us的已经在preroll里，丢掉，其余的接在preroll后面
+//preroll为NULL时只打开闸门；preroll的使用约定同audio_uplink_push_ref
+esp_err_t audio_uplink_open_ref(const audio_frame_t *preroll, int64_t until_us)
+{
+    uplink_slot_t *kept[AUDIO_UPLINK_QUEUE_LEN];
+    size_t kept_num = 0;
+    uplink_slot_t *slot = NULL;
+    esp_err_t ret = ESP_OK;
+
+    xSemaphoreTake(gate_lock, portMAX_DELAY);
+    if (preroll != NULL) {
+        covered_us = until_us;
+    }
+    while (xQueueReceive(preroll_queue, &slot, 0) == pdTRUE) {
+        audio_packet_header_t header;
+        memcpy(&header, slot->buf, sizeof(header));
+        if ((int64_t)header.timestamp_us <= covered_us) {
+            stats.gated++;
+            xQueueSend(free_queue, &slot, 0);
+        } else {
+            kept[kept_num++] = slot;
+        }
+    }
+
+    gate_open = true;
+    if (preroll != NULL) {
+        ret = push_ref_locked(preroll);
+    }
+    //留下的帧入队时就编了号，接在预录后面重新编号，接收端看到的序号不倒退
+    for (size_t i = 0; i < kept_num; i++) {
+        audio_packet_header_t header;
+        memcpy(&header, kept[i]->buf, sizeof(header));
+        header.seq = next_seq++;
+        memcpy(kept[i]->buf, &header, sizeof(header));
+    }
+    preroll_release(kept, kept_num);
+    xSemaphoreGive(gate_lock);
+
+    return ret;
+}
+
+//以一个二进制帧发出帧头和数据，帧头和数据都原地加掩码，发送后不可再用
+static void uplink_send(audio_packet_header_t *header, uint8_t *data, size_t len)
+{
+    //发送时帧头也被加掩码，采集时刻要先取出来
+    int64_t timestamp_us = (int64_t)header->timestamp_us;
+    esp_websocket_iov_t iov[2] = {
+        { .data = header, .len = sizeof(*header) },
+        { .data = data, .len = len },
+    };
+
+    if (!esp_websocket_client_is_connected(ws_client)) {
+        stats.disconnected++;
+        return;
+    }
+
+    int64_t start = esp_timer_get_time();
+    if (esp_websocket_client_send_bin_iov(ws_client, iov, 2, UPLINK_SEND_TIMEOUT) < 0) {
+        stats.send_errors++;
+        return;
+    }
+    int64_t end = esp_timer_get_time();
+    audio_trace_record(AUDIO_TRACE_SEND, (uint32_t)(end - start));
+    audio_trace_record(AUDIO_TRACE_UPLINK, (uint32_t)(end - timestamp_us));
+    stats.sent++;
+    stats.bytes_sent += len;
+}
+
+#if CONFIG_AUDIO_UPLINK_CODEC_IMA_ADPCM
+//编码并发送当前包，语音段结束时包可能没有攒满
+static void uplink_flush(void)
+{
+    if (packet_fill == 0) {
+        return;
+    }
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    size_t len = audio_adpcm_encode(&encoder, packet_pcm, packet_fill, packet_out);
+    stats.encode_cycles = esp_cpu_get_cycle_count() - start;
+    if (stats.encode_cycles > stats.encode_cycles_max) {
+        stats.encode_cycles_max = stats.encode_cycles;
+    }
+    stats.encoded++;
+    audio_trace_record(AUDIO_TRACE_ENCODE, stats.encode_cycles);
+
+    uplink_send(&packet_header, packet_out, len);
+    packet_fill = 0;
+}
+
+//把一个采集帧的PCM攒进当前包，攒满PACKET_SAMPLES就编码发送，一帧可能跨两包
+static void uplink_encode(const audio_packet_header_t *frame_header, const int16_t *pcm, size_t samples)
+{
+    size_t done = 0;
+
+    while (done < samples) {
+        if (packet_fill == 0) {
+            packet_header = *frame_header;
+            packet_header.seq = packet_seq++;
+            packet_header.timestamp_us += (uint64_t)done * 1000000 / frame_header->sample_rate;
+            packet_header.codec = AUDIO_CODEC_IMA_ADPCM;
+        }
+
+        size_t n = PACKET_SAMPLES - packet_fill;
+        n = n < samples - done ? n : samples - done;
+        memcpy(packet_pcm + packet_fill, pcm + done, n * sizeof(int16_t));
+        packet_fill += n;
+        done += n;
+
+        if (packet_fill == PACKET_SAMPLES) {
+            uplink_flush();
+        }
+    }
+}
+#endif
+
+//上行发送任务：取出待发送槽，以二进制帧发给服务器
+//槽直接作为发送缓冲，掩码在槽内原地完成，不再拷贝到客户端的tx_buffer，也不按buffer_size分片
+static void uplink_task(void *param)
+{
+    ESP_LOGI(TAG, "上行发送任务开始");
+    while (1) {
+        uplink_slot_t *slot = NULL;
+        xQueueReceive(send_queue, &slot, portMAX_DELAY);
+
+        audio_packet_header_t *header = (audio_packet_header_t *)slot->buf;
+        uint8_t *payload = slot->ref != NULL ? slot->ref : slot->buf + sizeof(*header);
+        size_t len = slot->len - sizeof(*header);
+        if (len > 0) {
+            audio_trace_record(AUDIO_TRACE_QUEUE, (uint32_t)(esp_timer_get_time() - slot->queued_us));
+        }
+
+#if CONFIG_AUDIO_UPLINK_CODEC_IMA_ADPCM
+        if (len == 0) {
+            uplink_flush();//闸门关闭，一段语音结束
+        } else {
+            uplink_encode(header, (const int16_t *)payload, len / sizeof(int16_t));
+        }
+#else
+        if (len > 0) {
+            uplink_send(header, payload, len);
+        }
+#endif
+
+        slot_drop_ref(slot);
+        xQueueSend(free_queue, &slot, 0);
+    }
+}
+
+//启动上行发送任务
+esp_err_t audio_uplink_start(void)
+{
+    //编码和发送都和网络放在同一个核，不占用音频核
+    if (xTaskCreatePinnedToCore(uplink_task, "audio uplink", UPLINK_TASK_DEPTH, NULL, UPLINK_TASK_PRI, NULL,
+                                NET_TASK_CORE) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+//获取上行统计
+void audio_uplink_get_stats(audio_uplink_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,43 @@
+#ifndef __AUDIO_UPLINK_H_
+#define __AUDIO_UPLINK_H_
+
+#include "audio_pipeline.h"
+#include "audio_packet.h"
+#include "audio_codec.h"
+
+//发送队列长度，网络跟不上时从最旧的开始丢
+#define AUDIO_UPLINK_QUEUE_LEN CONFIG_AUDIO_UPLINK_QUEUE_LEN
+
+#if CONFIG_AUDIO_UPLINK_CODEC_IMA_ADPCM
+//编码后按固定时长打包，一包AUDIO_UPLINK_PACKET_MS毫秒
+#define AUDIO_UPLINK_CODEC AUDIO_CODEC_IMA_ADPCM
+#define AUDIO_UPLINK_PACKET_MS CONFIG_AUDIO_UPLINK_PACKET_MS
+#else
+//不编码，每个采集帧一包
+#define AUDIO_UPLINK_CODEC AUDIO_CODEC_PCM
+#endif
+
+//上行统计
+typedef struct {
+    uint32_t queued;        //入队帧数
+    uint32_t sent;          //发送成功帧数
+    uint32_t dropped;       //队列满时丢弃的最旧帧数
+    uint32_t disconnected;  //未连接时丢弃的帧数
+    uint32_t send_errors;   //发送失败次数
+    uint32_t encoded;       //编码的包数
+    uint32_t encode_cycles;     //最近一包的编码耗时（CPU周期）
+    uint32_t encode_cycles_max; //编码耗时的最大值
+    uint64_t bytes_sent;    //发送的音频数据字节数，不含帧头
+    uint32_t gated;         //闸门关闭期间没有发送的帧数（超出预录长度后丢弃）
+} audio_uplink_stats_t;
+
+esp_err_t audio_uplink_init(size_t max_payload);
+esp_err_t audio_uplink_start(void);
+esp_err_t audio_uplink_push(const audio_frame_t *frame);
+esp_err_t audio_uplink_push_ref(const audio_frame_t *frame);
+bool audio_uplink_ref_busy(void);
+void audio_uplink_set_gate(bool open, size_t preroll_frames);
+esp_err_t audio_uplink_open_ref(const audio_frame_t *preroll, int64_t until_us);
+void audio_uplink_get_stats(audio_uplink_stats_t *stats);
+
+#endif
@@ -1,11 +1,54 @@
 #include "websocket_client.h"
+#include "sdkconfig.h"
+#if CONFIG_AUDIO_SPK_DOWNLINK
+#include "audio_downlink.h"
+#endif
+#include "audio_trace.h"
+#include "audio_pipeline.h"
+#include "audio_cpu.h"
+#include "audio_chain.h"
+#include <string.h>
 
 #define TAG  "websocket_client"
 
 #define SERVICE_URI   "ws://192.168.2.247:6006/ws"
 
+#define REPLY_SIZE 2048
+
 esp_websocket_client_handle_t ws_client = NULL;//websocket连接句柄
 
+//服务器发来的文本命令："trace"回复各测量点的延迟分布，"trace reset"清空统计
+//"stats"回复流水线和I2S的丢帧计数，"profile <名字>"切换DMA档位
+//"cpu"回复各任务从上次查询到现在的CPU占用和所在的核，"chain"回复处理链各级的CPU周期
+static void websocket_on_text(const esp_websocket_event_data_t *data)
+{
+    static char reply[REPLY_SIZE];
+
+    if (data->payload_offset != 0 || data->data_len != data->payload_len) {
+        return;
+    }
+    if (data->data_len == 5 && memcmp(data->data_ptr, "trace", 5) == 0) {
+        int len = audio_trace_format(reply, sizeof(reply));
+        esp_websocket_client_send_text(ws_client, reply, len, pdMS_TO_TICKS(100));
+    } else if (data->data_len == 5 && memcmp(data->data_ptr, "stats", 5) == 0) {
+        int len = audio_pipeline_format_stats(reply, sizeof(reply));
+        esp_websocket_client_send_text(ws_client, reply, len, pdMS_TO_TICKS(100));
+    } else if (data->data_len == 3 && memcmp(data->data_ptr, "cpu", 3) == 0) {
+        int len = audio_cpu_format(reply, sizeof(reply));
+        esp_websocket_client_send_text(ws_client, reply, len, pdMS_TO_TICKS(100));
+    } else if (data->data_len == 5 && memcmp(data->data_ptr, "chain", 5) == 0) {
+        int len = audio_chain_format_stats(reply, sizeof(reply));
+        esp_websocket_client_send_text(ws_client, reply, len, pdMS_TO_TICKS(100));
+    } else if (data->data_len > 8 && memcmp(data->data_ptr, "profile ", 8) == 0) {
+        int id = audio_pipeline_find_profile(data->data_ptr + 8, data->data_len - 8);
+        //重建I2S通道要等采集和播放停下，不能在事件回调里做，交给流水线的控制任务
+        esp_err_t ret = id < 0 ? ESP_ERR_NOT_FOUND : audio_pipeline_request_profile((audio_dma_profile_id_t)id);
+        ESP_LOGI(TAG, "请求切换DMA档位：%s", esp_err_to_name(ret));
+    } else if (data->data_len == 11 && memcmp(data->data_ptr, "trace reset", 11) == 0) {
+        audio_trace_reset();
+    }
+}
+
 //事件回调函数
 static void websocket_event_handler(void *handler_args, //注册回调时传入的参数
                                     esp_event_base_t base, //事件的类别，websocket固定是WEBSOCKET_EVENT
@@ -20,7 +63,14 @@ static void websocket_event_handler(void *handler_args, //注册回调时传入
             ESP_LOGW("WS", "WebSocket disconnected");//连接断开
             break;
         case WEBSOCKET_EVENT_DATA://收到数据
-            ESP_LOGI("WS", "Received data from server");
+            ESP_LOGD("WS", "Received data from server");
+            if (((esp_websocket_event_data_t *)event_data)->op_code == WS_TRANSPORT_OPCODES_TEXT) {
+                websocket_on_text((esp_websocket_event_data_t *)event_data);//调试命令
+                break;
+            }
+#if CONFIG_AUDIO_SPK_DOWNLINK
+            audio_downlink_on_data((esp_websocket_event_data_t *)event_data);//服务器下发的语音
+#endif
             break;
         default:
             break;
@@ -35,6 +85,8 @@ void websocket_client_app_start(void)
         .uri = SERVICE_URI,
         .task_prio = 5,//任务优先级
         .task_stack = 4096,//任务的堆栈大小
+        .task_pinned = AUDIO_TASK_PINNED,//和Wi-Fi放在同一个核，网络突发不抢占音频任务
+        .task_core = NET_TASK_CORE,
         .buffer_size = 1024,//发送、接收缓冲区大小
         .disable_auto_reconnect = false,//自动重连
         .ping_interval_sec = 10//心跳间隔，客户端每隔10秒自动发送一个ping帧，服务器回复，用于检测连接是否还活着